@@ -0,0 +1,375 @@
+/**
+*			@file bench_NgoXmlMgr.cpp
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*
+*			Benchmarks of the XmlManagerBase hot paths over synthetic trees. The results are
+*			written as JSON so that runs can be compared :
+*			@code
+*			bench_NgoXmlMgr [--quick] [--filter name] [--out file.json]
+*			@endcode
+*/
+
+#include <xmlmgr/XmlManagerBase.h>
+#include <xmlmgr/XmlManagerGenerator.h>
+
+#include <libxml/tree.h>
+#include <libxml/parser.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+typedef std::chrono::steady_clock Clock;
+
+/** shape of a synthetic tree : width childrens per level, depth levels */
+struct TreeShape
+{
+    int depth;
+    int width;
+};
+
+struct BenchResult
+{
+    std::string name;
+    std::string params;
+    size_t iterations;
+    double nsPerOp;
+    double minNs;
+    double maxNs;
+};
+
+struct BenchOptions
+{
+    bool quick;
+    std::string filter;
+    std::string out;
+};
+
+std::vector<BenchResult> s_results;
+BenchOptions s_options;
+
+/* keeps the compiler from dropping the benchmarked calls */
+volatile double s_sink = 0.0;
+
+std::string Key(const char* prefix, int i)
+{
+    std::stringstream s;
+    s << prefix << i;
+    return s.str();
+}
+
+/** path of the leaf reached by always taking child i at every level */
+std::string LeafPath(const TreeShape& shape, int i)
+{
+    std::string path;
+    for ( int d = 0; d < shape.depth; ++d )
+        path += Key( "n" , ( i + d ) % shape.width ) + "/";
+    return path + "value";
+}
+
+/** fills root with width^depth subtrees, every leaf holding a value and an attribute */
+void BuildTree(xmlNode* root, const TreeShape& shape)
+{
+    XmlManagerBase* mgr = XmlManagerBase::Get();
+    std::vector<std::string> level( 1 , std::string() );
+    for ( int d = 0; d < shape.depth; ++d )
+    {
+        std::vector<std::string> next;
+        for ( size_t p = 0; p < level.size(); ++p )
+            for ( int w = 0; w < shape.width; ++w )
+                next.push_back( level[p] + Key( "n" , w ) + "/" );
+        level.swap( next );
+    }
+    for ( size_t i = 0; i < level.size(); ++i )
+    {
+        mgr->Write( level[i] + "value" , root , double(i) );
+        mgr->WriteAttribute( level[i] + "value" , root , "unit" , std::string("kg") , true );
+    }
+}
+
+std::string Params(const TreeShape& shape)
+{
+    std::stringstream s;
+    s << "{\"depth\":" << shape.depth << ",\"width\":" << shape.width << "}";
+    return s.str();
+}
+
+std::string Params(size_t length)
+{
+    std::stringstream s;
+    s << "{\"length\":" << length << "}";
+    return s.str();
+}
+
+/** runs op in samples of batch calls until the time budget is spent, reports per call times */
+template <class Op> void Run(const std::string& name, const std::string& params, size_t batch, Op op)
+{
+    if ( !s_options.filter.empty() && name.find( s_options.filter ) == std::string::npos )
+        return;
+
+    const double budget = s_options.quick ? 0.02 : 0.25;
+    const size_t minSamples = s_options.quick ? 3 : 10;
+
+    op();	// warm up
+
+    std::vector<double> samples;
+    double spent = 0.0;
+    while ( samples.size() < minSamples || spent < budget )
+    {
+        Clock::time_point start = Clock::now();
+        for ( size_t i = 0; i < batch; ++i )
+            op();
+        double seconds = std::chrono::duration<double>( Clock::now() - start ).count();
+        samples.push_back( seconds * 1e9 / batch );
+        spent += seconds;
+        if ( samples.size() >= 1000 )
+            break;
+    }
+
+    std::sort( samples.begin() , samples.end() );
+    BenchResult r;
+    r.name = name;
+    r.params = params;
+    r.iterations = samples.size() * batch;
+    r.nsPerOp = samples[samples.size() / 2];
+    r.minNs = samples.front();
+    r.maxNs = samples.back();
+    s_results.push_back( r );
+
+    fprintf( stderr , "%-24s %-36s %14.1f ns/op\n" , name.c_str() , params.c_str() , r.nsPerOp );
+}
+
+/* ------------------------------------------------------------------------------------------------------------------
+*  Benchmarks
+*  ------------------------------------------------------------------------------------------------------------------*/
+
+void BenchParseSave(const TreeShape& shape)
+{
+    xmlDoc* doc = XmlMgrNewDoc("1.0");
+    xmlNode* root = XmlMgrNewDocNode(doc, NULL, "root", NULL);
+    XmlMgrDocSetRootElement(doc, root);
+    BuildTree( root , shape );
+
+    xmlChar* text = NULL;
+    int size = 0;
+    xmlDocDumpMemory( doc , &text , &size );
+
+    Run( "parse" , Params( shape ) , 1 , [&]()
+    {
+        xmlDoc* parsed = xmlReadMemory( (const char*) text , size , NULL , NULL , 0 );
+        XmlMgrFreeDoc( parsed );
+    } );
+
+    Run( "save" , Params( shape ) , 1 , [&]()
+    {
+        s_sink += XmlMgrSaveFormatFileEnc( "bench_NgoXmlMgr.tmp.xml" , doc , "UTF-8" , 1 );
+    } );
+
+    remove( "bench_NgoXmlMgr.tmp.xml" );
+    xmlFree( text );
+    XmlMgrFreeDoc( doc );
+}
+
+/** parse and save of a document made by XmlMgrGenerate, the seed is fixed so runs compare */
+void BenchGenerated(size_t nodes)
+{
+    xmlDoc* doc = XmlMgrNewDoc("1.0");
+    xmlNode* root = XmlMgrNewDocNode(doc, NULL, "root", NULL);
+    XmlMgrDocSetRootElement(doc, root);
+
+    xmGeneratorOptions options = XmlMgrGeneratorDefaults( 42 );
+    options.depth = 5;
+    options.fanout = 16;
+    options.maxNodes = nodes;
+    XmlMgrGenerate( root , options );
+
+    xmlChar* text = NULL;
+    int size = 0;
+    xmlDocDumpMemory( doc , &text , &size );
+
+    std::stringstream params;
+    params << "{\"nodes\":" << nodes << ",\"seed\":" << options.seed << "}";
+
+    Run( "parse_generated" , params.str() , 1 , [&]()
+    {
+        xmlDoc* parsed = xmlReadMemory( (const char*) text , size , NULL , NULL , 0 );
+        XmlMgrFreeDoc( parsed );
+    } );
+
+    Run( "parse_generated_parallel" , params.str() , 1 , [&]()
+    {
+        xmlDoc* parsed = XmlMgrParseMemoryParallel( (const char*) text , size );
+        XmlMgrFreeDoc( parsed );
+    } );
+
+    Run( "save_generated" , params.str() , 1 , [&]()
+    {
+        s_sink += XmlMgrSaveFormatFileEnc( "bench_NgoXmlMgr.tmp.xml" , doc , "UTF-8" , 1 );
+    } );
+
+    Run( "save_generated_parallel" , params.str() , 1 , [&]()
+    {
+        s_sink += XmlMgrSaveParallelFileEnc( "bench_NgoXmlMgr.tmp.xml" , doc , "UTF-8" , 1 );
+    } );
+
+    remove( "bench_NgoXmlMgr.tmp.xml" );
+    xmlFree( text );
+    XmlMgrFreeDoc( doc );
+}
+
+void BenchScalars(const TreeShape& shape)
+{
+    XmlManagerBase* mgr = XmlManagerBase::Get();
+    xmlDoc* doc = XmlMgrNewDoc("1.0");
+    xmlNode* root = XmlMgrNewDocNode(doc, NULL, "root", NULL);
+    XmlMgrDocSetRootElement(doc, root);
+    BuildTree( root , shape );
+
+    std::vector<std::string> paths;
+    for ( int i = 0; i < 64; ++i )
+        paths.push_back( LeafPath( shape , i ) );
+    size_t i = 0;
+
+    Run( "scalar_read" , Params( shape ) , 256 , [&]()
+    {
+        s_sink += mgr->ReadDouble( paths[i++ % paths.size()] , root );
+    } );
+
+    Run( "scalar_write" , Params( shape ) , 256 , [&]()
+    {
+        mgr->Write( paths[i % paths.size()] , root , double(i) );
+        ++i;
+    } );
+
+    Run( "attribute_read" , Params( shape ) , 256 , [&]()
+    {
+        s_sink += mgr->ReadAttribute( paths[i++ % paths.size()] , root , "unit" ).size();
+    } );
+
+    Run( "attribute_write" , Params( shape ) , 256 , [&]()
+    {
+        mgr->WriteAttribute( paths[i % paths.size()] , root , "unit" , std::string( ( i & 1 ) ? "kg" : "g" ) , true );
+        ++i;
+    } );
+
+    std::string parent = paths[0].substr( 0 , paths[0].find( '/' ) );
+    Run( "enumerate_childrens" , Params( shape ) , 64 , [&]()
+    {
+        s_sink += mgr->EnumerateChildrens( parent , root ).size();
+    } );
+
+    XmlMgrFreeDoc( doc );
+}
+
+void BenchArrays(size_t length)
+{
+    XmlManagerBase* mgr = XmlManagerBase::Get();
+    xmlDoc* doc = XmlMgrNewDoc("1.0");
+    xmlNode* root = XmlMgrNewDocNode(doc, NULL, "root", NULL);
+    XmlMgrDocSetRootElement(doc, root);
+
+    std::vector<double> values( length );
+    for ( size_t i = 0; i < length; ++i )
+        values[i] = i * 0.5;
+    std::vector<int> ints( length , 7 );
+
+    size_t batch = std::max<size_t>( 1 , 10000 / length );
+
+    Run( "array_write_double" , Params( length ) , batch , [&]()
+    {
+        mgr->Write( "arrays/d" , root , values );
+    } );
+
+    Run( "array_read_double" , Params( length ) , batch , [&]()
+    {
+        s_sink += mgr->ReadStdArrayDouble( "arrays/d" , root ).size();
+    } );
+
+    Run( "array_write_int" , Params( length ) , batch , [&]()
+    {
+        mgr->Write( "arrays/i" , root , ints );
+    } );
+
+    Run( "array_read_int" , Params( length ) , batch , [&]()
+    {
+        s_sink += mgr->ReadStdArrayInt( "arrays/i" , root ).size();
+    } );
+
+    XmlMgrFreeDoc( doc );
+}
+
+void WriteJson(FILE* out)
+{
+    fprintf( out , "{\n  \"library\": \"NgoXmlMgr\",\n  \"libxml\": \"%s\",\n  \"quick\": %s,\n  \"results\": [\n" ,
+             LIBXML_DOTTED_VERSION , s_options.quick ? "true" : "false" );
+    for ( size_t i = 0; i < s_results.size(); ++i )
+    {
+        const BenchResult& r = s_results[i];
+        fprintf( out , "    {\"name\": \"%s\", \"params\": %s, \"iterations\": %lu, \"ns_per_op\": %.1f, \"min_ns\": %.1f, \"max_ns\": %.1f}%s\n" ,
+                 r.name.c_str() , r.params.c_str() , (unsigned long) r.iterations , r.nsPerOp , r.minNs , r.maxNs ,
+                 i + 1 < s_results.size() ? "," : "" );
+    }
+    fprintf( out , "  ]\n}\n" );
+}
+
+} // end of anonymous namespace
+
+int main(int argc, char** argv)
+{
+    s_options.quick = false;
+    for ( int i = 1; i < argc; ++i )
+    {
+        if ( strcmp( argv[i] , "--quick" ) == 0 )
+            s_options.quick = true;
+        else if ( strcmp( argv[i] , "--filter" ) == 0 && i + 1 < argc )
+            s_options.filter = argv[++i];
+        else if ( strcmp( argv[i] , "--out" ) == 0 && i + 1 < argc )
+            s_options.out = argv[++i];
+        else
+        {
+            fprintf( stderr , "usage: %s [--quick] [--filter name] [--out file.json]\n" , argv[0] );
+            return 1;
+        }
+    }
+
+    const TreeShape shapes[] = { { 2 , 8 } , { 4 , 4 } , { 8 , 2 } , { 2 , 64 } };
+    for ( size_t i = 0; i < sizeof( shapes ) / sizeof( shapes[0] ); ++i )
+    {
+        BenchParseSave( shapes[i] );
+        BenchScalars( shapes[i] );
+    }
+
+    const size_t nodes[] = { 10000 , 100000 };
+    for ( size_t i = 0; i < sizeof( nodes ) / sizeof( nodes[0] ); ++i )
+        if ( !s_options.quick || nodes[i] <= 10000 )
+            BenchGenerated( nodes[i] );
+
+    const size_t lengths[] = { 10 , 1000 , 100000 };
+    for ( size_t i = 0; i < sizeof( lengths ) / sizeof( lengths[0] ); ++i )
+        if ( !s_options.quick || lengths[i] <= 1000 )
+            BenchArrays( lengths[i] );
+
+    FILE* out = s_options.out.empty() ? stdout : fopen( s_options.out.c_str() , "w" );
+    if ( out == NULL )
+    {
+        fprintf( stderr , "cannot open %s\n" , s_options.out.c_str() );
+        return 1;
+    }
+    WriteJson( out );
+    if ( out != stdout )
+        fclose( out );
+    return 0;
+}
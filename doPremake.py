@@ -2,12 +2,12 @@
 import subprocess, sys, os, os.path
 toolsdir = os.environ['DirToolsRoot']
 premake = os.path.join(toolsdir,'premake')
-premake = os.path.join(premake,'premake4')
+premake = os.path.join(premake,'premake5')
 if 'win' in sys.platform:
    premake = premake + '.exe' 
-   target = 'vs2010'
+   target = 'vs2015'
 else:
-   target = 'codeblocks'
+   target = 'gmake'
 cmd = '%s %s'%(premake,target)
 subprocess.call(cmd)
 #raw_input()
\ No newline at end of file
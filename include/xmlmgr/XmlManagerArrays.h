@@ -0,0 +1,131 @@
+/**
+*			@file XmlManagerArrays.h
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*/
+
+#ifndef _XmlManagerArrays_h_
+#define _XmlManagerArrays_h_
+
+#include <xmlmgr/XmlManagerBase.h>
+
+#include <string>
+
+/**
+*		@class XmlManagerArrayRange
+*
+*		@brief Lazy view on the items of an array, returned by XmlManagerBase::ReadArrayRange
+*
+*		Nothing is decoded before it is asked for and the memory used does not depend on the
+*		length of the array. Items can be pulled one by one with the iterators, stopping whenever
+*		the caller has enough, or by chunks into a caller buffer with ReadChunk :
+*		@code
+*		XmlManagerArrayRange<double> values = mgr->ReadArrayRange<double>("profile/value", root);
+*		double buffer[256];
+*		size_t n;
+*		while ( ( n = values.ReadChunk(buffer, 256) ) > 0 )
+*		    Accumulate(buffer, n);
+*		@endcode
+*		The array node must not be modified while the range is used.
+*
+*		@author Nicolas Macherey (nm@graymat.fr)
+*		@date	31-Jan-2009
+*		@version 0.0.1
+*/
+template <class T> class XmlManagerArrayRange
+{
+public :
+    /** input iterator decoding the item it points to when dereferenced */
+    class const_iterator
+    {
+    public :
+        const_iterator() : m_range(NULL), m_node(NULL) {};
+
+        T operator*() const { return m_range->Decode( m_node ); };
+        const_iterator& operator++() { m_node = m_range->Next( m_node ); return *this; };
+        bool operator==(const const_iterator& o) const { return m_node == o.m_node; };
+        bool operator!=(const const_iterator& o) const { return m_node != o.m_node; };
+
+    private :
+        friend class XmlManagerArrayRange;
+        const_iterator(const XmlManagerArrayRange* range, xmlNode* node) : m_range(range), m_node(node) {};
+
+        const XmlManagerArrayRange* m_range;
+        xmlNode* m_node;
+    };
+
+    const_iterator begin() const { return const_iterator( this , Next( NULL ) ); };
+    const_iterator end() const { return const_iterator( this , NULL ); };
+
+    /** returns true if the array does not exist or has no item */
+    bool empty() const { return Next( NULL ) == NULL; };
+
+    /**
+    * @brief Decodes the next items of the array in a caller buffer
+    *
+    *	Successive calls continue where the previous one stopped.
+    *
+    *	@param buffer the buffer to fill
+    *	@param capacity number of values the buffer can hold
+    *
+    *	@return returns the number of values written, 0 once the array is exhausted
+    */
+    size_t ReadChunk(T* buffer, size_t capacity)
+    {
+        if ( !m_started )
+        {
+            m_cursor = Next( NULL );
+            m_started = true;
+        }
+
+        size_t count = 0;
+        while ( count < capacity && m_cursor != NULL )
+        {
+            buffer[count++] = Decode( m_cursor );
+            m_cursor = Next( m_cursor );
+        }
+        return count;
+    }
+
+    /** restarts ReadChunk from the first item */
+    void Rewind() { m_started = false; m_cursor = NULL; };
+
+private :
+    friend class XmlManagerBase;
+
+    XmlManagerArrayRange(XmlManagerBase* mgr, xmlNode* array, const std::string& item, const T& emptyValue)
+        : m_mgr(mgr), m_array(array), m_item(item), m_emptyValue(emptyValue), m_cursor(NULL), m_started(false) {};
+
+    xmlNode* Next(xmlNode* prev) const
+    {
+        return m_array != NULL ? m_mgr->NextArrayItem( m_array , prev , m_item ) : NULL;
+    }
+
+    T Decode(xmlNode* n) const
+    {
+        std::string scratch;
+        return m_mgr->DecodeItem( n , m_emptyValue , &scratch );
+    }
+
+    XmlManagerBase* m_mgr;
+    xmlNode* m_array;
+    std::string m_item;
+    T m_emptyValue;
+    xmlNode* m_cursor;
+    bool m_started;
+};
+
+template <class T>
+XmlManagerArrayRange<T> XmlManagerBase::ReadArrayRange(const std::string& name, xmlNode* rootNode, const T& emptyValue)
+{
+    std::string item;
+    xmlNode* e = FindArrayNode( name , rootNode , &item );
+    return XmlManagerArrayRange<T>( this , e , item , emptyValue );
+}
+
+#endif
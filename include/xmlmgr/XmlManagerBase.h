@@ -14,18 +14,34 @@
 
 #include <xmlmgr/XmlManagerExports.h>
 #include <xmlmgr/XmlManagerGlobals.h>
+#include <xmlmgr/XmlManagerVisitor.h>
+#include <xmlmgr/XmlManagerListener.h>
+#include <xmlmgr/XmlManagerQuery.h>
+#include <xmlmgr/XmlManagerChildren.h>
+#include <xmlmgr/XmlManagerPath.h>
+#include <xmlmgr/XmlManagerCodec.h>
+#include <xmlmgr/XmlManagerDiff.h>
+#include <xmlmgr/XmlManagerSave.h>
+#include <xmlmgr/XmlManagerStats.h>
+#include <xmlmgr/XmlManagerTrace.h>
 
 #include "ngocommon/NgoSingletonManager.h"
 
+#include <atomic>
+#include <condition_variable>
 #include <iostream>
 #include <vector>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 /* lib xml imports */
 
 typedef struct _xmlNode xmlNode;
 typedef struct _xmlDoc xmlDoc;
 typedef struct _xmlNs xmlNs;
+typedef struct _xmlXPathCompExpr xmlXPathCompExpr;
 
 /*! @brief wrapper to xmlParseFile
 parse an XML file and build a tree. Automatic support for ZLIB/Compress compressed document is provided by default if found at compile-time.
@@ -34,6 +50,26 @@ parse an XML file and build a tree. Automatic support for ZLIB/Compress compress
 */
 XMLMGR_IMPORT _xmlDoc * XmlMgrParseFile(const char * filename);
 
+/*! @brief parses a large XML file with several threads, the tree is the same as XmlMgrParseFile
+The file is read in memory and a quick scan of the markup cuts the content of the root element in
+slices of whole childrens. The slices are parsed concurrently and their childrens are moved under the
+root. As with xmlParseFile there is no dictionary, every node owns its strings and is moved as it is. Small files, compressed files, encodings
+other than UTF-8, documents with a DTD, roots holding text and malformed documents are parsed sequentially.
+@param filename the filename
+@param threads number of threads, 0 for the hardware concurrency
+@return the resulting document tree if the file was wellformed, NULL otherwise.
+*/
+XMLMGR_IMPORT _xmlDoc * XmlMgrParseFileParallel(const char * filename, unsigned int threads = 0);
+
+/*! @brief parses a large XML document in memory with several threads, see XmlMgrParseFileParallel
+@param buffer the document, it is not kept after the call
+@param size number of bytes
+@param url base url of the document, may be NULL
+@param threads number of threads, 0 for the hardware concurrency
+@return the resulting document tree if the document was wellformed, NULL otherwise.
+*/
+XMLMGR_IMPORT _xmlDoc * XmlMgrParseMemoryParallel(const char * buffer, size_t size, const char * url = NULL, unsigned int threads = 0);
+
 /*! @brief wrapper to xmlDocSaveFormatFileEnc
 Dump an XML document to a file or an URL.
 @param filename the filename or URL to output
@@ -50,7 +86,10 @@ Creates a new XML document
 @return a new document */
 XMLMGR_IMPORT _xmlDoc * XmlMgrNewDoc(const char * version);
 /*! @brief wrapper to xmlFreeDoc
-Free up all the structures used by a document, tree included.
+Free up all the structures used by a document, tree included. The nodes of the document kept for
+reuse by XmlManagerBase, its attribute indexes, its subscriptions and its journal are released too.
+Documents written through XmlManagerBase must be freed here and never with xmlFreeDoc directly :
+the manager would keep pointers to the freed nodes and hand them out again.
 @param cur pointer to the document */
 XMLMGR_IMPORT void XmlMgrFreeDoc(_xmlDoc * cur);
 /*! @brief wrapper to xmlNewDocNode
@@ -91,6 +130,13 @@ XMLMGR_IMPORT void XmlMgrFreeNode(_xmlNode * cur);
 *	XmlManager Imports
 *******************************************************************************************************************/
 class XmlManagerNumengoBase;
+template <class T> class XmlManagerArrayRange;
+template <class T, bool isBound> struct xmNodeIO;
+template <class S> struct xmStructWriter;
+
+/** default number of detached nodes kept for reuse per document, the recycling is off until
+    SetNodePoolLimit enables it */
+#define XM_NODE_POOL_LIMIT 0
 
 /**
 *		@class XmlManagerBase
@@ -107,6 +153,9 @@ class XMLMGR_IMPORT XmlManagerBase : public NgoSingleton<XmlManagerBase>
    /** Give our private members access to the NgoXmlManagerBase */
    friend class NgoSingleton<XmlManagerBase>;
    friend class NgoXmlManagerBase;
+   template <class T> friend class XmlManagerArrayRange;
+   template <class T, bool isBound> friend struct xmNodeIO;
+   template <class S> friend struct xmStructWriter;
 
 public :
     /*************************************************************************************************************************
@@ -119,17 +168,391 @@ public :
     */
     std::vector<std::string> EnumerateChildrens(const std::string& path, xmlNode* rootNode);
 
+    /** Returns the element childrens of the node given by the path, without copying their names
+    *  The path is resolved once, the childrens can be used directly as root node of the Read methods.
+    *  @param path path of the parent node from rootNode
+    *	 @param rootNode root node from which to start the path node find
+    *
+    *  @return returns the range of childrens, empty if the path does not exist
+    */
+    XmlManagerChildRange Children(const std::string& path, xmlNode* rootNode);
+
+    /** Returns the element childrens of the node given by a path literal
+    *  @param path path literal of the parent node (see xmPath)
+    *	 @param rootNode root node from which to start the path node find
+    */
+    XmlManagerChildRange Children(const xmPath& path, xmlNode* rootNode);
+
     /** Delete the node given by the path starting from root node
     *  @param strPath subpath to delete from rootNode
     *	 @param rootNode root node from which to start the path node find
     */
     void DeleteChildrens(const std::string& strPath, xmlNode *rootNode);
 
+    /** Visits every element node below the given path (the path node itself is not visited)
+    *  @param path path to visit from rootNode
+    *	 @param rootNode root node from which to start the path node find
+    *  @param visitor the callback called for each node, it only gets read access to the tree
+    *  @param mode xmVisitSequential keeps the document order, xmVisitParallel spreads the top level
+    *         childrens over a work-stealing pool when there are enough of them
+    *  @param threads number of workers in parallel mode, 0 means the hardware concurrency
+    */
+    void VisitChildrens(const std::string& path, xmlNode* rootNode, XmlManagerVisitor& visitor,
+                        xmVisitMode mode = xmVisitSequential, unsigned int threads = 0);
+
+    /** Returns the node given by the path starting from root node
+    *  @param name path/key of the node
+    *	 @param rootNode root node from which to start the path node find
+    *  @param create_unexisting Set to true if we want to create the node if it does not exist.
+    *
+    *  @return returns the node or NULL if it does not exist and is not created
+    */
+    xmlNode* GetNode(const std::string& name, xmlNode* rootNode, bool create_unexisting = false);
+
+    /** Returns the node given by a path literal starting from root node
+    *  Segments are compared in place with the node names, nothing is parsed nor allocated.
+    *  @param path path literal of the node (see xmPath)
+    *	 @param rootNode root node from which to start the path node find
+    *  @param create_unexisting Set to true if we want to create the node if it does not exist.
+    *
+    *  @return returns the node or NULL if it does not exist and is not created
+    */
+    xmlNode* GetNode(const xmPath& path, xmlNode* rootNode, bool create_unexisting = false);
+
+    /** Unlinks a node from its tree and frees it with all its childrens
+    *  When the recycling is enabled, the element and text nodes of the subtree are kept for reuse by the
+    *  next writes, see SetNodePoolLimit.
+    *  @param node the node to delete
+    */
+    void DeleteNode(xmlNode* node);
+
+    /** Merges the tree of source into target in one walk
+    *  Elements are matched by name and position, the k-th child of source with a given name goes to
+    *  the k-th child of target with that name and missing ones are appended, so arrays are merged
+    *  item by item. Attributes and leaf values of source replace the ones of target, nodes only in
+    *  target are left as they are. When target is journaled, its subtree is journaled after the
+    *  merge : if the record cannot be appended the merge stays in the tree (see OpenJournal).
+    *  @param source root of the tree to merge, left unchanged
+    *  @param target root of the tree receiving the merge
+    */
+    void Merge(xmlNode* source, xmlNode* target);
+
+    /** Merges several trees into target, from the first to the last, as successive Merge calls
+    *  The subscribers are called and target is journaled once, after the last source.
+    *  @param sources roots of the trees to merge, left unchanged
+    *  @param target root of the tree receiving the merge
+    */
+    void Merge(const std::vector<xmlNode*>& sources, xmlNode* target);
+
+    /*************************************************************************************************************************
+    *	Diff and patch
+    *************************************************************************************************************************/
+
+    /** Computes the changes turning the tree of from into the tree of to
+    *  Childrens are matched by name. A name repeated under a node is an array : leaf items give one
+    *  xmChangeSetArray, structured items one xmChangeSetNodes holding their xml.
+    *  @param from root of the old tree
+    *  @param to root of the new tree
+    *  @param changes receives the changes, appended
+    */
+    void Diff(xmlNode* from, xmlNode* to, xmChangeSet* changes);
+
+    /** Applies a change set in place
+    *  @param changes the changes, relative to rootNode
+    *  @param rootNode root node of the patched tree
+    */
+    void Patch(const xmChangeSet& changes, xmlNode* rootNode);
+
+    /** Stores a change set under a node, one change element per change, to be saved or sent
+    *  Like Merge, the subtree is journaled once written.
+    *  @param changes the changes to store
+    *  @param rootNode node receiving the change elements
+    */
+    void WriteChangeSet(const xmChangeSet& changes, xmlNode* rootNode);
+
+    /** Reads a change set stored by WriteChangeSet
+    *  @param rootNode node holding the change elements
+    *  @param changes receives the changes, appended
+    */
+    void ReadChangeSet(xmlNode* rootNode, xmChangeSet* changes);
+
+    /*************************************************************************************************************************
+    *	Change subscriptions
+    *************************************************************************************************************************/
+
+    /** Watches a node and its subtree, the listener is called after every write of XmlManagerBase
+    *  touching them (values, attributes, arrays, deletions, patches). A write costs nothing more
+    *  when there is no subscription at all.
+    *  @param path path of the watched node, NgoErrorInvalidArgument is thrown if it does not exist
+    *	 @param rootNode root node from which to start the path node find
+    *  @param listener the listener, it must outlive the subscription
+    *
+    *  @return returns the subscription id for Unsubscribe
+    */
+    size_t Subscribe(const std::string& path, xmlNode* rootNode, XmlManagerListener* listener);
+
+    /** Same as above with a dirty flag set to true on change instead of a callback
+    *  @param dirty the flag, the subscriber clears it when it has read the new values
+    */
+    size_t Subscribe(const std::string& path, xmlNode* rootNode, std::atomic<bool>* dirty);
+
+    /** Removes a subscription, ids of subscriptions already dropped are ignored
+    *  @param id the id returned by Subscribe
+    */
+    void Unsubscribe(size_t id);
+
+    /*************************************************************************************************************************
+    *	Write journal
+    *************************************************************************************************************************/
+
+    /** Starts journaling the writes done on a document
+    *  Every write of XmlManagerBase on the tree of doc appends one line (type, path, value) to the
+    *  journal file, so that persisting a change does not rewrite the whole document. The paths are
+    *  relative to the root element of doc, an element having siblings of the same name is designated
+    *  by its position ("item[2]"). Replay a journal before opening it for writing. A write whose
+    *  record cannot be appended throws and closes the journal. The tree is left unchanged for the
+    *  writes whose record is built before the write (values, attributes, arrays, deletions, patches);
+    *  WriteStruct, Merge and WriteChangeSet journal their subtree once written and keep their write.
+    *  @param doc the journaled document
+    *  @param journalFile the journal, appended to if it exists
+    */
+    void OpenJournal(xmlDoc* doc, const std::string& journalFile);
+
+    /** Stops journaling a document, waiting for its compaction if one is running
+    *  @param doc the journaled document
+    */
+    void CloseJournal(xmlDoc* doc);
+
+    /** Applies the records of a journal to a document
+    *  @param doc the document, loaded from the base file of the journal
+    *  @param journalFile the journal, a missing file is an empty journal
+    *
+    *  @return returns the number of applied records
+    */
+    size_t ReplayJournal(xmlDoc* doc, const std::string& journalFile);
+
+    /** Loads a journaled document : parses the base file and replays the journals left by an
+    *  interrupted compaction and then the journal itself
+    *  @param file the base file
+    *  @param journalFile the journal
+    *
+    *  @return returns the document, NULL if the base file cannot be parsed
+    */
+    xmlDoc* LoadJournaledDoc(const std::string& file, const std::string& journalFile);
+
+    /** Folds the journal into a fresh save of the document, in the background
+    *  The tree is copied and the journal rotated to journalFile.old before returning, the copy is
+    *  then saved to file by a worker thread, which removes the rotated journal once the save is
+    *  complete. Writes go on meanwhile in the new journal.
+    *  @param doc the journaled document
+    *  @param file the base file to rewrite
+    */
+    void CompactJournal(xmlDoc* doc, const std::string& file);
+
+    /** Waits for the running compaction of a document
+    *  @param doc the journaled document
+    *
+    *  @return returns false if the last compaction failed to save the document, its journal is
+    *  then kept and replayed by LoadJournaledDoc
+    */
+    bool WaitJournalCompaction(xmlDoc* doc);
+
+    /*************************************************************************************************************************
+    *	Atomic saves
+    *************************************************************************************************************************/
+
+    /** Saves a document without ever leaving a partial file behind
+    *  The document is written to a temporary file next to filename, which is synced and renamed
+    *  over filename. Saves running at the same time in several threads share their fsync rounds :
+    *  the first thread to commit syncs the files of all the waiting saves (group commit).
+    *  @param doc the document to save
+    *  @param filename the target file
+    *  @param result if not NULL, receives the size and the latencies of the save
+    *  @param encoding the name of the encoding to use
+    *  @param format should formatting spaces be added
+    *
+    *  @return returns the number of bytes written or -1 in case of error, filename is then unchanged
+    */
+    int SaveAtomic(xmlDoc* doc, const std::string& filename, xmSaveResult* result = NULL,
+                   const char* encoding = "UTF-8", int format = 1);
+
+    /** Saves a batch of documents with a single fsync round, see above
+    *  @param jobs the documents and their target files, the results are filled in
+    *  @param encoding the name of the encoding to use
+    *  @param format should formatting spaces be added
+    *
+    *  @return returns false if one of the saves failed
+    */
+    bool SaveAtomic(std::vector<xmSaveJob>& jobs, const char* encoding = "UTF-8", int format = 1);
+
+    /** Sets how long the thread leading a group commit waits for other saves before syncing
+    *  @param microseconds the window, 0 (the default) only groups the saves already waiting
+    */
+    void SetSaveGroupWindow(unsigned int microseconds);
+
+    /*************************************************************************************************************************
+    *	Node recycling
+    *************************************************************************************************************************/
+
+    /** Sets the number of deleted nodes kept for reuse per document, the nodes deleted beyond are freed
+    *  The recycling is off by default. The pools are kept by document until XmlMgrFreeDoc releases
+    *  them, so enable it only if every document written through XmlManagerBase is freed with
+    *  XmlMgrFreeDoc and never with xmlFreeDoc.
+    *  @param limit the high-water mark, 0 disables the recycling
+    */
+    void SetNodePoolLimit(size_t limit);
+
+    /** Frees the recycled nodes of a document
+    *  @param doc the document, NULL for all the documents
+    *  @param keep number of nodes left in each pool
+    */
+    void TrimNodePool(xmlDoc* doc = NULL, size_t keep = 0);
+
+    /** Returns the number of nodes kept for reuse for a document */
+    size_t GetNodePoolSize(xmlDoc* doc);
+
+    /** Forgets everything kept about a document before it is freed, its recycled nodes, its
+    *  attribute indexes, its subscriptions and its journal. XmlMgrFreeDoc calls it.
+    *  @param doc the document about to be freed
+    */
+    void ReleaseDocument(xmlDoc* doc);
+
+    /** Returns true if the manager has been created, XmlMgrFreeDoc does not create it */
+    static bool IsCreated();
+
+    /*************************************************************************************************************************
+    *	Instrumentation
+    *************************************************************************************************************************/
+
+    /** Turns the counters on or off, they are off by default and then cost one test per call
+    *  The counters are kept per thread, call counts and latency histograms of the entry points,
+    *  sibling scans of the path lookups, created nodes and copied contents, see xmStats.
+    *  @param enable true to count
+    */
+    void EnableStats(bool enable);
+
+    /** Returns true if the counters are on */
+    bool IsStatsEnabled() const { return Counting(); }
+
+    /** Fills stats with the counters summed over all the threads, threads still counting may be
+    *  caught in the middle of a call
+    *  @param stats the snapshot to fill
+    */
+    void GetStats(xmStats* stats);
+
+    /** Sets all the counters to zero */
+    void ResetStats();
+
+    /** Turns the lookup profile on or off
+    *  While it is on, every path lookup or attribute search that scans at least minSiblings siblings
+    *  is recorded under its parent node and queried name, with the number of siblings visited. The
+    *  profile is meant for diagnostic runs, recording a lookup takes a lock.
+    *  @param enable true to profile
+    *  @param minSiblings scans shorter than this are not recorded
+    */
+    void EnableLookupProfile(bool enable, size_t minSiblings = XM_PROFILE_MIN_SIBLINGS);
+
+    /** Returns true if the lookup profile is on */
+    bool IsLookupProfileEnabled() const { return Profiling(); }
+
+    /** Returns the recorded lookups, the most siblings visited first
+    *  @param top maximum number of entries returned, 0 for all
+    */
+    std::vector<xmLookupProfile> GetLookupProfile(size_t top = 0);
+
+    /** Writes the top offenders of the lookup profile with their suggested change
+    *  @param out the stream to write to
+    *  @param top maximum number of entries written
+    */
+    void WriteLookupReport(std::ostream& out, size_t top = 20);
+
+    /** Forgets the recorded lookups */
+    void ResetLookupProfile();
+
+    /** Turns the trace spans on or off, see XmlManagerTraceSpan
+    *  Parsing, saving, array reads and writes and the batch operations (atomic saves, merge, diff,
+    *  patch, journal replay and compaction, parallel visits) record a span per call in a ring of
+    *  the calling thread.
+    *  @param enable true to trace
+    *  @param capacity number of spans kept per thread, for the threads starting to trace
+    */
+    void EnableTrace(bool enable, size_t capacity = XM_TRACE_CAPACITY);
+
+    /** Returns true if the trace spans are on */
+    bool IsTraceEnabled() const;
+
+    /** Writes the recorded spans as Chrome trace events, loadable in chrome://tracing or Perfetto
+    *  @param out the stream to write to
+    *
+    *  @return returns the number of spans written
+    */
+    size_t WriteTrace(std::ostream& out);
+
+    /** Writes the recorded spans as Chrome trace events in a file
+    *  @param filename the json file to write
+    *
+    *  @return returns false if the file could not be written
+    */
+    bool WriteTrace(const std::string& filename);
+
+    /** Forgets the recorded spans */
+    void ClearTrace();
+
+    /*************************************************************************************************************************
+    *	XPath queries
+    *************************************************************************************************************************/
+
+    /** Evaluates an xpath expression with rootNode as context node
+    *  Compiled expressions are kept in a cache indexed by the expression string, so that running
+    *  the same query again only costs its evaluation.
+    *  @param xpath the xpath expression, relative paths are evaluated from rootNode
+    *	 @param rootNode context node of the evaluation
+    *
+    *	 @return returns the matching nodes, empty if the expression does not evaluate to a node set
+    */
+    XmlManagerQueryResult Query(const std::string& xpath, xmlNode* rootNode);
+
+    /** Frees all the compiled expressions kept by Query */
+    void ClearQueryCache();
+
+    /*************************************************************************************************************************
+    *	Attribute indexes
+    *************************************************************************************************************************/
+
+    /** Declares an index on an attribute of the direct childrens of a path
+    *  The index maps each attribute value to its node. It is kept up to date by WriteAttribute and by
+    *  the methods deleting nodes, and it is dropped when its path node is deleted or when the document
+    *  is freed with XmlMgrFreeDoc. Nodes changed or freed directly with libxml are not tracked.
+    *  @param path path of the parent node, created if it does not exist
+    *	 @param rootNode root node from which to start the path node find
+    *  @param attribute name of the indexed attribute
+    */
+    void CreateAttributeIndex(const std::string& path, xmlNode* rootNode, const std::string& attribute);
+
+    /** Removes an index declared with CreateAttributeIndex
+    *  @param path path of the parent node
+    *	 @param rootNode root node from which to start the path node find
+    *  @param attribute name of the indexed attribute
+    */
+    void DropAttributeIndex(const std::string& path, xmlNode* rootNode, const std::string& attribute);
+
+    /** Finds the child of path whose attribute has the given value
+    *  The lookup goes through the index if one is declared, else the childrens are scanned.
+    *  When several childrens share the value any of them may be returned.
+    *  @param path path of the parent node
+    *	 @param rootNode root node from which to start the path node find
+    *  @param attribute name of the attribute
+    *  @param value the searched value
+    *
+    *  @return returns the found node or NULL
+    */
+    xmlNode* FindByAttribute(const std::string& path, xmlNode* rootNode, const std::string& attribute, const std::string& value);
+
     /*************************************************************************************************************************
     *	Clearing and Deleting
     *************************************************************************************************************************/
     /**
-    *		Clear the given node it means replace this node by NULL in the tree node
+    *		Clear the given node it means delete all its childrens, see DeleteNode
     */
     void Clear( xmlNode* node );
 
@@ -138,6 +561,186 @@ public :
     */
     void Delete( xmlDoc* doc );
 
+    /*************************************************************************************************************************
+    *	Typed access engine
+    *
+    *	All the typed Read/Write methods below go through these templates. A value is converted by xmCodec<T>
+    *	(see XmlManagerCodec.h), specializing xmCodec for one of your own types makes it readable and writable
+    *	as a value, an array or an attribute.
+    *************************************************************************************************************************/
+
+    /**
+    * @brief Read method for reading a value from a node given by its name path/key
+    *
+    *	@param name path/key string from which to read the value
+    *	@param rootNode root node from which to read
+    *	@param value pointer to the value to fill
+    *
+    *	@return returns true if the node exists, is not empty and has been decoded
+    */
+    template <class T> bool ReadValue(const std::string& name, xmlNode* rootNode, T* value)
+    {
+        StatsScope scope( this , xmStatsReadValue );
+        return DecodeNode( FindValueNode( name , rootNode ) , value );
+    }
+
+    /**
+    * @brief Write method for writing a value to a node given by its name path/key
+    *
+    *	@param name path/key string in which to write the value
+    *	@param rootNode root node from which to write
+    *	@param value the value to write
+    */
+    template <class T> void WriteValue(const std::string& name, xmlNode* rootNode, const T& value)
+    {
+        StatsScope scope( this , xmStatsWriteValue );
+        EncodeNode( AssertValueNode( name , rootNode ) , value );
+    }
+
+    /**
+    * @brief Read method for appending the items of an array given by its name path/key
+    *
+    *	The last segment of name is the name of the items, the rest is the path of the array node.
+    *
+    *	@param name path/key string from which to read the array
+    *	@param rootNode root node from which to read
+    *	@param array the vector to which the items are appended
+    *	@param emptyValue the value appended for an empty item
+    */
+    template <class T> void ReadArray(const std::string& name, xmlNode* rootNode, std::vector<T>* array, const T& emptyValue = T())
+    {
+        StatsScope scope( this , xmStatsReadArray );
+        XmlManagerTraceSpan span( "XmlManagerBase::ReadArray" );
+        std::string item;
+        xmlNode* e = FindArrayNode( name , rootNode , &item );
+        if ( e == NULL )
+            return;
+
+        array->reserve( array->size() + CountArrayItems( e , item ) );
+
+        std::string scratch;
+        for ( xmlNode* n = NextArrayItem( e , NULL , item ); n != NULL; n = NextArrayItem( e , n , item ) )
+            array->push_back( DecodeItem( n , emptyValue , &scratch ) );
+    }
+
+    /**
+    * @brief Read method for decoding the items of an array in a caller buffer
+    *
+    *	Items are decoded straight into the buffer, nothing is allocated per item. When the array is
+    *	longer than the buffer the remaining items are only counted.
+    *
+    *	@param name path/key string from which to read the array
+    *	@param rootNode root node from which to read
+    *	@param buffer the buffer to fill
+    *	@param capacity number of values the buffer can hold
+    *	@param total if not NULL, receives the number of items of the array, more than the returned
+    *	       value when the read has been truncated
+    *	@param emptyValue the value written for an empty item
+    *
+    *	@return returns the number of values written in buffer
+    */
+    template <class T> size_t ReadArray(const std::string& name, xmlNode* rootNode, T* buffer, size_t capacity,
+                                        size_t* total = NULL, const T& emptyValue = T())
+    {
+        StatsScope scope( this , xmStatsReadArray );
+        XmlManagerTraceSpan span( "XmlManagerBase::ReadArray" );
+        std::string item;
+        xmlNode* e = FindArrayNode( name , rootNode , &item );
+        return DecodeArrayItems( e , item , buffer , capacity , total , emptyValue );
+    }
+
+    /**
+    * @brief Read method for decoding the items of an array given by a path literal in a caller buffer
+    *
+    *	Same as above, the path resolution does not allocate either.
+    */
+    template <class T> size_t ReadArray(const xmPath& path, xmlNode* rootNode, T* buffer, size_t capacity,
+                                        size_t* total = NULL, const T& emptyValue = T())
+    {
+        StatsScope scope( this , xmStatsReadArray );
+        XmlManagerTraceSpan span( "XmlManagerBase::ReadArray" );
+        xmlNode* e = FindArrayNode( path , rootNode );
+        return DecodeArrayItems( e , path , buffer , capacity , total , emptyValue );
+    }
+
+    /**
+    * @brief Counts the items of an array given by its name path/key, to size a buffer
+    *
+    *	@param name path/key string of the array
+    *	@param rootNode root node from which to read
+    */
+    size_t CountArray(const std::string& name, xmlNode* rootNode);
+
+    /**
+    * @brief Counts the items of an array given by a path literal
+    */
+    size_t CountArray(const xmPath& path, xmlNode* rootNode);
+
+    /**
+    * @brief Write method for writing an array given by its name path/key, the previous items are replaced
+    *
+    *	The existing item nodes are rewritten in place, only the length difference is allocated or freed.
+    *
+    *	@param name path/key string in which to write the array
+    *	@param rootNode root node from which to write
+    *	@param array the items to write
+    */
+    template <class T> void WriteArray(const std::string& name, xmlNode* rootNode, const std::vector<T>& array)
+    {
+        StatsScope scope( this , xmStatsWriteArray );
+        XmlManagerTraceSpan span( "XmlManagerBase::WriteArray" );
+        std::string item;
+        WriteArrayItems( AssertArrayNode( name , rootNode , &item ) , item , array );
+    }
+
+    /**
+    * @brief Read method returning a lazy view on the items of an array given by its name path/key
+    *
+    *	Items are decoded on demand, see XmlManagerArrayRange.
+    *
+    *	@param name path/key string of the array, the last segment being the name of the items
+    *	@param rootNode root node from which to read
+    *	@param emptyValue the value returned for an empty item
+    */
+    template <class T> XmlManagerArrayRange<T> ReadArrayRange(const std::string& name, xmlNode* rootNode, const T& emptyValue = T());
+
+    /**
+    * @brief Read method for reading a value from a node attribute given by its name path/key
+    *
+    *	@param name path/key string of the node
+    *	@param rootNode root node from which to read
+    *	@param attribute the attribute's name
+    *	@param value pointer to the value to fill
+    *
+    *	@return returns true if the attribute exists and has been decoded
+    */
+    template <class T> bool ReadAttributeValue(const std::string& name, xmlNode* rootNode, const std::string& attribute, T* value)
+    {
+        StatsScope scope( this , xmStatsReadAttribute );
+        xmlNode* n = FindValueNode( name , rootNode );
+        if ( n == NULL )
+            return false;
+
+        std::string scratch;
+        const char* text = AttributeText( n , attribute , &scratch );
+        return text != NULL && xmCodec<T>::Decode( text , value );
+    }
+
+    /**
+    * @brief Write method for writing a value in a node attribute given by its name path/key
+    *
+    *	@param name path/key string of the node
+    *	@param rootNode root node from which to write
+    *	@param attribute the attribute's name
+    *	@param value the value to write
+    */
+    template <class T> void WriteAttributeValue(const std::string& name, xmlNode* rootNode, const std::string& attribute, const T& value)
+    {
+        StatsScope scope( this , xmStatsWriteAttribute );
+        char buffer[XM_CODEC_BUFFER_SIZE];
+        SetAttributeText( AssertValueNode( name , rootNode ) , attribute , xmCodec<T>::Encode( value , buffer ) );
+    }
+
     /*************************************************************************************************************************
     *	Standard String manipulation
     *************************************************************************************************************************/
@@ -404,6 +1007,66 @@ public :
     */
     std::vector<bool> ReadStdArrayBool(const std::string& name,xmlNode* rootNode);
 
+    /*************************************************************************************************************************
+    *	Bound structures manipulation
+    *************************************************************************************************************************/
+
+    /**
+    * @brief Read method for reading a structure bound with xmSchema (see XmlManagerBinding.h)
+    *
+    *	The structures of XmlManagerGlobals.h and their vectors are instantiated in the library,
+    *	other bound types need to include XmlManagerBinding.h.
+    *
+    *	@param name path/key of the structure node
+    *	@param rootNode root node from which to read
+    *	@param object the structure to fill, members without node are left untouched
+    *
+    *	@return returns true if the structure node has been found
+    */
+    template <class S> bool ReadStruct(const std::string& name, xmlNode* rootNode, S* object);
+
+    /**
+    * @brief Write method for writing a structure bound with xmSchema (see XmlManagerBinding.h)
+    *
+    *	Like Merge, the structure node is journaled once written.
+    *	@param name path/key of the structure node
+    *	@param rootNode root node from which to write
+    *	@param object the structure to write
+    */
+    template <class S> void WriteStruct(const std::string& name, xmlNode* rootNode, const S& object);
+
+    /*************************************************************************************************************************
+    *	Path literals manipulation
+    *************************************************************************************************************************/
+
+    /**
+    * @brief Read method for reading a value from a node given by a path literal
+    *
+    *	@param path path literal of the node (see xmPath)
+    *	@param rootNode root node from which to read
+    *	@param value pointer to the value to fill, its type needs an xmCodec
+    *
+    *	@return returns true if the value has been filled
+    */
+    template <class T> bool Read(const xmPath& path, xmlNode* rootNode, T* value)
+    {
+        StatsScope scope( this , xmStatsReadValue );
+        return DecodeNode( WalkPath( path , rootNode , false , path.Count() ) , value );
+    }
+
+    /**
+    * @brief Write method for writing a value to a node given by a path literal
+    *
+    *	@param path path literal of the node (see xmPath)
+    *	@param rootNode root node from which to write
+    *	@param value the value to write, its type needs an xmCodec
+    */
+    template <class T> void Write(const xmPath& path, xmlNode* rootNode, const T& value)
+    {
+        StatsScope scope( this , xmStatsWriteValue );
+        EncodeNode( WalkPath( path , rootNode , true , path.Count() ) , value );
+    }
+
 	/*************************************************************************************************************************
     *	Standard String Attributes manipulation
     *************************************************************************************************************************/
@@ -549,7 +1212,9 @@ protected :
     /**
     * Default constructor the one you cannot use
     */
-    XmlManagerBase(){};
+    XmlManagerBase() : m_subscriptionCount( 0 ), m_nextSubscription( 1 ), m_journalCount( 0 ),
+                       m_commitRunning( false ), m_commitWindow( 0 ), m_nodePoolLimit( XM_NODE_POOL_LIMIT ),
+                       m_statsEnabled( false ), m_profileEnabled( false ), m_profileMinSiblings( XM_PROFILE_MIN_SIBLINGS ) {};
 
     /**
     * Default destructor the one you cannot use
@@ -599,13 +1264,470 @@ private :
     */
     void SetNodeText(xmlNode *n, const char* t);
 
+    /**
+    * 	@brief NodeText method is used to get the string content of a node
+    *
+    *		The common single text child is returned in place, else the content is copied in scratch.
+    *
+    *		@param n the node from which to get the text
+    *		@param scratch storage used when the content has to be assembled
+    */
+    const char* NodeText(xmlNode *n, std::string* scratch);
+
+    /**
+    *		@brief DecodeNode method converts the text of a node, returns false if n is NULL or empty
+    */
+    template <class T> bool DecodeNode(xmlNode* n, T* value)
+    {
+        if ( n == NULL )
+            return false;
+
+        std::string scratch;
+        const char* text = NodeText( n , &scratch );
+        return xmCodec<T>::Decode( text , value ) && *text != '\0';
+    }
+
+    /**
+    *		@brief DecodeItem method converts the text of an array item, emptyValue if it is empty
+    */
+    template <class T> T DecodeItem(xmlNode* n, const T& emptyValue, std::string* scratch)
+    {
+        const char* text = NodeText( n , scratch );
+        T value = emptyValue;
+        if ( *text != '\0' )
+            xmCodec<T>::Decode( text , &value );
+        return value;
+    }
+
+    /**
+    *		@brief DecodeArrayItems method decodes the items of array node e in a buffer and counts them
+    *
+    *		@param item the item name, a std::string or the last segment of an xmPath
+    */
+    template <class T, class Item> size_t DecodeArrayItems(xmlNode* e, const Item& item, T* buffer, size_t capacity,
+                                                           size_t* total, const T& emptyValue)
+    {
+        size_t count = 0;
+        size_t written = 0;
+
+        if ( e != NULL )
+        {
+            std::string scratch;
+            for ( xmlNode* n = NextArrayItem( e , NULL , item ); n != NULL; n = NextArrayItem( e , n , item ) )
+            {
+                if ( written < capacity )
+                    buffer[written++] = DecodeItem( n , emptyValue , &scratch );
+                ++count;
+            }
+        }
+
+        if ( total != NULL )
+            *total = count;
+        return written;
+    }
+
+    /**
+    *		@brief EncodeNode method sets the text of a node from a value
+    */
+    template <class T> void EncodeNode(xmlNode* n, const T& value)
+    {
+        char buffer[XM_CODEC_BUFFER_SIZE];
+        const char* text = xmCodec<T>::Encode( value , buffer );
+        if ( Journaling() )
+            JournalValue( n , xmChangeSetValue , NULL , text );
+        SetNodeText( n , text );
+        NotifyChange( n );
+    }
+
+    /**
+    *		@brief WriteArrayItems method stores the values in the items of an array node
+    *
+    *		Existing items are rewritten in place, missing ones are appended and the surplus is freed.
+    */
+    template <class T> void WriteArrayItems(xmlNode* e, const std::string& item, const std::vector<T>& array)
+    {
+        char buffer[XM_CODEC_BUFFER_SIZE];
+        if ( Journaling() )
+        {
+            std::vector<std::string> items( array.size() );
+            for ( size_t k = 0; k < array.size(); ++k )
+                items[k] = xmCodec<T>::Encode( array[k] , buffer );
+            JournalArray( e , item , items );
+        }
+
+        size_t i = 0;
+        xmlNode* n = NextArrayItem( e , NULL , item );
+
+        for ( ; i < array.size() && n != NULL; ++i, n = NextArrayItem( e , n , item ) )
+            RewriteArrayItem( n , xmCodec<T>::Encode( array[i] , buffer ) );
+
+        for ( ; i < array.size(); ++i )
+            AppendArrayItem( e , item , xmCodec<T>::Encode( array[i] , buffer ) );
+
+        DeleteArrayItems( e , n , item );
+        NotifyChange( e );
+    }
+
+    /**
+    *		@brief FindValueNode method returns the node of a path/key, NULL if it does not exist
+    */
+    xmlNode* FindValueNode(const std::string& name, xmlNode* rootNode);
+
+    /**
+    *		@brief AssertValueNode method returns the node of a path/key, created if it does not exist
+    */
+    xmlNode* AssertValueNode(const std::string& name, xmlNode* rootNode);
+
+    /**
+    *		@brief FindArrayNode method returns the array node of a path/key and the name of its items
+    */
+    xmlNode* FindArrayNode(const std::string& name, xmlNode* rootNode, std::string* item);
+
+    /**
+    *		@brief AssertArrayNode method returns the array node of a path/key and the name of its items,
+    *		the array node is created if it does not exist
+    */
+    xmlNode* AssertArrayNode(const std::string& name, xmlNode* rootNode, std::string* item);
+
+    /**
+    *		@brief NextArrayItem method returns the item following prev (the first one if prev is NULL)
+    */
+    xmlNode* NextArrayItem(xmlNode* e, xmlNode* prev, const std::string& item);
+
+    /**
+    *		@brief NextArrayItem method returns the item following prev, items being named by the last segment of path
+    */
+    xmlNode* NextArrayItem(xmlNode* e, xmlNode* prev, const xmPath& path);
+
+    /**
+    *		@brief FindArrayNode method returns the array node of a path literal, NULL if it does not exist
+    */
+    xmlNode* FindArrayNode(const xmPath& path, xmlNode* rootNode);
+
+    /**
+    *		@brief CountArrayItems method counts the items of an array node
+    */
+    size_t CountArrayItems(xmlNode* e, const std::string& item);
+
+    /**
+    *		@brief WalkPath method follows the first segments of a path literal from rootNode
+    *
+    *		@param segments number of segments to follow
+    */
+    xmlNode* WalkPath(const xmPath& path, xmlNode* rootNode, bool create_unexisting, size_t segments);
+
+    /**
+    *		@brief AppendArrayItem method adds an item node holding text at the end of an array node
+    */
+    void AppendArrayItem(xmlNode* e, const std::string& item, const char* text);
+
+    /**
+    *		@brief RewriteArrayItem method replaces the text of an existing item, reusing its text node
+    */
+    void RewriteArrayItem(xmlNode* n, const char* text);
+
+    /**
+    *		@brief DeleteArrayItems method frees the item n and all the items following it
+    */
+    void DeleteArrayItems(xmlNode* e, xmlNode* n, const std::string& item);
+
+    /**
+    *		@brief AttributeText method returns the value of an attribute, NULL if the node does not have it
+    */
+    const char* AttributeText(xmlNode* n, const std::string& attribute, std::string* scratch);
+
+    /**
+    *		@brief SetAttributeText method sets the value of an attribute and keeps the indexes up to date
+    */
+    void SetAttributeText(xmlNode* n, const std::string& attribute, const char* value);
+
     /**
     *		@brief Collapse method is used for collapsing paths
     *
     *		@param str the path string to collapse
     */
     inline void Collapse(std::string& str) const;
+
+    /**
+    *		@brief CompileQuery method returns the cached compiled form of an xpath expression
+    *
+    *		@param xpath the expression to compile
+    */
+    std::shared_ptr<xmlXPathCompExpr> CompileQuery(const std::string& xpath);
+
+    /** compiled xpath expressions indexed by their string */
+    std::map<std::string, std::shared_ptr<xmlXPathCompExpr> > m_queryCache;
+    /** protects m_queryCache */
+    std::mutex m_queryCacheLock;
+
+    /**
+    *		@brief IndexAttribute method updates the attribute indexes before an attribute of n changes
+    *
+    *		@param n the node whose attribute is written
+    *		@param attribute the attribute's name
+    *		@param value the new value of the attribute, NULL if the attribute is removed
+    */
+    void IndexAttribute(xmlNode* n, const std::string& attribute, const char* value);
+
+    /**
+    *		@brief UnindexNode method removes a subtree from the attribute indexes before it is detached
+    *
+    *		@param n the top node of the subtree
+    */
+    void UnindexNode(xmlNode* n);
+
+    /** drops every attribute index of a document */
+    void DropAttributeIndexes(xmlDoc* doc);
+
+    /** attribute value to node map */
+    typedef std::unordered_multimap<std::string, xmlNode*> AttributeIndex;
+    /** indexes of the childrens of a parent node by attribute name */
+    typedef std::map<std::string, AttributeIndex> NodeIndexes;
+    /** indexes by document then by parent node, ReleaseDocument drops those of a document at once */
+    std::map<xmlDoc*, std::map<xmlNode*, NodeIndexes> > m_attributeIndexes;
+    /** protects m_attributeIndexes */
+    std::mutex m_attributeIndexLock;
+
+    /**
+    *		@brief NewElement method returns an empty element named name for doc, recycled if possible
+    */
+    xmlNode* NewElement(xmlDoc* doc, const char* name);
+
+    /**
+    *		@brief NewText method returns a text node holding text for doc, recycled if possible
+    */
+    xmlNode* NewText(xmlDoc* doc, const char* text);
+
+    /**
+    *		@brief SetTextContent method replaces the content of a text node, its buffer is reused when large enough
+    */
+    void SetTextContent(xmlNode* t, const char* text);
+
+    /**
+    *		@brief ReleaseNode method gives a detached subtree to the pool of its document
+    */
+    void ReleaseNode(xmlNode* node);
+
+    /**
+    *		@brief ResolveChangePath method follows path[0,end) from rootNode, node names being used as they are
+    */
+    xmlNode* ResolveChangePath(xmlNode* rootNode, const std::string& path, size_t end, bool create_unexisting);
+
+    /**
+    *		@brief DeleteNamedChildrens method deletes the element childrens of e named name
+    */
+    void DeleteNamedChildrens(xmlNode* e, const char* name);
+
+    /**
+    *		@brief MergeTree method merges source into target without notifying nor journaling
+    *		@param merged receives the nodes of target touched by the merge, if not NULL
+    */
+    void MergeTree(xmlNode* source, xmlNode* target, std::vector<xmlNode*>* merged);
+
+    /**
+    *		@brief DetachNode method unlinks a subtree and recycles it, without notifying the subscribers
+    *		of its parent, the callers notify once for all the nodes they delete
+    */
+    void DetachNode(xmlNode* node);
+
+    /**
+    *		@brief NotifyChange method calls the subscribers of n and of its ancestors
+    */
+    void NotifyChange(xmlNode* n)
+    {
+        if ( m_subscriptionCount.load( std::memory_order_relaxed ) != 0 )
+            DispatchChange( n , true );
+    }
+
+    /**
+    *		@brief NotifyNode method calls the subscribers of n only, for the nodes rewritten inside a
+    *		subtree whose root is then notified with NotifyChange
+    */
+    void NotifyNode(xmlNode* n)
+    {
+        if ( m_subscriptionCount.load( std::memory_order_relaxed ) != 0 )
+            DispatchChange( n , false );
+    }
+
+    /**
+    *		@brief DispatchChange method is the slow path of NotifyChange and NotifyNode
+    */
+    void DispatchChange(xmlNode* n, bool ancestors);
+
+    /**
+    *		@brief DropSubscriptions method removes the subscriptions on the nodes of a subtree
+    *
+    *		@param fire if true the dropped subscribers are called with n as changed node
+    */
+    void DropSubscriptions(xmlNode* n, bool fire);
+
+    /** subscription on a node, either a listener or a dirty flag */
+    struct Subscription
+    {
+        size_t id;
+        XmlManagerListener* listener;
+        std::atomic<bool>* dirty;
+    };
+    std::unordered_multimap<xmlNode*, Subscription> m_subscriptions;
+    /** size of m_subscriptions, read without lock by the write paths */
+    std::atomic<size_t> m_subscriptionCount;
+    size_t m_nextSubscription;
+    /** protects m_subscriptions and m_nextSubscription */
+    std::mutex m_subscriptionLock;
+
+    /**
+    *		@brief Journaling method returns true if a document is journaled, the write paths skip the
+    *		journal calls otherwise
+    */
+    bool Journaling() const { return m_journalCount.load( std::memory_order_relaxed ) != 0; }
+
+    /**
+    *		@brief JournalChange method records a change whose path is relative to rootNode, the journal
+    *		is closed if the record cannot be appended
+    */
+    void JournalChange(xmlNode* rootNode, const xmChange& change);
+
+    /**
+    *		@brief JournalValue method records a value, attribute or clear change of node n
+    */
+    void JournalValue(xmlNode* n, xmChangeType type, const char* attribute, const char* value);
+
+    /**
+    *		@brief JournalArray method records the items named item of the array node e, items is emptied
+    */
+    void JournalArray(xmlNode* e, const std::string& item, std::vector<std::string>& items);
+
+    /**
+    *		@brief JournalDelete method records the deletion of node, called before it is detached
+    */
+    void JournalDelete(xmlNode* node);
+
+    /**
+    *		@brief JournalSubtree method records the whole content of n, for the writes touching a subtree
+    */
+    void JournalSubtree(xmlNode* n);
+
+    /** journal of a document, see XmlManagerJournal.cpp */
+    struct Journal;
+    std::map<xmlDoc*, Journal*> m_journals;
+    /** size of m_journals, read without lock by the write paths */
+    std::atomic<size_t> m_journalCount;
+    /** protects m_journals, the journal files and the compaction states */
+    std::mutex m_journalLock;
+    /** signaled when a compaction ends */
+    std::condition_variable m_journalIdle;
+
+    /**
+    *		@brief IdleJournal method waits until no compaction of doc runs and joins the last one
+    *		@return the journal of doc, end of m_journals if it is not journaled
+    */
+    std::map<xmlDoc*, Journal*>::iterator IdleJournal(std::unique_lock<std::mutex>& lock, xmlDoc* doc);
+
+    /**
+    *		@brief CommitFiles method makes temporary files durable and renames them over their targets,
+    *		grouping the fsyncs with the other threads committing at the same time
+    */
+    struct PendingCommit;
+    void CommitFiles(PendingCommit* commits, size_t count);
+
+    /**
+    *		@brief SyncRound method syncs a batch of files, renames them and syncs their directories
+    */
+    static void SyncRound(const std::vector<PendingCommit*>& batch);
+
+    /** files waiting for the next fsync round */
+    std::vector<PendingCommit*> m_commitQueue;
+    /** true while a thread runs the fsync rounds */
+    bool m_commitRunning;
+    unsigned int m_commitWindow;
+    /** protects the commit queue */
+    std::mutex m_commitLock;
+    std::condition_variable m_commitDone;
+
+    /** detached nodes of a document waiting to be reused */
+    struct NodePool
+    {
+        std::vector<xmlNode*> elements;
+        std::vector<xmlNode*> texts;
+    };
+    std::map<xmlDoc*, NodePool> m_nodePools;
+    /** high-water mark of each pool */
+    size_t m_nodePoolLimit;
+    /** protects m_nodePools */
+    std::mutex m_nodePoolLock;
+
+    /**
+    *		@brief Counting method returns true if the counters are on, the instrumented paths skip the
+    *		Record calls otherwise
+    */
+    bool Counting() const { return m_statsEnabled.load( std::memory_order_relaxed ); }
+
+    /**
+    *		@brief StatsClock method returns a monotonic time in nanoseconds
+    */
+    static unsigned long long StatsClock();
+
+    /**
+    *		@brief RecordCall method counts a call of an entry point and its duration
+    */
+    void RecordCall(xmStatsCall call, unsigned long long nanoseconds);
+
+    /**
+    *		@brief RecordScan method counts a sibling scan and the number of siblings it visited
+    */
+    void RecordScan(size_t siblings);
+
+    /**
+    *		@brief RecordNodes method counts allocated nodes
+    */
+    void RecordNodes(size_t count);
+
+    /**
+    *		@brief RecordContent method counts a content copied by xmlNodeGetContent
+    */
+    void RecordContent(size_t bytes);
+
+    /** counts and times an entry point for the lifetime of the scope when the counters are on */
+    class StatsScope
+    {
+    public :
+        StatsScope(XmlManagerBase* mgr, xmStatsCall call) :
+            m_mgr( mgr->Counting() ? mgr : NULL ), m_call( call ), m_start( m_mgr != NULL ? StatsClock() : 0 ) {};
+        ~StatsScope() { if ( m_mgr != NULL ) m_mgr->RecordCall( m_call , StatsClock() - m_start ); };
+    private :
+        XmlManagerBase* m_mgr;
+        xmStatsCall m_call;
+        unsigned long long m_start;
+    };
+
+    /** true while the counters are on */
+    std::atomic<bool> m_statsEnabled;
+
+    /**
+    *		@brief Profiling method returns true if the lookup profile is on
+    */
+    bool Profiling() const { return m_profileEnabled.load( std::memory_order_relaxed ); }
+
+    /**
+    *		@brief ProfileLookup method records a scan of the childrens of parent looking for name
+    *
+    *		@param parent the scanned node
+    *		@param name the queried name, length characters long
+    *		@param scanned number of siblings visited
+    *		@param found false if the lookup found nothing
+    *		@param attribute true for an attribute search, name being the attribute
+    */
+    void ProfileLookup(xmlNode* parent, const char* name, size_t length, size_t scanned, bool found, bool attribute);
+
+    /** true while the lookup profile is on */
+    std::atomic<bool> m_profileEnabled;
+    std::atomic<size_t> m_profileMinSiblings;
+    /** recorded lookups by parent path and queried name */
+    std::map<std::pair<std::string, std::string>, xmLookupProfile> m_lookups;
+    /** protects m_lookups */
+    std::mutex m_profileLock;
 };
 
+#include <xmlmgr/XmlManagerArrays.h>
 
 #endif
@@ -0,0 +1,329 @@
+/**
+*			@file XmlManagerBinding.h
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*/
+
+#ifndef _XmlManagerBinding_h_
+#define _XmlManagerBinding_h_
+
+#include <xmlmgr/XmlManagerBase.h>
+#include <xmlmgr/XmlManagerCodec.h>
+#include <xmlmgr/XmlManagerGlobals.h>
+
+#include <libxml/tree.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+/*******************************************************************************************************************
+*	Schema declarations
+*******************************************************************************************************************/
+
+/**
+*			@struct xmSchema
+*
+*			@brief Binds the members of a structure to xml element names
+*
+*			A bound structure specializes xmSchema with :
+*			- bound set to true
+*			- Item() giving the element name of the structure when it is stored in a vector
+*			- Fields(f) calling f(elementName, &Struct::member) once per member
+*
+*			Members are either types with an xmCodec, bound structures or std::vector of bound
+*			structures. Everything is resolved at compile time, reading or writing a structure walks the
+*			childrens of its node once.
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*/
+template <class T> struct xmSchema
+{
+    static const bool bound = false;
+};
+
+template <> struct xmSchema<xmNumengoReference>
+{
+    static const bool bound = true;
+    static const char* Item() { return "reference"; }
+    template <class F> static void Fields(F& f)
+    {
+        f( "name" , &xmNumengoReference::name );
+        f( "year" , &xmNumengoReference::year );
+        f( "month" , &xmNumengoReference::month );
+        f( "day" , &xmNumengoReference::day );
+        f( "source" , &xmNumengoReference::source );
+        f( "comment" , &xmNumengoReference::comment );
+    }
+};
+
+template <> struct xmSchema<xmLibrarySubSytem>
+{
+    static const bool bound = true;
+    static const char* Item() { return "subsystem"; }
+    template <class F> static void Fields(F& f)
+    {
+        f( "system_type" , &xmLibrarySubSytem::system_type );
+        f( "library_name" , &xmLibrarySubSytem::library_name );
+    }
+};
+
+template <> struct xmSchema<xmDynamicLibrary>
+{
+    static const bool bound = true;
+    static const char* Item() { return "library"; }
+    template <class F> static void Fields(F& f)
+    {
+        f( "constructor_node" , &xmDynamicLibrary::constructor_node );
+        f( "SubSystems" , &xmDynamicLibrary::SubSystems );
+    }
+};
+
+template <> struct xmSchema<xmValueUnit>
+{
+    static const bool bound = true;
+    static const char* Item() { return "quantity"; }
+    template <class F> static void Fields(F& f)
+    {
+        f( "value" , &xmValueUnit::value );
+        f( "units" , &xmValueUnit::units );
+    }
+};
+
+template <> struct xmSchema<xmTemperaturePressureDensity>
+{
+    static const bool bound = true;
+    static const char* Item() { return "state"; }
+    template <class F> static void Fields(F& f)
+    {
+        f( "temperature" , &xmTemperaturePressureDensity::temperature );
+        f( "pressure" , &xmTemperaturePressureDensity::pressure );
+        f( "density" , &xmTemperaturePressureDensity::density );
+    }
+};
+
+template <> struct xmSchema<xmElement>
+{
+    static const bool bound = true;
+    static const char* Item() { return "element"; }
+    template <class F> static void Fields(F& f)
+    {
+        f( "name" , &xmElement::name );
+        f( "num_of_atoms" , &xmElement::num_of_atoms );
+    }
+};
+
+/*******************************************************************************************************************
+*	Node level readers and writers
+*******************************************************************************************************************/
+
+/** returns true if n is an element named name */
+inline bool xmNodeIs(const xmlNode* n, const char* name)
+{
+    return n->type == XML_ELEMENT_NODE && strcmp( (const char*) n->name , name ) == 0;
+}
+
+template <class T, bool isBound = xmSchema<T>::bound> struct xmNodeIO;
+
+/** number of fields of a schema */
+struct xmFieldCounter
+{
+    size_t count;
+
+    template <class S, class T> void operator()(const char*, T S::*) { ++count; }
+};
+
+/** gives the first child of each field name, called for every element child of the structure node */
+template <class S> struct xmFieldLocator
+{
+    xmlNode* child;
+    xmlNode** slots;
+    size_t field;
+
+    template <class T> void operator()(const char* name, T S::*)
+    {
+        if ( slots[field] == NULL && strcmp( (const char*) child->name , name ) == 0 )
+            slots[field] = child;
+        ++field;
+    }
+};
+
+template <class S> struct xmStructReader
+{
+    XmlManagerBase* mgr;
+    xmlNode* child;
+    S* object;
+    bool done;
+
+    template <class T> void operator()(const char* name, T S::*member)
+    {
+        if ( !done && strcmp( (const char*) child->name , name ) == 0 )
+        {
+            xmNodeIO<T>::Read( *mgr , child , &(object->*member) );
+            done = true;
+        }
+    }
+};
+
+template <class S> struct xmStructWriter
+{
+    XmlManagerBase* mgr;
+    xmlNode* node;
+    xmlNode** slots;
+    size_t field;
+    const S* object;
+
+    template <class T> void operator()(const char* name, T S::*member)
+    {
+        xmlNode* child = slots[field++];
+        if ( child == NULL )
+            child = xmNodeIO<S>::AddField( *mgr , node , name );
+        xmNodeIO<T>::Write( *mgr , child , object->*member );
+        mgr->NotifyNode( child );
+    }
+};
+
+/** values with a codec are the text of their node */
+template <class T> struct xmNodeIO<T, false>
+{
+    static void Read(XmlManagerBase& mgr, xmlNode* n, T* value)
+    {
+        std::string scratch;
+        xmCodec<T>::Decode( mgr.NodeText( n , &scratch ) , value );
+    }
+    static void Write(XmlManagerBase& mgr, xmlNode* n, const T& value)
+    {
+        char buffer[XM_CODEC_BUFFER_SIZE];
+        mgr.SetNodeText( n , xmCodec<T>::Encode( value , buffer ) );
+    }
+};
+
+/** bound structures are read and written in one pass over the childrens of their node */
+template <class S> struct xmNodeIO<S, true>
+{
+    static void Read(XmlManagerBase& mgr, xmlNode* n, S* object)
+    {
+        for ( xmlNode* child = n->children; child != NULL; child = child->next )
+        {
+            if ( child->type != XML_ELEMENT_NODE )
+                continue;
+            xmStructReader<S> reader = { &mgr , child , object , false };
+            xmSchema<S>::Fields( reader );
+        }
+    }
+    static void Write(XmlManagerBase& mgr, xmlNode* n, const S& object)
+    {
+        xmFieldCounter counter = { 0 };
+        xmSchema<S>::Fields( counter );
+
+        /* the node of each field, found in the same pass, the missing ones are created after */
+        xmlNode* local[16];
+        std::vector<xmlNode*> heap;
+        xmlNode** slots = local;
+        if ( counter.count > 16 )
+        {
+            heap.resize( counter.count );
+            slots = &heap[0];
+        }
+        for ( size_t i = 0; i < counter.count; ++i )
+            slots[i] = NULL;
+
+        for ( xmlNode* child = n->children; child != NULL; child = child->next )
+        {
+            if ( child->type != XML_ELEMENT_NODE )
+                continue;
+            xmFieldLocator<S> locator = { child , slots , 0 };
+            xmSchema<S>::Fields( locator );
+        }
+
+        xmStructWriter<S> writer = { &mgr , n , slots , 0 , &object };
+        xmSchema<S>::Fields( writer );
+    }
+    /** appends the node of a field, recycled if possible */
+    static xmlNode* AddField(XmlManagerBase& mgr, xmlNode* n, const char* name)
+    {
+        return xmlAddChild( n , mgr.NewElement( n->doc , name ) );
+    }
+};
+
+/** vectors of bound structures are the Item() childrens of their node, existing items are
+    reused in place so that reading or writing the same size twice does not allocate */
+template <class S, class A> struct xmNodeIO<std::vector<S, A>, false>
+{
+    static void Read(XmlManagerBase& mgr, xmlNode* n, std::vector<S, A>* array)
+    {
+        const char* item = xmSchema<S>::Item();
+
+        size_t count = 0;
+        for ( xmlNode* child = n->children; child != NULL; child = child->next )
+            if ( xmNodeIs( child , item ) )
+                ++count;
+
+        array->resize( count );
+
+        size_t i = 0;
+        for ( xmlNode* child = n->children; child != NULL; child = child->next )
+            if ( xmNodeIs( child , item ) )
+                xmNodeIO<S>::Read( mgr , child , &(*array)[i++] );
+    }
+    static void Write(XmlManagerBase& mgr, xmlNode* n, const std::vector<S, A>& array)
+    {
+        const char* item = xmSchema<S>::Item();
+
+        /* the extra items are detached without journaling, WriteStruct journals the whole subtree */
+        size_t i = 0;
+        xmlNode* child = n->children;
+        while ( child != NULL )
+        {
+            xmlNode* next = child->next;
+            if ( xmNodeIs( child , item ) )
+            {
+                if ( i < array.size() )
+                {
+                    xmNodeIO<S>::Write( mgr , child , array[i++] );
+                    mgr.NotifyNode( child );
+                }
+                else
+                    mgr.DetachNode( child );
+            }
+            child = next;
+        }
+
+        for ( ; i < array.size(); ++i )
+            xmNodeIO<S>::Write( mgr , xmlAddChild( n , mgr.NewElement( n->doc , item ) ) , array[i] );
+    }
+};
+
+/*******************************************************************************************************************
+*	XmlManagerBase entry points
+*******************************************************************************************************************/
+
+template <class S>
+bool XmlManagerBase::ReadStruct(const std::string& name, xmlNode* rootNode, S* object)
+{
+    xmlNode* n = GetNode( name , rootNode , false );
+    if ( n == NULL )
+        return false;
+
+    xmNodeIO<S>::Read( *this , n , object );
+    return true;
+}
+
+template <class S>
+void XmlManagerBase::WriteStruct(const std::string& name, xmlNode* rootNode, const S& object)
+{
+    xmlNode* n = GetNode( name , rootNode , true );
+    xmNodeIO<S>::Write( *this , n , object );
+    NotifyChange( n );
+    if ( Journaling() )
+        JournalSubtree( n );
+}
+
+#endif
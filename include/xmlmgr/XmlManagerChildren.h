@@ -0,0 +1,92 @@
+/**
+*			@file XmlManagerChildren.h
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*/
+
+#ifndef _XmlManagerChildren_h_
+#define _XmlManagerChildren_h_
+
+#include <xmlmgr/XmlManagerExports.h>
+
+#include <cstddef>
+
+typedef struct _xmlNode xmlNode;
+
+/**
+*		@class XmlManagerChildIterator
+*
+*		@brief Forward iterator over the element childrens of a node
+*
+*		The iterator only holds the current node, names are borrowed from the tree and nodes
+*		are handed out as they are, they can be used as root node of the typed Read methods.
+*		Modifying the list of childrens invalidates the iterators pointing on removed nodes.
+*
+*		@author Nicolas Macherey (nm@graymat.fr)
+*		@date	31-Jan-2009
+*		@version 0.0.1
+*/
+class XMLMGR_IMPORT XmlManagerChildIterator
+{
+    friend class XmlManagerChildRange;
+
+public :
+    XmlManagerChildIterator() : m_node(NULL) {};
+
+    /** current child node */
+    xmlNode* operator*() const { return m_node; };
+    /** current child node */
+    xmlNode* Node() const { return m_node; };
+    /** name of the current child, owned by the tree */
+    const char* Name() const;
+
+    XmlManagerChildIterator& operator++();
+    XmlManagerChildIterator operator++(int) { XmlManagerChildIterator r(*this); ++(*this); return r; };
+    bool operator==(const XmlManagerChildIterator& o) const { return m_node == o.m_node; };
+    bool operator!=(const XmlManagerChildIterator& o) const { return m_node != o.m_node; };
+
+private :
+    /** positions the iterator on the first element node from n on */
+    explicit XmlManagerChildIterator(xmlNode* n);
+
+    xmlNode* m_node;
+};
+
+/**
+*		@class XmlManagerChildRange
+*
+*		@brief Element childrens of a node resolved once, returned by XmlManagerBase::Children
+*		@code
+*		for ( xmlNode* stream : mgr->Children("streams", root) )
+*		    total += mgr->ReadDouble("flow", stream);
+*		@endcode
+*
+*		@author Nicolas Macherey (nm@graymat.fr)
+*		@date	31-Jan-2009
+*		@version 0.0.1
+*/
+class XMLMGR_IMPORT XmlManagerChildRange
+{
+public :
+    typedef XmlManagerChildIterator const_iterator;
+
+    /** range of the childrens of parent, empty if parent is NULL */
+    explicit XmlManagerChildRange(xmlNode* parent = NULL);
+
+    const_iterator begin() const { return XmlManagerChildIterator(m_first); };
+    const_iterator end() const { return XmlManagerChildIterator(); };
+    /** returns true if there is no element child */
+    bool empty() const { return m_first == NULL; };
+    /** counts the element childrens, this walks the list */
+    size_t size() const;
+
+private :
+    xmlNode* m_first;
+};
+
+#endif
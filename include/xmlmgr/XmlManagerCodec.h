@@ -0,0 +1,137 @@
+/**
+*			@file XmlManagerCodec.h
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*/
+
+#ifndef _XmlManagerCodec_h_
+#define _XmlManagerCodec_h_
+
+#include <xmlmgr/XmlManagerGlobals.h>
+
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+/** size of the buffer handed to xmCodec<T>::Encode */
+#define XM_CODEC_BUFFER_SIZE 64
+
+/**
+*			@struct xmCodec
+*
+*			@brief Text conversion of the values stored in xml nodes
+*
+*			A codec provides two static methods :
+*			- bool Decode(const char* text, T* value) fills value from the node text, returns false
+*			  if the text cannot be converted
+*			- const char* Encode(const T& value, char* buffer) returns the text to store, either
+*			  written in buffer (XM_CODEC_BUFFER_SIZE chars) or pointing into value
+*
+*			There is no generic codec, a type without specialization does not compile.
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*/
+template <class T> struct xmCodec;
+
+/** returns true if text holds nothing but blanks */
+inline bool xmCodecBlank(const char* text)
+{
+    while ( *text == ' ' || *text == '\t' || *text == '\n' || *text == '\r' )
+        ++text;
+    return *text == '\0';
+}
+
+template <> struct xmCodec<std::string>
+{
+    static bool Decode(const char* text, std::string* value)
+    {
+        value->assign( text );
+        return true;
+    }
+    static const char* Encode(const std::string& value, char*)
+    {
+        return value.c_str();
+    }
+};
+
+template <> struct xmCodec<int>
+{
+    static bool Decode(const char* text, int* value)
+    {
+        char* end;
+        errno = 0;
+        long v = strtol( text , &end , 10 );
+        if ( end == text || errno == ERANGE || v < INT_MIN || v > INT_MAX )
+            return false;
+        *value = (int) v;
+        return true;
+    }
+    static const char* Encode(const int& value, char* buffer)
+    {
+        snprintf( buffer , XM_CODEC_BUFFER_SIZE , "%d" , value );
+        return buffer;
+    }
+};
+
+template <> struct xmCodec<double>
+{
+    static bool Decode(const char* text, double* value)
+    {
+        char* end;
+        double v = strtod( text , &end );
+        if ( end == text || NaN( v ) )
+            return false;
+        *value = v;
+        return true;
+    }
+    /* same output as a stream with precision(12) and std::scientific */
+    static const char* Encode(const double& value, char* buffer)
+    {
+        snprintf( buffer , XM_CODEC_BUFFER_SIZE , "%.12e" , value );
+        return buffer;
+    }
+};
+
+template <> struct xmCodec<bool>
+{
+    static bool Decode(const char* text, bool* value)
+    {
+        while ( *text == ' ' || *text == '\t' || *text == '\n' || *text == '\r' )
+            ++text;
+
+        /* the words are whole, "trueish" is not a boolean */
+        if ( strncmp( text , "true" , 4 ) == 0 && xmCodecBlank( text + 4 ) )
+        {
+            *value = true;
+            return true;
+        }
+        if ( strncmp( text , "false" , 5 ) == 0 && xmCodecBlank( text + 5 ) )
+        {
+            *value = false;
+            return true;
+        }
+
+        char* end;
+        long v = strtol( text , &end , 10 );
+        if ( end == text )
+            return false;
+        *value = ( v != 0 );
+        return true;
+    }
+    static const char* Encode(const bool& value, char*)
+    {
+        return value ? "1" : "0";
+    }
+};
+
+#endif
@@ -0,0 +1,67 @@
+/**
+*			@file XmlManagerDiff.h
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*/
+
+#ifndef _XmlManagerDiff_h_
+#define _XmlManagerDiff_h_
+
+#include <xmlmgr/XmlManagerExports.h>
+
+#include <string>
+#include <vector>
+
+/** kinds of changes produced by XmlManagerBase::Diff */
+enum xmChangeType
+{
+    xmChangeSetValue = 0,		/*!< sets the text of path, creating it if needed */
+    xmChangeSetAttribute,		/*!< sets attribute of path to value, creating path if needed */
+    xmChangeDeleteAttribute,	/*!< removes attribute from path */
+    xmChangeDelete,				/*!< deletes path with all its childrens */
+    xmChangeSetArray,			/*!< replaces the items of the array path (container/item) by items */
+    xmChangeSetNodes,			/*!< replaces the repeated structured childrens path by the xml fragment value */
+    xmChangeClear				/*!< deletes all the childrens of path */
+};
+
+/**
+*			@struct xmChange
+*
+*			@brief One change of a change set, paths are relative to the diffed roots and follow the
+*			unique name semantics of XmlManagerBase, node names being used as they are
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*/
+struct xmChange
+{
+		xmChangeType type;						/*!< kind of change */
+		std::string path;						/*!< path of the changed node */
+		std::string attribute;					/*!< attribute name for the attribute changes */
+		std::string value;						/*!< new text, attribute value or xml fragment */
+		std::vector<std::string> items;			/*!< new items of an array */
+};
+
+/** Define the change set of a diff */
+typedef std::vector< xmChange > xmChangeSet;
+
+/*! @brief name of a change type in the stored change sets and journals
+@param type the change type
+@return the name, NULL for an unknown type
+*/
+XMLMGR_IMPORT const char* XmlMgrChangeTypeName(xmChangeType type);
+
+/*! @brief change type of a name returned by XmlMgrChangeTypeName
+@param name the name
+@param type receives the change type
+@return false if the name is unknown
+*/
+XMLMGR_IMPORT bool XmlMgrChangeTypeFromName(const char* name, xmChangeType* type);
+
+#endif
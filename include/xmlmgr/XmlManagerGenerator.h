@@ -0,0 +1,77 @@
+/**
+*			@file XmlManagerGenerator.h
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*/
+
+#ifndef _XmlManagerGenerator_h_
+#define _XmlManagerGenerator_h_
+
+#include <xmlmgr/XmlManagerExports.h>
+
+#include <cstddef>
+
+typedef struct _xmlNode xmlNode;
+
+/**
+*			@struct xmGeneratorOptions
+*
+*			@brief Shape of a synthetic document built by XmlMgrGenerate
+*
+*			The same options and seed always give the same document, on every platform.
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*/
+struct xmGeneratorOptions
+{
+		unsigned long long seed;				/*!< seed of the pseudo random sequence */
+		unsigned int depth;						/*!< levels of nodes below the root, the last level holds the values */
+		unsigned int fanout;					/*!< mean number of childrens of a node */
+		double fanoutSpread;					/*!< the fanout of each node is drawn in fanout * [1 - spread, 1 + spread] */
+		unsigned int arrays;					/*!< arrays written in each node of the level above the values */
+		unsigned int arrayLength;				/*!< items of each array */
+		double attributeDensity;				/*!< mean number of attributes per node */
+		unsigned int names;						/*!< size of the name vocabulary, small values repeat the names */
+		size_t maxNodes;						/*!< no node is created beyond, 0 for no limit */
+};
+
+/**
+*			@struct xmGeneratorResult
+*
+*			@brief What XmlMgrGenerate has created
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*/
+struct xmGeneratorResult
+{
+		size_t elements;						/*!< element nodes, array items included */
+		size_t values;							/*!< nodes holding a scalar value */
+		size_t arrayItems;						/*!< items of the arrays */
+		size_t attributes;						/*!< attributes */
+};
+
+/*! @brief options of a small document, depth 3, fanout 8, a few arrays and attributes
+@param seed the seed of the document
+@return the options, to be adjusted before calling XmlMgrGenerate
+*/
+XMLMGR_IMPORT xmGeneratorOptions XmlMgrGeneratorDefaults(unsigned long long seed);
+
+/*! @brief builds a synthetic document below rootNode through the Write methods of XmlManagerBase
+The childrens of a node take distinct names from the vocabulary, so that every node can be reached
+by its path. Leaves hold doubles, ints, bools or strings.
+@param rootNode the node under which the document is built
+@param options the shape of the document
+@param result if not NULL, receives the counts of what has been created
+*/
+XMLMGR_IMPORT void XmlMgrGenerate(xmlNode* rootNode, const xmGeneratorOptions& options, xmGeneratorResult* result = NULL);
+
+#endif
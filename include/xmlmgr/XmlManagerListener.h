@@ -0,0 +1,47 @@
+/**
+*			@file XmlManagerListener.h
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*/
+
+#ifndef _XmlManagerListener_h_
+#define _XmlManagerListener_h_
+
+#include <xmlmgr/XmlManagerExports.h>
+
+typedef struct _xmlNode xmlNode;
+
+/**
+*		@class XmlManagerListener
+*
+*		@brief Callback interface used by XmlManagerBase::Subscribe
+*
+*		Changed is called by the thread doing the write, once the write is done, outside of any
+*		lock of the manager so that it can read the tree. It must not unsubscribe itself.
+*
+*		@author Nicolas Macherey (nm@graymat.fr)
+*		@date	31-Jan-2009
+*		@version 0.0.1
+*/
+class XMLMGR_IMPORT XmlManagerListener
+{
+public :
+    virtual ~XmlManagerListener() {};
+
+    /**
+    * @brief Called when the watched node or one of its descendants changes
+    *
+    *	@param watched the subscribed node
+    *	@param changed the node whose value, attributes or childrens changed. When the watched node
+    *	       itself is deleted it is the top of the deleted subtree, about to be freed, and the
+    *	       subscription is dropped.
+    */
+    virtual void Changed(xmlNode* watched, xmlNode* changed) = 0;
+};
+
+#endif
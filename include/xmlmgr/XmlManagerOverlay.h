@@ -0,0 +1,106 @@
+/**
+*			@file XmlManagerOverlay.h
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*/
+
+#ifndef _XmlManagerOverlay_h_
+#define _XmlManagerOverlay_h_
+
+#include <xmlmgr/XmlManagerBase.h>
+
+#include <string>
+#include <vector>
+
+/**
+*		@class XmlManagerOverlay
+*
+*		@brief Ordered stack of root nodes read as a single document
+*
+*		Layers are pushed from the lowest priority to the highest one, typically the factory
+*		defaults, then the site overrides, then the user settings. A read walks the layers from the
+*		top and stops at the first one holding a value, nothing is copied. Flatten merges all the
+*		layers in a single tree when a plain document is needed.
+*		@code
+*		XmlManagerOverlay settings;
+*		settings.Push(defaults);
+*		settings.Push(site);
+*		settings.Push(user);
+*		settings.ReadValue("solver/tolerance", &tolerance);
+*		@endcode
+*
+*		The overlay only holds the root nodes, the documents must outlive it.
+*
+*		@author Nicolas Macherey (nm@graymat.fr)
+*		@date	31-Jan-2009
+*		@version 0.0.1
+*/
+class XMLMGR_IMPORT XmlManagerOverlay
+{
+public :
+    XmlManagerOverlay() {};
+
+    /** Adds a layer above the existing ones
+    *  @param rootNode root node of the layer
+    */
+    void Push(xmlNode* rootNode);
+
+    /** Removes the top layer */
+    void Pop();
+
+    /** Number of layers */
+    size_t size() const { return m_layers.size(); };
+
+    /** Root node of layer i, 0 being the lowest priority */
+    xmlNode* Layer(size_t i) const { return m_layers[i]; };
+
+    /** Finds a node in the highest layer holding it
+    *  @param name path/key string of the node
+    *
+    *  @return returns the node or NULL if no layer holds it
+    */
+    xmlNode* Find(const std::string& name) const;
+
+    /** Reads a value from the highest layer holding a non empty value
+    *  @param name path/key string of the value
+    *  @param value the read value, unchanged if no layer holds it
+    *
+    *  @return returns true if a value has been read
+    */
+    template <class T> bool ReadValue(const std::string& name, T* value) const
+    {
+        XmlManagerBase* mgr = XmlManagerBase::Get();
+        for ( size_t i = m_layers.size(); i > 0; --i )
+            if ( mgr->ReadValue( name , m_layers[i - 1] , value ) )
+                return true;
+        return false;
+    }
+
+    /** Same as ReadValue for a path literal, the lookup does not allocate */
+    template <class T> bool Read(const xmPath& path, T* value) const
+    {
+        XmlManagerBase* mgr = XmlManagerBase::Get();
+        for ( size_t i = m_layers.size(); i > 0; --i )
+            if ( mgr->Read( path , m_layers[i - 1] , value ) )
+                return true;
+        return false;
+    }
+
+    /** Reads a string value, defaultValue if no layer holds it */
+    std::string Read(const std::string& name, const std::string& defaultValue = std::string()) const;
+
+    /** Merges all the layers into target in one call, from the lowest to the highest, see XmlManagerBase::Merge
+    *  @param target root node receiving the merged tree
+    */
+    void Flatten(xmlNode* target) const;
+
+private :
+    std::vector<xmlNode*> m_layers;
+};
+
+#endif
@@ -0,0 +1,109 @@
+/**
+*			@file XmlManagerPath.h
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*/
+
+#ifndef _XmlManagerPath_h_
+#define _XmlManagerPath_h_
+
+#include <cstddef>
+#include <stdexcept>
+
+/** maximum number of segments of a path literal */
+#define XM_PATH_MAX_SEGMENTS 16
+
+template <size_t... I> struct xmIndexSequence {};
+template <size_t N, size_t... I> struct xmMakeIndexSequence : xmMakeIndexSequence<N - 1, N - 1, I...> {};
+template <size_t... I> struct xmMakeIndexSequence<0, I...> { typedef xmIndexSequence<I...> type; };
+
+/** character replacing the characters that are illegal in node names, same set as AssertPath */
+constexpr char xmPathChar(char c)
+{
+    return ( c == ' ' || c == '-' || c == ':' || c == '.' || c == '"' || c == '\'' || c == '$' || c == '&' ||
+             c == '(' || c == ')' || c == '[' || c == ']' || c == '<' || c == '>' || c == '+' || c == '#' ) ? '_' : c;
+}
+
+/**
+*		@class xmPath
+*
+*		@brief Path literal resolved at compile time
+*
+*		An xmPath is built from a string literal with the _xp suffix. Runs of '/' are collapsed, the
+*		illegal characters are mapped to '_' and every segment gets its offset and length, so that a
+*		lookup compares the node names in place without building any string. Declare the literal constexpr to be sure
+*		the work is done by the compiler, a path with too many segments then fails to compile :
+*		@code
+*		static constexpr xmPath alpha = "thermo/model/alpha"_xp;
+*		mgr->Read(alpha, root, &value);
+*		@endcode
+*
+*		@author Nicolas Macherey (nm@graymat.fr)
+*		@date	31-Jan-2009
+*		@version 0.0.1
+*/
+class xmPath
+{
+public :
+    /** number of segments, 0 designates the root node itself */
+    constexpr size_t Count() const { return m_count; };
+    /** first character of segment i in the literal */
+    constexpr const char* Segment(size_t i) const { return m_str + m_begin[i]; };
+    /** length of segment i */
+    constexpr size_t Size(size_t i) const { return m_size[i]; };
+    /** returns true if the node name is segment i, the name is read up to the first difference */
+    bool Matches(size_t i, const char* name) const
+    {
+        const char* s = m_str + m_begin[i];
+        for ( size_t k = 0; k < m_size[i]; ++k )
+            if ( name[k] != xmPathChar( s[k] ) )
+                return false;
+        return name[m_size[i]] == '\0';
+    }
+
+private :
+    friend constexpr xmPath operator"" _xp(const char* str, size_t len);
+
+    constexpr xmPath(const char* str, size_t len)
+        : xmPath( str , len , typename xmMakeIndexSequence<XM_PATH_MAX_SEGMENTS>::type() ) {};
+
+    template <size_t... I>
+    constexpr xmPath(const char* str, size_t len, xmIndexSequence<I...>)
+        : m_str( str ),
+          m_count( CheckCount( CountFrom( str , len , 0 ) ) ),
+          m_begin{ (unsigned short) BeginOf( str , len , 0 , I )... },
+          m_size{ (unsigned short) ( EndOf( str , len , BeginOf( str , len , 0 , I ) ) - BeginOf( str , len , 0 , I ) )... } {};
+
+    static constexpr size_t Skip(const char* s, size_t n, size_t i)
+    { return ( i < n && s[i] == '/' ) ? Skip( s , n , i + 1 ) : i; }
+
+    static constexpr size_t EndOf(const char* s, size_t n, size_t i)
+    { return ( i < n && s[i] != '/' ) ? EndOf( s , n , i + 1 ) : i; }
+
+    static constexpr size_t CountFrom(const char* s, size_t n, size_t i)
+    { return Skip( s , n , i ) >= n ? 0 : 1 + CountFrom( s , n , EndOf( s , n , Skip( s , n , i ) ) ); }
+
+    static constexpr size_t BeginOf(const char* s, size_t n, size_t i, size_t k)
+    { return k == 0 ? Skip( s , n , i ) : BeginOf( s , n , EndOf( s , n , Skip( s , n , i ) ) , k - 1 ); }
+
+    static constexpr size_t CheckCount(size_t count)
+    { return count <= XM_PATH_MAX_SEGMENTS ? count : throw std::length_error("xmPath: too many segments"); }
+
+    const char* m_str;
+    size_t m_count;
+    unsigned short m_begin[XM_PATH_MAX_SEGMENTS];
+    unsigned short m_size[XM_PATH_MAX_SEGMENTS];
+};
+
+/** builds a path literal, see xmPath */
+constexpr xmPath operator"" _xp(const char* str, size_t len)
+{
+    return xmPath( str , len );
+}
+
+#endif
@@ -0,0 +1,133 @@
+/**
+*			@file XmlManagerPushParser.h
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*/
+
+#ifndef _XmlManagerPushParser_h_
+#define _XmlManagerPushParser_h_
+
+#include <xmlmgr/XmlManagerExports.h>
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+typedef struct _xmlNode xmlNode;
+typedef struct _xmlDoc xmlDoc;
+typedef struct _xmlParserCtxt xmlParserCtxt;
+
+/** default size of the chunks read by XmlManagerPushParser::PushStream */
+#define XM_PUSH_CHUNK_SIZE 65536
+
+/**
+*		@class XmlManagerPushHandler
+*
+*		@brief Callback interface of XmlManagerPushParser
+*
+*		SubtreeParsed is called, from Push, as soon as a child of the root element is complete. The
+*		subtree can be read with the XmlManagerBase methods, the rest of the document is not parsed yet.
+*
+*		@author Nicolas Macherey (nm@graymat.fr)
+*		@date	31-Jan-2009
+*		@version 0.0.1
+*/
+class XMLMGR_IMPORT XmlManagerPushHandler
+{
+public :
+    virtual ~XmlManagerPushHandler() {};
+
+    /**
+    * @brief Called when a child of the root element and all its childrens are parsed
+    *
+    *	@param subtree the completed child of the root element
+    *
+    *	@return returns true to keep the subtree in the document, false to free it at once, which
+    *	        keeps the memory flat when the document is a long stream of records
+    */
+    virtual bool SubtreeParsed(xmlNode* subtree) = 0;
+};
+
+/**
+*		@class XmlManagerPushParser
+*
+*		@brief Parses a document from chunks as they arrive
+*
+*		Each chunk is parsed when it is pushed, so that parsing overlaps with the reads and the whole
+*		payload is never buffered :
+*		@code
+*		XmlManagerPushParser parser( &handler );
+*		while ( (size = read( fd , buffer , sizeof(buffer) )) > 0 )
+*			if ( !parser.Push( buffer , size ) )
+*				break;
+*		xmlDoc* doc = parser.Finish();
+*		@endcode
+*
+*		@author Nicolas Macherey (nm@graymat.fr)
+*		@date	31-Jan-2009
+*		@version 0.0.1
+*/
+class XMLMGR_IMPORT XmlManagerPushParser
+{
+public :
+    /** Creates a parser
+    *  @param handler if not NULL, receives the completed childrens of the root element
+    *  @param filename name used in the error messages and as base url, may be NULL
+    *  @param options libxml parser options (XML_PARSE_*)
+    */
+    XmlManagerPushParser(XmlManagerPushHandler* handler = NULL, const char* filename = NULL, int options = 0);
+
+    /** Frees the parser and the document if Finish has not handed it over */
+    ~XmlManagerPushParser();
+
+    /** Parses the next chunk of the document
+    *  @param chunk the bytes, they are not kept after the call
+    *  @param size number of bytes
+    *
+    *  @return returns false once the document is known to be malformed, see GetError
+    */
+    bool Push(const char* chunk, size_t size);
+
+    /** Pushes everything that can be read from a stream
+    *  @param in the stream
+    *  @param chunkSize size of the reads
+    *
+    *  @return returns false once the document is known to be malformed
+    */
+    bool PushStream(std::istream& in, size_t chunkSize = XM_PUSH_CHUNK_SIZE);
+
+    /** Ends the document
+    *  @return returns the document, to be freed with XmlMgrFreeDoc, NULL if it is malformed
+    */
+    xmlDoc* Finish();
+
+    /** Returns the first error met, empty if there is none */
+    const std::string& GetError() const { return m_error; };
+
+    /** Returns the number of subtrees given to the handler */
+    size_t GetSubtreeCount() const { return m_subtrees; };
+
+private :
+    XmlManagerPushParser(const XmlManagerPushParser&);
+    XmlManagerPushParser& operator=(const XmlManagerPushParser&);
+
+    /** SAX end of element, hands the completed childrens of the root to the handler */
+    static void EndElement(void* ctx, const unsigned char* localname, const unsigned char* prefix, const unsigned char* uri);
+
+    /** records the error of the parser context if none has been recorded */
+    void KeepError(const char* fallback);
+
+    XmlManagerPushHandler* m_handler;
+    xmlParserCtxt* m_ctxt;
+    std::string m_error;
+    size_t m_subtrees;
+    bool m_failed;
+    bool m_finished;
+};
+
+#endif
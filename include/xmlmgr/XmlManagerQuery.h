@@ -0,0 +1,85 @@
+/**
+*			@file XmlManagerQuery.h
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*/
+
+#ifndef _XmlManagerQuery_h_
+#define _XmlManagerQuery_h_
+
+#include <xmlmgr/XmlManagerExports.h>
+
+#include <cstddef>
+
+typedef struct _xmlNode xmlNode;
+typedef struct _xmlXPathObject xmlXPathObject;
+
+/**
+*		@class XmlManagerQueryResult
+*
+*		@brief Node set returned by XmlManagerBase::Query
+*
+*		The result owns the evaluated xpath object and is only movable. Its nodes can be handed
+*		straight to the typed Read methods of XmlManagerBase with an empty path :
+*		@code
+*		XmlManagerQueryResult streams = mgr->Query("streams/stream[@phase='vapor']", root);
+*		for ( XmlManagerQueryResult::const_iterator it = streams.begin(); it != streams.end(); ++it )
+*		    mgr->Read("", *it, &flow);
+*		@endcode
+*
+*		@author Nicolas Macherey (nm@graymat.fr)
+*		@date	31-Jan-2009
+*		@version 0.0.1
+*/
+class XMLMGR_IMPORT XmlManagerQueryResult
+{
+    friend class XmlManagerBase;
+
+public :
+    /** forward iterator over the nodes of the result, in document order */
+    class const_iterator
+    {
+    public :
+        const_iterator() : m_pos(NULL) {};
+        xmlNode* operator*() const { return *m_pos; };
+        const_iterator& operator++() { ++m_pos; return *this; };
+        const_iterator operator++(int) { const_iterator r(*this); ++m_pos; return r; };
+        bool operator==(const const_iterator& o) const { return m_pos == o.m_pos; };
+        bool operator!=(const const_iterator& o) const { return m_pos != o.m_pos; };
+    private :
+        friend class XmlManagerQueryResult;
+        explicit const_iterator(xmlNode* const* pos) : m_pos(pos) {};
+        xmlNode* const* m_pos;
+    };
+
+    XmlManagerQueryResult() : m_result(NULL), m_nodes(NULL), m_count(0) {};
+    XmlManagerQueryResult(XmlManagerQueryResult&& other);
+    XmlManagerQueryResult& operator=(XmlManagerQueryResult&& other);
+    ~XmlManagerQueryResult();
+
+    /** number of nodes in the result */
+    size_t size() const { return m_count; };
+    /** returns true if nothing matched */
+    bool empty() const { return m_count == 0; };
+    /** node at the given position */
+    xmlNode* operator[](size_t i) const { return m_nodes[i]; };
+
+    const_iterator begin() const { return const_iterator(m_nodes); };
+    const_iterator end() const { return const_iterator(m_nodes + m_count); };
+
+private :
+    explicit XmlManagerQueryResult(xmlXPathObject* result);
+    XmlManagerQueryResult(const XmlManagerQueryResult&);
+    XmlManagerQueryResult& operator=(const XmlManagerQueryResult&);
+
+    xmlXPathObject* m_result;
+    xmlNode** m_nodes;
+    size_t m_count;
+};
+
+#endif
@@ -0,0 +1,115 @@
+/**
+*			@file XmlManagerSave.h
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*/
+
+#ifndef _XmlManagerSave_h_
+#define _XmlManagerSave_h_
+
+#include <xmlmgr/XmlManagerExports.h>
+
+#include <cstddef>
+#include <string>
+
+typedef struct _xmlDoc xmlDoc;
+
+/**
+*			@struct xmSaveResult
+*
+*			@brief Outcome of one save of XmlManagerBase::SaveAtomic, times are in seconds
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*/
+struct xmSaveResult
+{
+		int bytes;							/*!< bytes written, -1 if the save failed */
+		double writeTime;					/*!< serialization to the temporary file */
+		double commitTime;					/*!< wait for the group commit, fsync and rename */
+		double totalTime;					/*!< whole save */
+		size_t groupSize;					/*!< number of files made durable by the same fsync round */
+};
+
+/**
+*			@struct xmSaveJob
+*
+*			@brief One document of a batch given to XmlManagerBase::SaveAtomic
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*/
+struct xmSaveJob
+{
+		xmlDoc* doc;						/*!< the document to save */
+		std::string filename;				/*!< the target file */
+		xmSaveResult result;				/*!< filled by the save */
+};
+
+/** write callback of XmlMgrSaveToIO, returns the number of bytes written or -1 on error */
+typedef int (*xmSaveWriteFunc)(void* context, const char* data, int len);
+
+/*! @brief serializes a document in a string, without file I/O
+The string is cleared but keeps its capacity, reusing the same string for the next saves avoids
+growing it again. The output is the same as XmlMgrSaveFormatFileEnc.
+@param doc the document
+@param buffer receives the serialized document
+@param encoding the name of the encoding to use or NULL
+@param format should formatting spaces be added
+@return the number of bytes written or -1 in case of error
+*/
+XMLMGR_IMPORT int XmlMgrSaveToBuffer(xmlDoc* doc, std::string* buffer, const char* encoding = "UTF-8", int format = 1);
+
+/*! @brief serializes a document in a file descriptor, a pipe or a socket
+The descriptor is neither synced nor closed.
+@param doc the document
+@param fd the descriptor, opened for writing
+@param encoding the name of the encoding to use or NULL
+@param format should formatting spaces be added
+@return the number of bytes written or -1 in case of error
+*/
+XMLMGR_IMPORT int XmlMgrSaveToFd(xmlDoc* doc, int fd, const char* encoding = "UTF-8", int format = 1);
+
+/*! @brief serializes a document through a write callback, for compression or custom transports
+The callback receives the document in chunks of a few kilobytes.
+@param doc the document
+@param write the callback, a negative return aborts the save
+@param context passed to the callback
+@param encoding the name of the encoding to use or NULL
+@param format should formatting spaces be added
+@return the number of bytes written or -1 in case of error
+*/
+XMLMGR_IMPORT int XmlMgrSaveToIO(xmlDoc* doc, xmSaveWriteFunc write, void* context, const char* encoding = "UTF-8", int format = 1);
+
+/*! @brief serializes a document with several threads in a file, the output is the same as XmlMgrSaveFormatFileEnc
+The childrens of the root element are serialized concurrently in separate buffers at their indentation
+depth, the buffers are then written in order with vectored writes. Small documents, encodings other
+than UTF-8, documents with a DTD and roots holding text are saved sequentially.
+@param filename the filename to output
+@param doc the document, it is only read
+@param encoding the name of the encoding to use or NULL
+@param format should formatting spaces be added
+@param threads number of threads, 0 for the hardware concurrency
+@return the number of bytes written or -1 in case of error
+*/
+XMLMGR_IMPORT int XmlMgrSaveParallelFileEnc(const char* filename, xmlDoc* doc, const char* encoding = "UTF-8", int format = 1, unsigned int threads = 0);
+
+/*! @brief serializes a document with several threads in a file descriptor, see XmlMgrSaveParallelFileEnc
+The descriptor is neither synced nor closed.
+@param doc the document, it is only read
+@param fd the descriptor, opened for writing
+@param encoding the name of the encoding to use or NULL
+@param format should formatting spaces be added
+@param threads number of threads, 0 for the hardware concurrency
+@return the number of bytes written or -1 in case of error
+*/
+XMLMGR_IMPORT int XmlMgrSaveParallelToFd(xmlDoc* doc, int fd, const char* encoding = "UTF-8", int format = 1, unsigned int threads = 0);
+
+#endif
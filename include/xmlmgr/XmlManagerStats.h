@@ -0,0 +1,116 @@
+/**
+*			@file XmlManagerStats.h
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*/
+
+#ifndef _XmlManagerStats_h_
+#define _XmlManagerStats_h_
+
+#include <xmlmgr/XmlManagerExports.h>
+
+#include <cstddef>
+#include <string>
+
+/** default number of siblings from which a lookup is recorded by the lookup profile */
+#define XM_PROFILE_MIN_SIBLINGS 32
+
+/** number of buckets of the histograms, bucket 0 counts the zeros and bucket b > 0 the values
+    in [2^(b-1), 2^b), the last bucket also counts everything above */
+#define XM_STATS_BUCKETS 40
+
+/** instrumented entry points of XmlManagerBase */
+enum xmStatsCall
+{
+    xmStatsReadValue = 0,					/*!< typed Read of a value, string or path literal */
+    xmStatsWriteValue,						/*!< typed Write of a value, string or path literal */
+    xmStatsReadArray,						/*!< ReadArray in a vector or a buffer */
+    xmStatsWriteArray,						/*!< WriteArray */
+    xmStatsReadAttribute,					/*!< ReadAttribute */
+    xmStatsWriteAttribute,					/*!< WriteAttribute */
+    xmStatsGetNode,							/*!< GetNode */
+    xmStatsCallCount
+};
+
+/**
+*			@struct xmStats
+*
+*			@brief Snapshot of the counters of XmlManagerBase, summed over the threads
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*/
+struct xmStats
+{
+		unsigned long long calls[xmStatsCallCount];							/*!< number of calls per entry point */
+		unsigned long long latency[xmStatsCallCount][XM_STATS_BUCKETS];		/*!< histogram of the call durations in nanoseconds */
+		unsigned long long scans;											/*!< sibling scans of the path lookups */
+		unsigned long long scannedSiblings;									/*!< siblings visited by those scans */
+		unsigned long long scanLength[XM_STATS_BUCKETS];					/*!< histogram of the siblings visited per scan */
+		unsigned long long nodesCreated;									/*!< nodes allocated, recycled nodes excluded */
+		unsigned long long contentCopies;									/*!< node contents copied with xmlNodeGetContent */
+		unsigned long long contentBytes;									/*!< bytes of those copies */
+		size_t threads;														/*!< counter blocks, the most threads that have counted at the same time */
+};
+
+/** structural change suggested for a slow lookup */
+enum xmLookupAdvice
+{
+    xmAdviceChildIndex = 0,					/*!< many distinct siblings, index the childrens by name */
+    xmAdviceAttributeIndex,					/*!< childrens searched by attribute, declare an attribute index */
+    xmAdvicePackedArray						/*!< mostly repeated siblings, store them as an array */
+};
+
+/**
+*			@struct xmLookupProfile
+*
+*			@brief Slow lookups of a name under a parent node, see XmlManagerBase::EnableLookupProfile
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*/
+struct xmLookupProfile
+{
+		std::string parent;					/*!< xpath of the parent node */
+		std::string name;					/*!< queried name, \@attribute for the attribute searches */
+		unsigned long long calls;			/*!< recorded lookups */
+		unsigned long long misses;			/*!< lookups that found nothing */
+		unsigned long long scannedSiblings;	/*!< siblings visited by those lookups */
+		size_t maxSiblings;					/*!< longest scan */
+		size_t childrens;					/*!< element childrens of the parent at the longest scan */
+		size_t repeated;					/*!< childrens sharing the most common name at the longest scan */
+		xmLookupAdvice advice;				/*!< suggested change */
+};
+
+/** Returns a sentence describing an advice */
+XMLMGR_IMPORT const char* XmlMgrLookupAdviceText(xmLookupAdvice advice);
+
+/** Returns the name of an entry point, "unknown" for an invalid value */
+XMLMGR_IMPORT const char* XmlMgrStatsCallName(xmStatsCall call);
+
+/** Returns the histogram bucket of a value */
+inline size_t XmlMgrStatsBucket(unsigned long long value)
+{
+    size_t b = 0;
+    while ( value != 0 && b < XM_STATS_BUCKETS - 1 )
+    {
+        value >>= 1;
+        ++b;
+    }
+    return b;
+}
+
+/** Returns an upper bound of the p-th fraction of a histogram, 0 if it is empty
+*  @param histogram the XM_STATS_BUCKETS buckets
+*  @param p the fraction, 0.5 for the median, 0.99 for the 99th percentile
+*/
+XMLMGR_IMPORT unsigned long long XmlMgrStatsPercentile(const unsigned long long* histogram, double p);
+
+#endif
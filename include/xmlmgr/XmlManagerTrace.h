@@ -0,0 +1,74 @@
+/**
+*			@file XmlManagerTrace.h
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*/
+
+#ifndef _XmlManagerTrace_h_
+#define _XmlManagerTrace_h_
+
+#include <xmlmgr/XmlManagerExports.h>
+
+#include <atomic>
+#include <cstddef>
+
+/** default number of spans kept per thread, the oldest spans are overwritten */
+#define XM_TRACE_CAPACITY 16384
+
+/**
+*		@class XmlManagerTraceSpan
+*
+*		@brief Records the time spent in a scope when tracing is on, see XmlManagerBase::EnableTrace
+*
+*		The heavy entry points of the library open a span, applications can open their own around
+*		the calls they want to see in the trace :
+*		@code
+*		{
+*			XmlManagerTraceSpan span("LoadProject");
+*			...
+*		}
+*		@endcode
+*		The name is kept by pointer and must outlive the trace, use string literals. When tracing
+*		is off a span costs one atomic load.
+*
+*		@author Nicolas Macherey (nm@graymat.fr)
+*		@date	31-Jan-2009
+*		@version 0.0.1
+*/
+class XMLMGR_IMPORT XmlManagerTraceSpan
+{
+public :
+    /** Opens the span
+    *  @param name name shown in the trace viewer
+    */
+    XmlManagerTraceSpan(const char* name) :
+        m_name( s_enabled.load( std::memory_order_relaxed ) ? name : NULL ), m_start( m_name != NULL ? Now() : 0 ) {};
+
+    /** Closes the span and records it in the ring of the calling thread */
+    ~XmlManagerTraceSpan() { if ( m_name != NULL ) Record( m_name , m_start , Now() ); };
+
+private :
+    friend class XmlManagerBase;
+
+    XmlManagerTraceSpan(const XmlManagerTraceSpan&);
+    XmlManagerTraceSpan& operator=(const XmlManagerTraceSpan&);
+
+    /** monotonic time in nanoseconds */
+    static unsigned long long Now();
+    static void Record(const char* name, unsigned long long start, unsigned long long end);
+
+    /** true while tracing is on */
+    static std::atomic<bool> s_enabled;
+    /** ring size of the threads starting to trace */
+    static std::atomic<size_t> s_capacity;
+
+    const char* m_name;
+    unsigned long long m_start;
+};
+
+#endif
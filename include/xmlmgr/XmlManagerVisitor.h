@@ -0,0 +1,55 @@
+/**
+*			@file XmlManagerVisitor.h
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*/
+
+#ifndef _XmlManagerVisitor_h_
+#define _XmlManagerVisitor_h_
+
+#include <xmlmgr/XmlManagerExports.h>
+
+typedef struct _xmlNode xmlNode;
+
+/** Traversal modes for XmlManagerBase::VisitChildrens */
+enum xmVisitMode
+{
+    xmVisitSequential = 0,		/*!< one thread, nodes are visited in document order */
+    xmVisitParallel			/*!< top level childrens are spread over a work-stealing pool */
+};
+
+/**
+*		@class XmlManagerVisitor
+*
+*		@brief Callback interface used by XmlManagerBase::VisitChildrens
+*
+*		Nodes are handed out as const pointers, a visitor must not modify the tree.
+*		In xmVisitParallel mode Visit is called concurrently from several threads, the order
+*		is only kept inside each top level subtree.
+*
+*		@author Nicolas Macherey (nm@graymat.fr)
+*		@date	31-Jan-2009
+*		@version 0.0.1
+*/
+class XMLMGR_IMPORT XmlManagerVisitor
+{
+public :
+    virtual ~XmlManagerVisitor() {};
+
+    /**
+    * @brief Called once for every element node of the visited subtree
+    *
+    *	@param node the visited element
+    *	@param depth depth of the node, 0 for the direct childrens of the visited path
+    *
+    *	@return returns false to skip the childrens of the node
+    */
+    virtual bool Visit(const xmlNode* node, unsigned int depth) = 0;
+};
+
+#endif
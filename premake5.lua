@@ -15,12 +15,35 @@ workspace "NgoXmlMgr"
     }
     
     -- PROTECTED REGION ID(NgoXmlMgr.premake.solution) ENABLED START
-	configuration {"vs2010","Release"}
+	cppdialect "C++11"
+	-- std::thread, thread_local and constexpr need the VS2015 compiler at least, the common
+	-- scripts still select the VS2010 toolsets
+	filter {"system:windows", "action:vs*"}
+			toolset "v140"
+	filter {}
+	configuration {"vs*","Release"}
 			links {"NgoLibxml2"}
-	configuration {"vs2010","Debug"}
+	configuration {"vs*","Debug"}
 			links {"NgoLibxml2"}
 	configuration {"linux"}
-			links {"xml2"}
+			links {"xml2", "pthread"}
+	configuration {}
+
+	-- the benchmark and the generator tool are not in the project model, they are declared here
+	-- so that a regeneration keeps them
+	project "bench_NgoXmlMgr"
+
+		PrefilterExeBuildOptions("bench_NgoXmlMgr")
+		files {"bench/**.cpp"}
+		links { "NgoXmlMgr"}
+		FilterExeBuildOptions("bench_NgoXmlMgr")
+
+	project "gen_NgoXmlMgr"
+
+		PrefilterExeBuildOptions("gen_NgoXmlMgr")
+		files {"tools/gen_NgoXmlMgr.cpp"}
+		links { "NgoXmlMgr"}
+		FilterExeBuildOptions("gen_NgoXmlMgr")
 
     -- PROTECTED REGION END
 
@@ -47,3 +70,4 @@ project "test_NgoXmlMgr"
     -- PROTECTED REGION END
 
     FilterTestBuildOptions("test_NgoXmlMgr")
+
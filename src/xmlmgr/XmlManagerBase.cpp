@@ -22,24 +22,35 @@
 
 #include <xmlmgr/XmlManagerBase.h>
 #include "ngoerr/NgoError.h"
+#include "XmlManagerWorkPool.h"
 
 #include <libxml/xmlreader.h>
 #include <libxml/xpath.h>
 
-#include <sstream>
+#include <cstring>
 #include <iostream>
 
 _xmlDoc * XmlMgrParseFile(const char * filename)
-{ return xmlParseFile(filename); };
+{
+    XmlManagerTraceSpan span( "XmlMgrParseFile" );
+    return xmlParseFile(filename);
+};
 
 int XmlMgrSaveFormatFileEnc(const char * filename, _xmlDoc * cur, const char * encoding, int format)
-{ return xmlSaveFormatFileEnc(filename,cur,encoding,format); }
+{
+    XmlManagerTraceSpan span( "XmlMgrSaveFormatFileEnc" );
+    return xmlSaveFormatFileEnc(filename,cur,encoding,format);
+}
 
 _xmlDoc * XmlMgrNewDoc(const char * version)
 { return xmlNewDoc((const xmlChar *)version); };
 
 void XmlMgrFreeDoc(_xmlDoc * cur)
-{ return xmlFreeDoc(cur); };
+{
+    if ( XmlManagerBase::IsCreated() )
+        XmlManagerBase::Get()->ReleaseDocument(cur);
+    return xmlFreeDoc(cur);
+};
 
 _xmlNode * XmlMgrNewDocNode(_xmlDoc * doc, _xmlNs * ns, const char * name, const char * content)
 { return xmlNewDocNode(doc,ns,(const xmlChar *)name,(const xmlChar *)content); }
@@ -60,8 +71,16 @@ void XmlMgrFreeNode(_xmlNode * cur)
 
 template <> XmlManagerBase * NgoSingleton<XmlManagerBase>::instance_ = 0L;
 
+bool XmlManagerBase::IsCreated()
+{
+    return instance_ != 0L;
+}
+
 XmlManagerBase::~XmlManagerBase()
 {
+   ClearQueryCache();
+   TrimNodePool();
+
    // need to clean up xml parser
    xmlCleanupParser();
 }
@@ -139,10 +158,12 @@ xmlNode* XmlManagerBase::AssertPath( std::string& path,
         sub = SubPaths[i];
         xmlNode* subNode;
         subNode = localPath->children;
+        size_t scanned = 0;
 
         /* locate subnode */
         while ( subNode != NULL )
         {
+            ++scanned;
             std::string nodeName = (const char*) subNode->name ;
             if ( nodeName == sub )
             {
@@ -150,13 +171,16 @@ xmlNode* XmlManagerBase::AssertPath( std::string& path,
             }
             subNode = subNode->next;
         }
+        if ( Counting() )
+            RecordScan( scanned );
+        if ( Profiling() )
+            ProfileLookup( localPath , sub.c_str() , sub.size() , scanned , subNode != NULL , false );
 
         if ( subNode == NULL )
         {
             if ( create_unexisting )
             {
-                subNode = xmlNewNode( NULL , (const xmlChar*) sub.c_str() );
-                xmlAddChild( localPath , subNode );
+                subNode = xmlAddChild( localPath , NewElement( localPath->doc , sub.c_str() ) );
             }
             else
             {
@@ -172,6 +196,9 @@ xmlNode* XmlManagerBase::AssertPath( std::string& path,
 
 void XmlManagerBase::Clear(xmlNode *rootNode)
 {
+    if ( Journaling() )
+        JournalValue( rootNode , xmChangeClear , NULL , NULL );
+
     xmlNode *sub = rootNode->children;
     xmlNode *child;
 
@@ -179,8 +206,9 @@ void XmlManagerBase::Clear(xmlNode *rootNode)
     {
         child = sub;
         sub = sub->next;
-        xmlReplaceNode( child , NULL );
+        DetachNode( child );
     }
+    NotifyChange( rootNode );
 }
 
 void XmlManagerBase::Delete(xmlDoc* doc)
@@ -208,18 +236,27 @@ xmlNode* XmlManagerBase::GetUniqElement(xmlNode* p, const std::string& q, bool c
         return p;
 
     xmlNode* r = p->children;
+    size_t scanned = 0;
 
     while ( r != NULL )
     {
+        ++scanned;
         std::string nodeName = (const char*) r->name ;
         if ( nodeName == q )
-            return r;
+            break;
 
         r = r->next;
     }
+    if ( Counting() )
+        RecordScan( scanned );
+    if ( Profiling() )
+        ProfileLookup( p , q.c_str() , q.size() , scanned , r != NULL , false );
+    if ( r != NULL )
+        return r;
+
     if ( create_unexisting )
     {
-        r = xmlNewNode( NULL , (const xmlChar*) q.c_str() );
+        r = NewElement( p->doc , q.c_str() );
         return  xmlAddChild( p , r );
     }
     return NULL;
@@ -230,319 +267,396 @@ void XmlManagerBase::SetNodeText(xmlNode* n, const char  *t)
     if ( n == NULL )
         throw NgoErrorInvalidArgument(1,"trying to set the content of an unexisting node","XmlManagerBase::SetNodeText");
 
-    xmlNodeSetContent( n , (const xmlChar*) t );
-}
-
-/* ------------------------------------------------------------------------------------------------------------------
-*  Write and read values
-*  Regardless of namespaces, the string keys app_path and data_path always refer to the location of the application's executable
-*  and the data path, respectively. These values are never saved to the configuration, but kept in static variables.
-*  The application makes use of this by "writing" to the configuration file after determining these values at runtime.
-*/
-void XmlManagerBase::Write(const std::string& name, xmlNode* pathNode,  const std::string& value, bool ignoreEmpty)
-{
-    if (ignoreEmpty && value.empty())
+    /* the value is stored as it is, xmlNodeSetContent would parse '&' as an entity reference in
+       elements and attributes, not in the other nodes */
+    if ( n->type == XML_ATTRIBUTE_NODE )
     {
-        //UnSet(name);
+        xmlNodeSetContent( n , NULL );
+        if ( *t != '\0' )
+            xmlAddChild( n , xmlNewDocText( n->doc , (const xmlChar*) t ) );
+        return;
+    }
+    if ( n->type != XML_ELEMENT_NODE )
+    {
+        xmlNodeSetContent( n , (const xmlChar*) t );
         return;
     }
 
-    if ( pathNode == NULL )
-        throw NgoErrorInvalidArgument(2,"trying to write to an undefined rootNode","XmlManagerBase::Write");
+    xmlNode* text = n->children;
+    if ( text != NULL && text->next == NULL && text->type == XML_TEXT_NODE )
+    {
+        SetTextContent( text , t );
+        return;
+    }
 
-    std::string key(name);
-    xmlNode* e = AssertPath(key, pathNode);
-    xmlNode *str = GetUniqElement(e, key);
-    xmlNodeSetContent(str, (const xmlChar*) value.c_str() );
+    while ( n->children != NULL )
+        DetachNode( n->children );
+    if ( *t != '\0' )
+        xmlAddChild( n , NewText( n->doc , t ) );
 }
 
-std::string XmlManagerBase::Read(const std::string& name, xmlNode* rootNode, const std::string& defaultVal)
+const char* XmlManagerBase::NodeText(xmlNode* n, std::string* scratch)
 {
-    std::string ret;
+    if ( n == NULL )
+        throw NgoErrorInvalidArgument(1,"trying to get the content of an unexisting node","XmlManagerBase::NodeText");
 
-    if (Read(name, &ret, rootNode))
-        return ret;
-    else
-        return defaultVal;
+    xmlNode* text = n->children;
+    if ( n->type == XML_TEXT_NODE || n->type == XML_CDATA_SECTION_NODE )
+        return n->content != NULL ? (const char*) n->content : "";
+    if ( text == NULL )
+        return "";
+    if ( text->next == NULL && ( text->type == XML_TEXT_NODE || text->type == XML_CDATA_SECTION_NODE ) )
+        return text->content != NULL ? (const char*) text->content : "";
+
+    xmlChar* content = xmlNodeGetContent(n);
+    scratch->assign( content != NULL ? (const char*) content : "" );
+    xmlFree(content);
+    if ( Counting() )
+        RecordContent( scratch->size() );
+    return scratch->c_str();
 }
 
-bool XmlManagerBase::Read(const std::string& name, std::string* str, xmlNode* rootNode )
+xmlNode* XmlManagerBase::GetNode(const xmPath& path, xmlNode* rootNode, bool create_unexisting)
 {
-    std::string key(name);
+    StatsScope scope( this , xmStatsGetNode );
+    return WalkPath( path , rootNode , create_unexisting , path.Count() );
+}
 
+xmlNode* XmlManagerBase::WalkPath(const xmPath& path, xmlNode* rootNode, bool create_unexisting, size_t segments)
+{
     if ( rootNode == NULL )
-        throw NgoErrorInvalidArgument(2,"trying to read to an undefined rootNode","XmlManagerBase::Read");
+        throw NgoErrorInvalidArgument(2,"trying to get a node from an undefined rootNode","XmlManagerBase::GetNode");
 
-    xmlNode* e = AssertPath( key, rootNode, false );
-    if ( e == NULL )
-        return false;
+    xmlNode* localPath = rootNode;
 
-    xmlNode *n = GetUniqElement(e, key, false);
-    if ( n == NULL )
-        return false;
+    for ( size_t i = 0; i < segments; ++i )
+    {
+        xmlNode* subNode = localPath->children;
+        size_t scanned = 0;
+
+        while ( subNode != NULL )
+        {
+            ++scanned;
+            if ( subNode->type == XML_ELEMENT_NODE && path.Matches( i , (const char*) subNode->name ) )
+                break;
+            subNode = subNode->next;
+        }
+        if ( Counting() )
+            RecordScan( scanned );
+        if ( Profiling() )
+            ProfileLookup( localPath , path.Segment(i) , path.Size(i) , scanned , subNode != NULL , false );
 
-   xmlChar * value = xmlNodeGetContent(n);
-   str->assign( (const char*) value );
-   xmlFree(value);
+        if ( subNode == NULL )
+        {
+            if ( !create_unexisting )
+                return NULL;
 
-   return !str->empty();
+            std::string name( path.Segment(i) , path.Size(i) );
+            for ( size_t k = 0; k < name.size(); ++k )
+                name[k] = xmPathChar( name[k] );
+
+            subNode = xmlAddChild( localPath , NewElement( localPath->doc , name.c_str() ) );
+        }
+
+        localPath = subNode;
+    }
+
+    return localPath;
 }
 
 /*--------------------------------------------------------------------------------------------------------------------------------------------------
-* Writing and Reading ints
+* Typed access engine
 ---------------------------------------------------------------------------------------------------------------------------------------------------*/
-void XmlManagerBase::Write(const std::string& name, xmlNode* rootNode,  int value)
+xmlNode* XmlManagerBase::FindValueNode(const std::string& name, xmlNode* rootNode)
 {
     std::string key(name);
 
     if ( rootNode == NULL )
-        throw NgoErrorInvalidArgument(2,"trying to write to an undefined rootNode","XmlManagerBase::Write");
+        throw NgoErrorInvalidArgument(2,"trying to read from an undefined rootNode","XmlManagerBase::Read");
 
-    xmlNode* node = AssertPath(key,rootNode);
-    xmlNode* e = GetUniqElement( node , key );
+    xmlNode* e = AssertPath( key, rootNode, false );
+    if ( e == NULL )
+        return NULL;
 
-    std::stringstream sStream;
-    sStream << value;
+    return GetUniqElement(e, key, false);
+}
 
-    std::string val;
-    sStream >> val;
+xmlNode* XmlManagerBase::AssertValueNode(const std::string& name, xmlNode* rootNode)
+{
+    std::string key(name);
 
-    xmlNodeSetContent( e , (const xmlChar*) val.c_str() );
+    if ( rootNode == NULL )
+        throw NgoErrorInvalidArgument(2,"trying to write to an undefined rootNode","XmlManagerBase::Write");
+
+    xmlNode* node = AssertPath(key,rootNode);
+    return GetUniqElement( node , key );
 }
 
-int  XmlManagerBase::ReadInt(const std::string& name, xmlNode* rootNode,  int defaultVal)
+/* the last segment of an array name is the name of its items, the rest is the array node path */
+static void SplitArrayName(const std::string& name, std::string* key, std::string* item)
 {
-    int ret;
-
-    if (Read(name, rootNode, &ret))
-        return ret;
-    else
-        return defaultVal;
+    size_t found = name.find_last_of("/");
+    *key = name.substr(0,found);
+    *item = name.substr(found+1);
 }
 
-bool XmlManagerBase::Read(const std::string& name, xmlNode* rootNode ,  int* value)
+xmlNode* XmlManagerBase::FindArrayNode(const std::string& name, xmlNode* rootNode, std::string* item)
 {
-    std::string key(name);
+    std::string key;
+    SplitArrayName( name , &key , item );
 
     if ( rootNode == NULL )
         throw NgoErrorInvalidArgument(2,"trying to read from an undefined rootNode","XmlManagerBase::Read");
 
     xmlNode* e = AssertPath( key, rootNode, false );
     if ( e == NULL )
-        return false;
-
-    xmlNode *n = GetUniqElement(e, key, false);
-    if ( n == NULL )
-        return false;
-
-   xmlChar * content = xmlNodeGetContent(n);
-   std::string str = (const char*) content ;
-   xmlFree(content);
-
-	 if( !str.empty() )
-	 {
-			std::stringstream sStream;
-			sStream << str;
-			sStream >> *value;
-
-			if( NaN( *value ) )
-				return false;
-
-	 }else{
-			return false;
-	 }
+        return NULL;
 
-    return true;
+    return GetUniqElement(e, key, false);
 }
 
-/*--------------------------------------------------------------------------------------------------------------------------------------------------
-* Writing and Reading bools
----------------------------------------------------------------------------------------------------------------------------------------------------*/
-void XmlManagerBase::Write(const std::string& name, xmlNode* rootNode,  bool value)
+xmlNode* XmlManagerBase::AssertArrayNode(const std::string& name, xmlNode* rootNode, std::string* item)
 {
-    std::string key(name);
+    std::string key;
+    SplitArrayName( name , &key , item );
 
     if ( rootNode == NULL )
         throw NgoErrorInvalidArgument(2,"trying to write to an undefined rootNode","XmlManagerBase::Write");
 
     xmlNode* node = AssertPath(key,rootNode);
-    xmlNode* e = GetUniqElement( node , key );
-
-    std::stringstream sStream;
-    sStream << value;
-
-    std::string val;
-    sStream >> val;
-
-    xmlNodeSetContent( e , (const xmlChar*) val.c_str() );
+    return GetUniqElement( node , key );
 }
 
-bool  XmlManagerBase::ReadBool(const std::string& name, xmlNode* rootNode,  bool defaultVal)
+xmlNode* XmlManagerBase::NextArrayItem(xmlNode* e, xmlNode* prev, const std::string& item)
 {
-    bool ret;
+    xmlNode* curr = ( prev == NULL ) ? e->children : prev->next;
+    const char* itemName = item.c_str();
 
-    if (Read(name, rootNode, &ret))
-        return ret;
-    else
-        return defaultVal;
+    while ( curr != NULL )
+    {
+        if ( curr->type == XML_ELEMENT_NODE && strcmp( (const char*) curr->name , itemName ) == 0 )
+            return curr;
+        curr = curr->next;
+    }
+    return NULL;
 }
 
-bool XmlManagerBase::Read(const std::string& name, xmlNode* rootNode, bool* value)
+xmlNode* XmlManagerBase::NextArrayItem(xmlNode* e, xmlNode* prev, const xmPath& path)
 {
-    std::string key(name);
+    xmlNode* curr = ( prev == NULL ) ? e->children : prev->next;
+    size_t last = path.Count() - 1;
 
-    if ( rootNode == NULL )
-        throw NgoErrorInvalidArgument(2,"trying to read from an undefined rootNode","XmlManagerBase::Read");
+    while ( curr != NULL )
+    {
+        if ( curr->type == XML_ELEMENT_NODE && path.Matches( last , (const char*) curr->name ) )
+            return curr;
+        curr = curr->next;
+    }
+    return NULL;
+}
 
-    xmlNode* e = AssertPath( key, rootNode, false );
-    if ( e == NULL )
-        return false;
+/* same split as the string arrays : a single segment names both the array node and its items */
+xmlNode* XmlManagerBase::FindArrayNode(const xmPath& path, xmlNode* rootNode)
+{
+    if ( path.Count() == 0 )
+        throw NgoErrorInvalidArgument(1,"an array path needs at least one segment","XmlManagerBase::ReadArray");
 
-    xmlNode *n = GetUniqElement(e, key, false);
-    if ( n == NULL )
-        return false;
+    return WalkPath( path , rootNode , false , path.Count() > 1 ? path.Count() - 1 : 1 );
+}
 
-   xmlChar * content = xmlNodeGetContent(n);
-   std::string str = (const char*) content ;
-   xmlFree(content);
+size_t XmlManagerBase::CountArrayItems(xmlNode* e, const std::string& item)
+{
+    size_t count = 0;
+    for ( xmlNode* n = NextArrayItem( e , NULL , item ); n != NULL; n = NextArrayItem( e , n , item ) )
+        ++count;
+    return count;
+}
 
-	 if( !str.empty() )
-	 {
-			std::stringstream sStream;
-			sStream << str;
-			sStream >> *value;
+size_t XmlManagerBase::CountArray(const std::string& name, xmlNode* rootNode)
+{
+    std::string item;
+    xmlNode* e = FindArrayNode( name , rootNode , &item );
+    return e != NULL ? CountArrayItems( e , item ) : 0;
+}
 
-			if( NaN( *value ) )
-				return false;
+size_t XmlManagerBase::CountArray(const xmPath& path, xmlNode* rootNode)
+{
+    xmlNode* e = FindArrayNode( path , rootNode );
+    size_t count = 0;
+    if ( e != NULL )
+        for ( xmlNode* n = NextArrayItem( e , NULL , path ); n != NULL; n = NextArrayItem( e , n , path ) )
+            ++count;
+    return count;
+}
 
-	 }else{
-			return false;
-	 }
+void XmlManagerBase::AppendArrayItem(xmlNode* e, const std::string& item, const char* text)
+{
+    xmlNode *Child = xmlAddChild( e , NewElement( e->doc , item.c_str() ) );
+    SetNodeText( Child , text );
+}
 
-    return true;
+void XmlManagerBase::RewriteArrayItem(xmlNode* n, const char* text)
+{
+    /* periodic dumps mostly write back the same values */
+    xmlNode* t = n->children;
+    if ( t != NULL && t->next == NULL && t->type == XML_TEXT_NODE &&
+         t->content != NULL && strcmp( (const char*) t->content , text ) == 0 )
+        return;
 
+    SetNodeText( n , text );
 }
 
+void XmlManagerBase::DeleteArrayItems(xmlNode* e, xmlNode* n, const std::string& item)
+{
+    while ( n != NULL )
+    {
+        xmlNode* next = NextArrayItem( e , n , item );
+        DetachNode( n );
+        n = next;
+    }
+}
 
-void XmlManagerBase::Write(const std::string& name,   xmlNode* rootNode, double value)
+const char* XmlManagerBase::AttributeText(xmlNode* n, const std::string& attribute, std::string* scratch)
 {
-    std::string key(name);
+    xmlAttr* attr = xmlHasProp( n , (const xmlChar*) attribute.c_str() );
+    if ( attr == NULL )
+        return NULL;
 
-    if ( rootNode == NULL )
-        throw NgoErrorInvalidArgument(2,"trying to write to an undefined rootNode","XmlManagerBase::Write");
+    xmlNode* text = attr->children;
+    if ( text == NULL )
+        return "";
+    if ( text->next == NULL && text->type == XML_TEXT_NODE && text->content != NULL )
+        return (const char*) text->content;
 
-    xmlNode* node = AssertPath(key,rootNode);
-    xmlNode* e = GetUniqElement( node , key );
+    xmlChar* prop = xmlNodeListGetString( n->doc , attr->children , 1 );
+    scratch->assign( prop != NULL ? (const char*) prop : "" );
+    xmlFree(prop);
+    return scratch->c_str();
+}
 
-    std::stringstream sStream;
-    sStream.precision(12);
-    sStream << std::scientific << value;
+void XmlManagerBase::SetAttributeText(xmlNode* n, const std::string& attribute, const char* value)
+{
+    if ( Journaling() )
+        JournalValue( n , xmChangeSetAttribute , attribute.c_str() , value );
+    IndexAttribute( n , attribute , value );
 
-    std::string val;
-    sStream >> val;
+    /* xmlSetProp replaces the value of an existing attribute or creates it */
+    xmlSetProp( n , (const xmlChar*) attribute.c_str() , (const xmlChar*) value );
+    NotifyChange( n );
+}
 
-    xmlNodeSetContent( e , (const xmlChar*) val.c_str() );
+/* ------------------------------------------------------------------------------------------------------------------
+*  Write and read values
+*  Regardless of namespaces, the string keys app_path and data_path always refer to the location of the application's executable
+*  and the data path, respectively. These values are never saved to the configuration, but kept in static variables.
+*  The application makes use of this by "writing" to the configuration file after determining these values at runtime.
+*/
+void XmlManagerBase::Write(const std::string& name, xmlNode* pathNode,  const std::string& value, bool ignoreEmpty)
+{
+    if (ignoreEmpty && value.empty())
+    {
+        //UnSet(name);
+        return;
+    }
 
+    WriteValue( name , pathNode , value );
 }
 
-double  XmlManagerBase::ReadDouble(const std::string& name,  xmlNode* rootNode,  double defaultVal)
+std::string XmlManagerBase::Read(const std::string& name, xmlNode* rootNode, const std::string& defaultVal)
 {
-    double ret;
+    std::string ret;
 
-    if (Read(name, rootNode , &ret))
+    if (Read(name, &ret, rootNode))
         return ret;
     else
         return defaultVal;
 }
 
-bool XmlManagerBase::Read(const std::string& name,  xmlNode* rootNode, double* value)
+bool XmlManagerBase::Read(const std::string& name, std::string* str, xmlNode* rootNode )
 {
-    std::string key(name);
-
-    if ( rootNode == NULL )
-        throw NgoErrorInvalidArgument(2,"trying to read from an undefined rootNode","XmlManagerBase::Read");
+    return ReadValue( name , rootNode , str );
+}
 
-    xmlNode* e = AssertPath( key, rootNode, false );
-    if ( e == NULL )
-        return false;
+/*--------------------------------------------------------------------------------------------------------------------------------------------------
+* Writing and Reading ints
+---------------------------------------------------------------------------------------------------------------------------------------------------*/
+void XmlManagerBase::Write(const std::string& name, xmlNode* rootNode,  int value)
+{
+    WriteValue( name , rootNode , value );
+}
 
-    xmlNode *n = GetUniqElement(e, key, false);
-    if ( n == NULL )
-        return false;
+int  XmlManagerBase::ReadInt(const std::string& name, xmlNode* rootNode,  int defaultVal)
+{
+    int ret;
 
-   xmlChar * content = xmlNodeGetContent(n);
-   std::string str = (const char*) content ;
-   xmlFree(content);
-	 if( !str.empty() )
-	 {
-			std::stringstream sStream;
-			sStream << str;
-			sStream >> *value;
+    if (Read(name, rootNode, &ret))
+        return ret;
+    else
+        return defaultVal;
+}
 
-			if( NaN( *value ) )
-				return false;
+bool XmlManagerBase::Read(const std::string& name, xmlNode* rootNode ,  int* value)
+{
+    return ReadValue( name , rootNode , value );
+}
 
-	 }else{
-			return false;
-	 }
-    return true;
+/*--------------------------------------------------------------------------------------------------------------------------------------------------
+* Writing and Reading bools
+---------------------------------------------------------------------------------------------------------------------------------------------------*/
+void XmlManagerBase::Write(const std::string& name, xmlNode* rootNode,  bool value)
+{
+    WriteValue( name , rootNode , value );
 }
 
-void XmlManagerBase::Write(const std::string& name, xmlNode* rootNode,  const std::vector<std::string>& arrayString)
+bool  XmlManagerBase::ReadBool(const std::string& name, xmlNode* rootNode,  bool defaultVal)
 {
-   size_t found = name.find_last_of("/");
-//   std::string key(name);
-   std::string key = name.substr(0,found);
-   std::string last = name.substr(found+1);
+    bool ret;
 
-    if ( rootNode == NULL )
-        throw NgoErrorInvalidArgument(2,"trying to write to an undefined rootNode","XmlManagerBase::Write");
+    if (Read(name, rootNode, &ret))
+        return ret;
+    else
+        return defaultVal;
+}
 
-    xmlNode* node = AssertPath(key,rootNode);
-    xmlNode* e = GetUniqElement( node , key );
-    xmlReplaceNode( e , NULL );
-    e = GetUniqElement(node,key);
+bool XmlManagerBase::Read(const std::string& name, xmlNode* rootNode, bool* value)
+{
+    return ReadValue( name , rootNode , value );
+}
 
-    for (unsigned int i = 0; i < arrayString.size(); ++i)
-    {
-//        xmlNode *Child = xmlNewNode( NULL, (const xmlChar*) "value" );
-        xmlNode *Child = xmlNewNode( NULL, (const xmlChar*) last.c_str() );
-        xmlNodeSetContent( Child , (const xmlChar*) arrayString[i].c_str() );
-        xmlAddChild( e , Child );
-    }
+/*--------------------------------------------------------------------------------------------------------------------------------------------------
+* Writing and Reading doubles
+---------------------------------------------------------------------------------------------------------------------------------------------------*/
+void XmlManagerBase::Write(const std::string& name,   xmlNode* rootNode, double value)
+{
+    WriteValue( name , rootNode , value );
 }
 
-void XmlManagerBase::Read(const std::string& name, xmlNode* rootNode, std::vector<std::string> *arrayString)
+double  XmlManagerBase::ReadDouble(const std::string& name,  xmlNode* rootNode,  double defaultVal)
 {
-   size_t found = name.find_last_of("/");
-//   std::string key(name);
-   std::string key = name.substr(0,found);
-   std::string last = name.substr(found+1);
+    double ret;
 
-    if ( rootNode == NULL )
-        throw NgoErrorInvalidArgument(2,"trying to read from an undefined rootNode","XmlManagerBase::Read");
+    if (Read(name, rootNode , &ret))
+        return ret;
+    else
+        return defaultVal;
+}
 
-    xmlNode* e = AssertPath( key, rootNode, false );
-    if ( e == NULL )
-        return;
+bool XmlManagerBase::Read(const std::string& name,  xmlNode* rootNode, double* value)
+{
+    return ReadValue( name , rootNode , value );
+}
 
-    xmlNode *n = GetUniqElement(e, key, false);
-    if ( n == NULL )
-        return;
+/*--------------------------------------------------------------------------------------------------------------------------------------------------
+* Writing and Reading arrays
+---------------------------------------------------------------------------------------------------------------------------------------------------*/
+void XmlManagerBase::Write(const std::string& name, xmlNode* rootNode,  const std::vector<std::string>& arrayString)
+{
+    WriteArray( name , rootNode , arrayString );
+}
 
-    xmlNode *curr = n->children;
-    while ( (curr != NULL) )
-    {
-		  std::string currName = (const char*) curr->name ;
-//		  if( currName == "value" ){
-		  if( currName == last ){
-            xmlChar * value = xmlNodeGetContent(curr);
-            std::string Value = (const char*) value ;
-            xmlFree(value);
-				arrayString->push_back( Value );
-        }
-        curr = curr->next;
-    }
+void XmlManagerBase::Read(const std::string& name, xmlNode* rootNode, std::vector<std::string> *arrayString)
+{
+    ReadArray( name , rootNode , arrayString );
 }
 
 std::vector<std::string> XmlManagerBase::ReadStdArrayString(const std::string& name, xmlNode* rootNode)
@@ -554,72 +668,12 @@ std::vector<std::string> XmlManagerBase::ReadStdArrayString(const std::string& n
 
 void XmlManagerBase::Write(const std::string& name, xmlNode* rootNode,  const std::vector<int>& arrayInt)
 {
-   size_t found = name.find_last_of("/");
-//   std::string key(name);
-   std::string key = name.substr(0,found);
-   std::string last = name.substr(found+1);
-
-    if ( rootNode == NULL )
-        throw NgoErrorInvalidArgument(2,"trying to write to an undefined rootNode","XmlManagerBase::Write");
-
-    xmlNode* node = AssertPath(key,rootNode);
-    xmlNode* e = GetUniqElement( node , key );
-    xmlReplaceNode( e , NULL );
-    e = GetUniqElement(node,key);
-
-    for (unsigned int i = 0; i < arrayInt.size(); ++i)
-    {
-//        xmlNode *Child = xmlNewNode( NULL, (const xmlChar*) "value" );
-        xmlNode *Child = xmlNewNode( NULL, (const xmlChar*) last.c_str() );
-        std::string val;
-        std::stringstream sStream;
-        sStream << arrayInt[i] ;
-        sStream >> val;
-        xmlNodeSetContent( Child , (const xmlChar*) val.c_str() );
-        xmlAddChild( e , Child );
-    }
+    WriteArray( name , rootNode , arrayInt );
 }
 
 void XmlManagerBase::Read(const std::string& name, xmlNode* rootNode, std::vector<int> *arrayInt)
 {
-   size_t found = name.find_last_of("/");
-//   std::string key(name);
-   std::string key = name.substr(0,found);
-   std::string last = name.substr(found+1);
-
-    if ( rootNode == NULL )
-        throw NgoErrorInvalidArgument(2,"trying to read from an undefined rootNode","XmlManagerBase::Read");
-
-    xmlNode* e = AssertPath( key, rootNode, false );
-    if ( e == NULL )
-        return;
-
-    xmlNode *n = GetUniqElement(e, key, false);
-    if ( n == NULL )
-        return;
-
-    xmlNode *curr = n->children;
-    while ( (curr != NULL) )
-    {
-		 std::string currName = (const char*) curr->name ;
-//		  if( currName == "value" ){
-		  if( currName == last ){
-               xmlChar * value = xmlNodeGetContent( curr );
-					std::string Value = (const char*) value;
-					xmlFree(value);
-					if( !Value.empty() )
-					{
-							std::stringstream sStream;
-							sStream << Value;
-							int val;
-							sStream >> val;
-							arrayInt->push_back( val );
-					}else{
-							arrayInt->push_back(-1);
-					}
-		  }
-        curr = curr->next;
-    }
+    ReadArray( name , rootNode , arrayInt , -1 );
 }
 
 std::vector<int> XmlManagerBase::ReadStdArrayInt(const std::string& name, xmlNode* rootNode)
@@ -631,72 +685,12 @@ std::vector<int> XmlManagerBase::ReadStdArrayInt(const std::string& name, xmlNod
 
 void XmlManagerBase::Write(const std::string& name, xmlNode* rootNode,  const std::vector<bool>& arrayBool)
 {
-   size_t found = name.find_last_of("/");
-//   std::string key(name);
-   std::string key = name.substr(0,found);
-   std::string last = name.substr(found+1);
-
-    if ( rootNode == NULL )
-        throw NgoErrorInvalidArgument(2,"trying to write to an undefined rootNode","XmlManagerBase::Write");
-
-    xmlNode* node = AssertPath(key,rootNode);
-    xmlNode* e = GetUniqElement( node , key );
-    xmlReplaceNode( e , NULL );
-    e = GetUniqElement(node,key);
-
-    for (unsigned int i = 0; i < arrayBool.size(); ++i)
-    {
-//        xmlNode *Child = xmlNewNode( NULL, (const xmlChar*) "value" );
-        xmlNode *Child = xmlNewNode( NULL, (const xmlChar*) last.c_str() );
-        std::string val;
-        std::stringstream sStream;
-        sStream << arrayBool[i] ;
-        sStream >> val;
-        xmlNodeSetContent( Child , (const xmlChar*) val.c_str() );
-        xmlAddChild( e , Child );
-    }
+    WriteArray( name , rootNode , arrayBool );
 }
 
 void XmlManagerBase::Read(const std::string& name, xmlNode* rootNode, std::vector<bool>*arrayBool)
 {
-   size_t found = name.find_last_of("/");
-//   std::string key(name);
-   std::string key = name.substr(0,found);
-   std::string last = name.substr(found+1);
-
-    if ( rootNode == NULL )
-        throw NgoErrorInvalidArgument(2,"trying to read from an undefined rootNode","XmlManagerBase::Read");
-
-    xmlNode* e = AssertPath( key, rootNode, false );
-    if ( e == NULL )
-        return;
-
-    xmlNode *n = GetUniqElement(e, key, false);
-    if ( n == NULL )
-        return;
-
-    xmlNode *curr = n->children;
-    while ( (curr != NULL) )
-    {
-        std::string currName = (const char*) curr->name ;
-//		  if( currName == "value" ){
-		  if( currName == last.c_str() ){
-               xmlChar * value = xmlNodeGetContent( curr );
-					std::string Value = (const char*) value;
-					xmlFree(value);
-					if( !Value.empty() )
-					{
-							std::stringstream sStream;
-							sStream << Value;
-							bool val;
-							sStream >> val;
-							arrayBool->push_back( val );
-					}else{
-							arrayBool->push_back(false);
-					}
-		  }
-        curr = curr->next;
-    }
+    ReadArray( name , rootNode , arrayBool , false );
 }
 
 std::vector<bool> XmlManagerBase::ReadStdArrayBool(const std::string& name, xmlNode* rootNode)
@@ -708,73 +702,12 @@ std::vector<bool> XmlManagerBase::ReadStdArrayBool(const std::string& name, xmlN
 
 void XmlManagerBase::Write(const std::string& name, xmlNode* rootNode,  const std::vector<double>& arrayDouble)
 {
-   size_t found = name.find_last_of("/");
-//   std::string key(name);
-   std::string key = name.substr(0,found);
-   std::string last = name.substr(found+1);
-
-    if ( rootNode == NULL )
-        throw NgoErrorInvalidArgument(2,"trying to write to an undefined rootNode","XmlManagerBase::Write");
-
-    xmlNode* node = AssertPath(key,rootNode);
-    xmlNode* e = GetUniqElement( node , key );
-//    xmlReplaceNode( e , NULL );
-//    e = GetUniqElement(node,key);
-
-    for (unsigned int i = 0; i < arrayDouble.size(); ++i)
-    {
-//        xmlNode *Child = xmlNewNode( NULL, (const xmlChar*) "value" );
-        xmlNode *Child = xmlNewNode( NULL, (const xmlChar*) last.c_str() );
-        std::string val;
-        std::stringstream sStream;
-        sStream.precision(12);
-        sStream << std::scientific << arrayDouble[i] ;
-        sStream >> val;
-        xmlNodeSetContent( Child , (const xmlChar*) val.c_str() );
-        xmlAddChild( e , Child );
-    }
+    WriteArray( name , rootNode , arrayDouble );
 }
 
 void XmlManagerBase::Read(const std::string& name, xmlNode* rootNode, std::vector<double>*arrayDouble)
 {
-   size_t found = name.find_last_of("/");
-//   std::string key(name);
-   std::string key = name.substr(0,found);
-   std::string last = name.substr(found+1);
-
-    if ( rootNode == NULL )
-        throw NgoErrorInvalidArgument(2,"trying to read from an undefined rootNode","XmlManagerBase::Read");
-
-    xmlNode* e = AssertPath( key, rootNode, false );
-    if ( e == NULL )
-        return;
-
-    xmlNode *n = GetUniqElement(e, key, false);
-    if ( n == NULL )
-        return;
-
-    xmlNode *curr = n->children;
-    while ( (curr != NULL) )
-    {
-        std::string currName = (const char*) curr->name ;
-//		  if( currName == "value" ){
-		  if( currName == last ){
-               xmlChar * value = xmlNodeGetContent( curr );
-					std::string Value = (const char*) value;
-					xmlFree(value);
-					if( !Value.empty() )
-					{
-							std::stringstream sStream;
-							sStream << Value;
-							double val;
-							sStream >> val;
-							arrayDouble->push_back( val );
-					}else{
-							arrayDouble->push_back(-1);
-					}
-		  }
-        curr = curr->next;
-    }
+    ReadArray( name , rootNode , arrayDouble , -1.0 );
 }
 
 std::vector<double> XmlManagerBase::ReadStdArrayDouble(const std::string& name, xmlNode* rootNode)
@@ -812,6 +745,19 @@ std::vector<std::string> XmlManagerBase::EnumerateChildrens(const std::string& p
     return ret;
 }
 
+XmlManagerChildRange XmlManagerBase::Children(const std::string& path, xmlNode* rootNode)
+{
+    if ( rootNode == NULL )
+        throw NgoErrorInvalidArgument(2,"trying to enumerate children from an undefined rootNode","XmlManagerBase::Children");
+
+    return XmlManagerChildRange( GetNode( path , rootNode , false ) );
+}
+
+XmlManagerChildRange XmlManagerBase::Children(const xmPath& path, xmlNode* rootNode)
+{
+    return XmlManagerChildRange( GetNode( path , rootNode , false ) );
+}
+
 void XmlManagerBase::DeleteChildrens(const std::string& strPath, xmlNode* rootNode)
 {
     std::string key(strPath);
@@ -827,6 +773,9 @@ void XmlManagerBase::DeleteChildrens(const std::string& strPath, xmlNode* rootNo
     if ( n == NULL )
         return ;
 
+    if ( Journaling() )
+        JournalValue( n , xmChangeClear , NULL , NULL );
+
     xmlNode *child = n->children;
 
     while ( child != NULL )
@@ -834,60 +783,141 @@ void XmlManagerBase::DeleteChildrens(const std::string& strPath, xmlNode* rootNo
         xmlNode* sub = child;
         child = child->next;
 
-        xmlReplaceNode( sub , NULL );
+        DetachNode( sub );
     }
+    NotifyChange( n );
 
     return ;
 }
 
-void XmlManagerBase::WriteAttribute(const std::string& name,  xmlNode* rootNode, const std::string& attribute, const std::string& value,  bool ignoreEmpty)
+xmlNode* XmlManagerBase::GetNode(const std::string& name, xmlNode* rootNode, bool create_unexisting)
 {
+    StatsScope scope( this , xmStatsGetNode );
     std::string key(name);
 
     if ( rootNode == NULL )
-        throw NgoErrorInvalidArgument(2,"trying to write an attribute to an undefined rootNode","XmlManagerBase::WriteAttribute");
+        throw NgoErrorInvalidArgument(2,"trying to get a node from an undefined rootNode","XmlManagerBase::GetNode");
 
-    xmlNode* node = AssertPath(key,rootNode);
-    xmlNode* e = GetUniqElement( node , key );
+    xmlNode* e = AssertPath( key, rootNode, create_unexisting );
+    if ( e == NULL )
+        return NULL;
 
-    if ( value.empty() && !ignoreEmpty )
+    return GetUniqElement( e, key, create_unexisting );
+}
+
+void XmlManagerBase::DeleteNode(xmlNode* node)
+{
+    if ( node == NULL )
+        throw NgoErrorInvalidArgument(1,"trying to delete an undefined node","XmlManagerBase::DeleteNode");
+
+    xmlNode* parent = node->parent;
+    if ( Journaling() )
+        JournalDelete( node );
+    DetachNode( node );
+    if ( parent != NULL )
+        NotifyChange( parent );
+}
+
+void XmlManagerBase::DetachNode(xmlNode* node)
+{
+    UnindexNode( node );
+    DropSubscriptions( node , true );
+    xmlUnlinkNode( node );
+    ReleaseNode( node );
+}
+
+/* below this number of top level childrens a parallel visit is not worth the thread start up */
+static const size_t s_parallelVisitMinChildrens = 64;
+
+/* pre-order walk of the element subtree rooted at top, without recursion */
+static void VisitSubtree(xmlNode* top, unsigned int depth, XmlManagerVisitor& visitor)
+{
+    if ( top->type != XML_ELEMENT_NODE )
         return;
 
-    xmlAttr* attr = xmlHasProp( e , (const xmlChar*) attribute.c_str() );
-    if ( attr != NULL )
-    {
-        xmlSetProp( e , (const xmlChar*) attribute.c_str() , (const xmlChar*) value.c_str() );
-    }
-    else
+    xmlNode* cur = top;
+    unsigned int d = depth;
+
+    for ( ;; )
     {
-        xmlNewProp( e , (const xmlChar*) attribute.c_str() , (const xmlChar*) value.c_str() );
+        bool descend = false;
+        if ( cur->type == XML_ELEMENT_NODE )
+            descend = visitor.Visit(cur, d);
+
+        if ( descend && cur->children != NULL )
+        {
+            cur = cur->children;
+            ++d;
+            continue;
+        }
+
+        while ( cur != top && cur->next == NULL )
+        {
+            cur = cur->parent;
+            --d;
+        }
+        if ( cur == top )
+            return;
+        cur = cur->next;
     }
 }
 
-bool XmlManagerBase::ReadAttribute(const std::string& name,  xmlNode* rootNode, const std::string& attribute, std::string* value )
+void XmlManagerBase::VisitChildrens(const std::string& path, xmlNode* rootNode, XmlManagerVisitor& visitor,
+                                    xmVisitMode mode, unsigned int threads)
 {
-    std::string key(name);
+    XmlManagerTraceSpan span( "XmlManagerBase::VisitChildrens" );
+    std::string key(path);
 
     if ( rootNode == NULL )
-        throw NgoErrorInvalidArgument(2,"trying to read an attribute from an undefined rootNode","XmlManagerBase::ReadAttribute");
+        throw NgoErrorInvalidArgument(2,"trying to visit children from an undefined rootNode","XmlManagerBase::VisitChildrens");
 
     xmlNode* e = AssertPath( key, rootNode, false );
     if ( e == NULL )
-        return false;
+        return ;
 
     xmlNode *n = GetUniqElement(e, key, false);
     if ( n == NULL )
-        return false;
+        return ;
 
-    xmlAttr* attr = xmlHasProp( n , (const xmlChar*) attribute.c_str() );
-    if ( attr != NULL )
+    if ( mode == xmVisitSequential )
     {
-       xmlChar * attr =  xmlGetProp( n , (const xmlChar*) attribute.c_str() );
-       value->assign( (const char*) attr);
-       xmlFree(attr);
-       return true;
+        for ( xmlNode* child = n->children; child != NULL; child = child->next )
+            VisitSubtree( child, 0, visitor );
+        return ;
     }
-    return false;
+
+    std::vector<xmlNode*> tops;
+    for ( xmlNode* child = n->children; child != NULL; child = child->next )
+        if ( child->type == XML_ELEMENT_NODE )
+            tops.push_back( child );
+
+    if ( tops.size() < s_parallelVisitMinChildrens || XmlManagerWorkPool::Workers(threads) < 2 )
+    {
+        for ( size_t i = 0; i < tops.size(); ++i )
+            VisitSubtree( tops[i], 0, visitor );
+        return ;
+    }
+
+    XmlManagerWorkPool::Run( tops.size(), [&](size_t i) { VisitSubtree( tops[i], 0, visitor ); }, threads );
+}
+
+/*--------------------------------------------------------------------------------------------------------------------------------------------------
+* Writing and Reading attributes
+---------------------------------------------------------------------------------------------------------------------------------------------------*/
+void XmlManagerBase::WriteAttribute(const std::string& name,  xmlNode* rootNode, const std::string& attribute, const std::string& value,  bool ignoreEmpty)
+{
+    StatsScope scope( this , xmStatsWriteAttribute );
+    xmlNode* e = AssertValueNode( name , rootNode );
+
+    if ( value.empty() && !ignoreEmpty )
+        return;
+
+    SetAttributeText( e , attribute , value.c_str() );
+}
+
+bool XmlManagerBase::ReadAttribute(const std::string& name,  xmlNode* rootNode, const std::string& attribute, std::string* value )
+{
+    return ReadAttributeValue( name , rootNode , attribute , value );
 }
 
 std::string XmlManagerBase::ReadAttribute(const std::string& name, xmlNode* rootNode, const std::string& attribute, const std::string& defaultVal )
@@ -901,60 +931,12 @@ std::string XmlManagerBase::ReadAttribute(const std::string& name, xmlNode* root
 
 void XmlManagerBase::WriteAttribute(const std::string& name,  xmlNode* rootNode, const std::string& attribute, const int& value )
 {
-    std::string key(name);
-
-    if ( rootNode == NULL )
-        throw NgoErrorInvalidArgument(2,"trying to write an attribute to an undefined rootNode","XmlManagerBase::WriteAttribute");
-
-    xmlNode* node = AssertPath(key,rootNode);
-    xmlNode* e = GetUniqElement( node , key );
-
-	 std::stringstream sStream;
-	 sStream << value;
-	 std::string val;
-	 sStream >> val;
-
-    xmlAttr* attr = xmlHasProp( e , (const xmlChar*) attribute.c_str() );
-    if ( attr != NULL )
-    {
-        xmlSetProp( e , (const xmlChar*) attribute.c_str() , (const xmlChar*) val.c_str() );
-    }
-    else
-    {
-        xmlNewProp( e , (const xmlChar*) attribute.c_str() , (const xmlChar*) val.c_str() );
-    }
+    WriteAttributeValue( name , rootNode , attribute , value );
 }
 
 bool XmlManagerBase::ReadAttribute(const std::string& name,  xmlNode* rootNode, const std::string& attribute, int* value )
 {
-    std::string key(name);
-
-    if ( rootNode == NULL )
-        throw NgoErrorInvalidArgument(2,"trying to read an attribute from an undefined rootNode","XmlManagerBase::ReadAttribute");
-
-    xmlNode* e = AssertPath( key, rootNode, false );
-    if ( e == NULL )
-        return false;
-
-    xmlNode *n = GetUniqElement(e, key, false);
-    if ( n == NULL )
-        return false;
-
-    xmlAttr* attr = xmlHasProp( n , (const xmlChar*) attribute.c_str() );
-    if ( attr != NULL )
-    {
-		  std::string val;
-		  xmlChar * prop = xmlGetProp( n , (const xmlChar*) attribute.c_str() );
-        val.assign( (const char*) prop);
-        xmlFree(prop);
-
-        std::stringstream sStream;
-		  sStream << val;
-
-		  sStream >> *value;
-        return true;
-    }
-    return false;
+    return ReadAttributeValue( name , rootNode , attribute , value );
 }
 
 int XmlManagerBase::ReadAttributeInt(const std::string& name, xmlNode* rootNode, const std::string& attribute, const int& defaultVal )
@@ -968,66 +950,12 @@ int XmlManagerBase::ReadAttributeInt(const std::string& name, xmlNode* rootNode,
 
 void XmlManagerBase::WriteAttribute(const std::string& name,  xmlNode* rootNode, const std::string& attribute, const bool& value )
 {
-    std::string key(name);
-
-    if ( rootNode == NULL )
-        throw NgoErrorInvalidArgument(2,"trying to write an attribute to an undefined rootNode","XmlManagerBase::WriteAttribute");
-
-    xmlNode* node = AssertPath(key,rootNode);
-    xmlNode* e = GetUniqElement( node , key );
-
-	 std::stringstream sStream;
-	 sStream << value;
-	 std::string val;
-	 sStream >> val;
-
-    xmlAttr* attr = xmlHasProp( e , (const xmlChar*) attribute.c_str() );
-    if ( attr != NULL )
-    {
-        xmlSetProp( e , (const xmlChar*) attribute.c_str() , (const xmlChar*) val.c_str() );
-    }
-    else
-    {
-        xmlNewProp( e , (const xmlChar*) attribute.c_str() , (const xmlChar*) val.c_str() );
-    }
+    WriteAttributeValue( name , rootNode , attribute , value );
 }
 
 bool XmlManagerBase::ReadAttribute(const std::string& name,  xmlNode* rootNode, const std::string& attribute, bool* value )
 {
-    std::string key(name);
-
-    if ( rootNode == NULL )
-        throw NgoErrorInvalidArgument(2,"trying to read an attribute from an undefined rootNode","XmlManagerBase::ReadAttribute");
-
-    xmlNode* e = AssertPath( key, rootNode, false );
-    if ( e == NULL )
-        return false;
-
-    xmlNode *n = GetUniqElement(e, key, false);
-    if ( n == NULL )
-        return false;
-
-    xmlAttr* attr = xmlHasProp( n , (const xmlChar*) attribute.c_str() );
-    if ( attr != NULL )
-    {
-		  std::string val;
-		  xmlChar * prop = xmlGetProp( n , (const xmlChar*) attribute.c_str() );
-        val.assign( (const char*) prop);
-        xmlFree(prop);
-
-        std::stringstream sStream;
-		  sStream << val;
-
-		  sStream >> *value;
-
-        if (val=="true")
-           *value = true;
-        if (val=="false")
-           *value = false;
-
-        return true;
-    }
-    return false;
+    return ReadAttributeValue( name , rootNode , attribute , value );
 }
 
 bool XmlManagerBase::ReadAttributeBool(const std::string& name, xmlNode* rootNode, const std::string& attribute, const bool& defaultVal )
@@ -1035,75 +963,18 @@ bool XmlManagerBase::ReadAttributeBool(const std::string& name, xmlNode* rootNod
    bool ret;
    if ( ReadAttribute( name , rootNode, attribute, &ret ) )
        return ret;
-   else
-   {
-      std::string boolstring;
-      if ( ReadAttribute( name , rootNode, attribute, &boolstring ) )
-      {
-         if (boolstring == "false")
-            return false;
-         if (boolstring == "true")
-            return true;
-      }
-   }
 
    return defaultVal;
 }
 
 void XmlManagerBase::WriteAttribute(const std::string& name,  xmlNode* rootNode, const std::string& attribute, const double& value )
 {
-    std::string key(name);
-
-    if ( rootNode == NULL )
-        throw NgoErrorInvalidArgument(2,"trying to write an attribute to an undefined rootNode","XmlManagerBase::WriteAttribute");
-
-    xmlNode* node = AssertPath(key,rootNode);
-    xmlNode* e = GetUniqElement( node , key );
-
-	 std::stringstream sStream;
-	 sStream << value;
-	 std::string val;
-	 sStream >> val;
-
-    xmlAttr* attr = xmlHasProp( e , (const xmlChar*) attribute.c_str() );
-    if ( attr != NULL )
-    {
-        xmlSetProp( e , (const xmlChar*) attribute.c_str() , (const xmlChar*) val.c_str() );
-    }
-    else
-    {
-        xmlNewProp( e , (const xmlChar*) attribute.c_str() , (const xmlChar*) val.c_str() );
-    }
+    WriteAttributeValue( name , rootNode , attribute , value );
 }
 
 bool XmlManagerBase::ReadAttribute(const std::string& name,  xmlNode* rootNode, const std::string& attribute, double* value )
 {
-    std::string key(name);
-
-    if ( rootNode == NULL )
-        throw NgoErrorInvalidArgument(2,"trying to read an attribute from an undefined rootNode","XmlManagerBase::ReadAttribute");
-
-    xmlNode* e = AssertPath( key, rootNode, false );
-    if ( e == NULL )
-        return false;
-
-    xmlNode *n = GetUniqElement(e, key, false);
-    if ( n == NULL )
-        return false;
-
-    xmlAttr* attr = xmlHasProp( n , (const xmlChar*) attribute.c_str() );
-    if ( attr != NULL )
-    {
-		  std::string val;
-        val.assign( (const char*) xmlGetProp( n , (const xmlChar*) attribute.c_str() ) );
-
-        std::stringstream sStream;
-		  sStream << val;
-
-		  sStream >> *value;
-        return true;
-    }
-    return false;
+    return ReadAttributeValue( name , rootNode , attribute , value );
 }
 
 double XmlManagerBase::ReadAttributeDouble(const std::string& name, xmlNode* rootNode, const std::string& attribute, const double& defaultVal )
@@ -0,0 +1,41 @@
+/**
+*			@file XmlManagerBinding.cpp
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*/
+/*******************************************************************************
+   LICENSE
+*******************************************************************************
+ Copyright (C) 2009 Numengo (admin@numengo.com)
+
+ This document is released under the terms of the numenGo EULA.  You should have received a
+ copy of the numenGo EULA along with this file; see  the file LICENSE.TXT. If not, write at
+ admin@numengo.com or at NUMENGO, 15 boulevard Vivier Merle, 69003 LYON - FRANCE
+ You are not allowed to use, copy, modify or distribute this file unless you  conform to numenGo
+ EULA license.
+*/
+
+#include <xmlmgr/XmlManagerBinding.h>
+
+/* readers and writers of the XmlManagerGlobals.h structures, exported by the library */
+template bool XmlManagerBase::ReadStruct<xmNumengoReference>(const std::string&, xmlNode*, xmNumengoReference*);
+template void XmlManagerBase::WriteStruct<xmNumengoReference>(const std::string&, xmlNode*, const xmNumengoReference&);
+template bool XmlManagerBase::ReadStruct<xmLibrarySubSytem>(const std::string&, xmlNode*, xmLibrarySubSytem*);
+template void XmlManagerBase::WriteStruct<xmLibrarySubSytem>(const std::string&, xmlNode*, const xmLibrarySubSytem&);
+template bool XmlManagerBase::ReadStruct<xmArrayLibrarySubSystems>(const std::string&, xmlNode*, xmArrayLibrarySubSystems*);
+template void XmlManagerBase::WriteStruct<xmArrayLibrarySubSystems>(const std::string&, xmlNode*, const xmArrayLibrarySubSystems&);
+template bool XmlManagerBase::ReadStruct<xmDynamicLibrary>(const std::string&, xmlNode*, xmDynamicLibrary*);
+template void XmlManagerBase::WriteStruct<xmDynamicLibrary>(const std::string&, xmlNode*, const xmDynamicLibrary&);
+template bool XmlManagerBase::ReadStruct<xmValueUnit>(const std::string&, xmlNode*, xmValueUnit*);
+template void XmlManagerBase::WriteStruct<xmValueUnit>(const std::string&, xmlNode*, const xmValueUnit&);
+template bool XmlManagerBase::ReadStruct<xmTemperaturePressureDensity>(const std::string&, xmlNode*, xmTemperaturePressureDensity*);
+template void XmlManagerBase::WriteStruct<xmTemperaturePressureDensity>(const std::string&, xmlNode*, const xmTemperaturePressureDensity&);
+template bool XmlManagerBase::ReadStruct<xmElement>(const std::string&, xmlNode*, xmElement*);
+template void XmlManagerBase::WriteStruct<xmElement>(const std::string&, xmlNode*, const xmElement&);
+template bool XmlManagerBase::ReadStruct<xmArrayElement>(const std::string&, xmlNode*, xmArrayElement*);
+template void XmlManagerBase::WriteStruct<xmArrayElement>(const std::string&, xmlNode*, const xmArrayElement&);
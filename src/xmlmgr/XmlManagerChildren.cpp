@@ -0,0 +1,63 @@
+/**
+*			@file XmlManagerChildren.cpp
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*/
+/*******************************************************************************
+   LICENSE
+*******************************************************************************
+ Copyright (C) 2009 Numengo (admin@numengo.com)
+
+ This document is released under the terms of the numenGo EULA.  You should have received a
+ copy of the numenGo EULA along with this file; see  the file LICENSE.TXT. If not, write at
+ admin@numengo.com or at NUMENGO, 15 boulevard Vivier Merle, 69003 LYON - FRANCE
+ You are not allowed to use, copy, modify or distribute this file unless you  conform to numenGo
+ EULA license.
+*/
+
+#include <xmlmgr/XmlManagerBase.h>
+#include <xmlmgr/XmlManagerChildren.h>
+
+#include <libxml/tree.h>
+
+/* first element node from n on */
+static inline xmlNode* SkipToElement(xmlNode* n)
+{
+    while ( n != NULL && n->type != XML_ELEMENT_NODE )
+        n = n->next;
+    return n;
+}
+
+XmlManagerChildIterator::XmlManagerChildIterator(xmlNode* n)
+    : m_node( SkipToElement( n ) )
+{
+}
+
+const char* XmlManagerChildIterator::Name() const
+{
+    return (const char*) m_node->name;
+}
+
+XmlManagerChildIterator& XmlManagerChildIterator::operator++()
+{
+    m_node = SkipToElement( m_node->next );
+    return *this;
+}
+
+XmlManagerChildRange::XmlManagerChildRange(xmlNode* parent)
+    : m_first( parent != NULL ? SkipToElement( parent->children ) : NULL )
+{
+}
+
+size_t XmlManagerChildRange::size() const
+{
+    size_t count = 0;
+    for ( xmlNode* n = m_first; n != NULL; n = SkipToElement( n->next ) )
+        ++count;
+    return count;
+}
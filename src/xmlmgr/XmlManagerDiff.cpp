@@ -0,0 +1,466 @@
+/**
+*			@file XmlManagerDiff.cpp
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*/
+/*******************************************************************************
+   LICENSE
+*******************************************************************************
+ Copyright (C) 2009 Numengo (admin@numengo.com)
+
+ This document is released under the terms of the numenGo EULA.  You should have received a
+ copy of the numenGo EULA along with this file; see  the file LICENSE.TXT. If not, write at
+ admin@numengo.com or at NUMENGO, 15 boulevard Vivier Merle, 69003 LYON - FRANCE
+ You are not allowed to use, copy, modify or distribute this file unless you  conform to numenGo
+ EULA license.
+*/
+
+#include <xmlmgr/XmlManagerBase.h>
+#include "ngoerr/NgoError.h"
+
+#include <libxml/tree.h>
+#include <libxml/parser.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+/* element childrens of a node grouped by name, in the order of the first occurrence of each name */
+typedef std::vector<std::pair<std::string, std::vector<xmlNode*> > > ChildGroups;
+
+static void GroupChildrens(xmlNode* n, ChildGroups* groups)
+{
+    std::map<std::string, size_t> position;
+    for ( xmlNode* child = ( n != NULL ) ? n->children : NULL; child != NULL; child = child->next )
+    {
+        if ( child->type != XML_ELEMENT_NODE )
+            continue;
+
+        std::string name( (const char*) child->name );
+        std::map<std::string, size_t>::iterator it = position.find( name );
+        if ( it == position.end() )
+        {
+            position[name] = groups->size();
+            groups->push_back( std::make_pair( name , std::vector<xmlNode*>( 1 , child ) ) );
+        }
+        else
+            (*groups)[it->second].second.push_back( child );
+    }
+}
+
+static const std::vector<xmlNode*>* FindGroup(const ChildGroups& groups, const std::string& name)
+{
+    for ( size_t i = 0; i < groups.size(); ++i )
+        if ( groups[i].first == name )
+            return &groups[i].second;
+    return NULL;
+}
+
+static bool HasElementChildren(xmlNode* n)
+{
+    for ( xmlNode* child = n->children; child != NULL; child = child->next )
+        if ( child->type == XML_ELEMENT_NODE )
+            return true;
+    return false;
+}
+
+/* true if the nodes are plain array items : leaves without attributes */
+static bool AreArrayItems(const std::vector<xmlNode*>& nodes)
+{
+    for ( size_t i = 0; i < nodes.size(); ++i )
+        if ( nodes[i]->properties != NULL || HasElementChildren( nodes[i] ) )
+            return false;
+    return true;
+}
+
+static std::string DumpNodes(const std::vector<xmlNode*>& nodes)
+{
+    std::string ret;
+    xmlBuffer* buffer = xmlBufferCreate();
+    for ( size_t i = 0; i < nodes.size(); ++i )
+    {
+        xmlBufferEmpty( buffer );
+        xmlNodeDump( buffer , nodes[i]->doc , nodes[i] , 0 , 0 );
+        ret.append( (const char*) xmlBufferContent( buffer ) , xmlBufferLength( buffer ) );
+    }
+    xmlBufferFree( buffer );
+    return ret;
+}
+
+static std::string PropValue(xmlNode* n, xmlAttr* attr)
+{
+    xmlChar* value = xmlNodeListGetString( n->doc , attr->children , 1 );
+    std::string ret( value != NULL ? (const char*) value : "" );
+    xmlFree(value);
+    return ret;
+}
+
+static std::string ChildPath(const std::string& path, const std::string& name)
+{
+    return path.empty() ? name : path + "/" + name;
+}
+
+static void AddChange(xmChangeSet* changes, xmChangeType type, const std::string& path,
+                      const std::string& attribute, const std::string& value)
+{
+    changes->push_back( xmChange() );
+    xmChange& c = changes->back();
+    c.type = type;
+    c.path = path;
+    c.attribute = attribute;
+    c.value = value;
+}
+
+void XmlManagerBase::Diff(xmlNode* from, xmlNode* to, xmChangeSet* changes)
+{
+    XmlManagerTraceSpan span( "XmlManagerBase::Diff" );
+    if ( from == NULL || to == NULL || changes == NULL )
+        throw NgoErrorInvalidArgument(1,"trying to diff undefined nodes","XmlManagerBase::Diff");
+
+    /* pairs of matched nodes still to compare, the old node is NULL for added subtrees */
+    struct Pending
+    {
+        xmlNode* from;
+        xmlNode* to;
+        std::string path;
+    };
+    std::vector<Pending> pending( 1 );
+    pending[0].from = from;
+    pending[0].to = to;
+
+    std::string scratchFrom, scratchTo;
+
+    while ( !pending.empty() )
+    {
+        Pending p = pending.back();
+        pending.pop_back();
+
+        bool leaf = !HasElementChildren( p.to );
+
+        if ( leaf )
+        {
+            const char* text = NodeText( p.to , &scratchTo );
+            if ( p.from == NULL || HasElementChildren( p.from ) || strcmp( NodeText( p.from , &scratchFrom ) , text ) != 0 )
+                AddChange( changes , xmChangeSetValue , p.path , "" , text );
+        }
+        else if ( p.from != NULL && !p.path.empty() && !HasElementChildren( p.from ) && *NodeText( p.from , &scratchFrom ) != '\0' )
+        {
+            /* a value became a structure, its text must go */
+            AddChange( changes , xmChangeDelete , p.path , "" , "" );
+            p.from = NULL;
+        }
+
+        for ( xmlAttr* attr = p.to->properties; attr != NULL; attr = attr->next )
+        {
+            std::string value = PropValue( p.to , attr );
+            xmlAttr* old = ( p.from != NULL ) ? xmlHasProp( p.from , attr->name ) : NULL;
+            if ( old == NULL || PropValue( p.from , old ) != value )
+                AddChange( changes , xmChangeSetAttribute , p.path , (const char*) attr->name , value );
+        }
+        for ( xmlAttr* attr = ( p.from != NULL ) ? p.from->properties : NULL; attr != NULL; attr = attr->next )
+            if ( xmlHasProp( p.to , attr->name ) == NULL )
+                AddChange( changes , xmChangeDeleteAttribute , p.path , (const char*) attr->name , "" );
+
+        ChildGroups toGroups, fromGroups;
+        GroupChildrens( p.to , &toGroups );
+        GroupChildrens( leaf ? NULL : p.from , &fromGroups );
+
+        for ( size_t i = 0; i < toGroups.size(); ++i )
+        {
+            const std::string& name = toGroups[i].first;
+            const std::vector<xmlNode*>& nodes = toGroups[i].second;
+            const std::vector<xmlNode*>* old = FindGroup( fromGroups , name );
+
+            if ( nodes.size() == 1 && ( old == NULL || old->size() == 1 ) )
+            {
+                Pending next;
+                next.from = ( old != NULL ) ? (*old)[0] : NULL;
+                next.to = nodes[0];
+                next.path = ChildPath( p.path , name );
+                pending.push_back( next );
+                continue;
+            }
+
+            if ( AreArrayItems( nodes ) )
+            {
+                bool same = old != NULL && old->size() == nodes.size() && AreArrayItems( *old );
+                for ( size_t k = 0; same && k < nodes.size(); ++k )
+                    same = strcmp( NodeText( (*old)[k] , &scratchFrom ) , NodeText( nodes[k] , &scratchTo ) ) == 0;
+                if ( same )
+                    continue;
+
+                AddChange( changes , xmChangeSetArray , ChildPath( p.path , name ) , "" , "" );
+                for ( size_t k = 0; k < nodes.size(); ++k )
+                    changes->back().items.push_back( NodeText( nodes[k] , &scratchTo ) );
+                continue;
+            }
+
+            std::string fragment = DumpNodes( nodes );
+            if ( old == NULL || DumpNodes( *old ) != fragment )
+                AddChange( changes , xmChangeSetNodes , ChildPath( p.path , name ) , "" , fragment );
+        }
+
+        for ( size_t i = 0; i < fromGroups.size(); ++i )
+            if ( FindGroup( toGroups , fromGroups[i].first ) == NULL )
+                AddChange( changes , xmChangeDelete , ChildPath( p.path , fromGroups[i].first ) , "" , "" );
+    }
+}
+
+xmlNode* XmlManagerBase::ResolveChangePath(xmlNode* rootNode, const std::string& path, size_t end, bool create_unexisting)
+{
+    xmlNode* n = rootNode;
+    size_t begin = 0;
+
+    while ( n != NULL && begin < end )
+    {
+        size_t stop = path.find( '/' , begin );
+        if ( stop == std::string::npos || stop > end )
+            stop = end;
+
+        /* a journaled segment "name[k]" designates the k-th child of that name */
+        size_t size = stop - begin;
+        size_t position = 1;
+        if ( size > 2 && path[stop - 1] == ']' )
+        {
+            size_t open = path.rfind( '[' , stop - 1 );
+            if ( open != std::string::npos && open > begin )
+            {
+                position = (size_t) strtoul( path.c_str() + open + 1 , NULL , 10 );
+                size = open - begin;
+            }
+        }
+
+        xmlNode* child = n->children;
+        for ( ; child != NULL; child = child->next )
+        {
+            if ( child->type == XML_ELEMENT_NODE && strlen( (const char*) child->name ) == size &&
+                 path.compare( begin , size , (const char*) child->name ) == 0 && --position == 0 )
+                break;
+        }
+
+        if ( child == NULL && create_unexisting )
+            child = xmlAddChild( n , NewElement( n->doc , path.substr( begin , size ).c_str() ) );
+
+        n = child;
+        begin = stop + 1;
+    }
+    return n;
+}
+
+/* deletes the element childrens of e named name */
+void XmlManagerBase::DeleteNamedChildrens(xmlNode* e, const char* name)
+{
+    xmlNode* child = e->children;
+    while ( child != NULL )
+    {
+        xmlNode* next = child->next;
+        if ( child->type == XML_ELEMENT_NODE && strcmp( (const char*) child->name , name ) == 0 )
+            DetachNode( child );
+        child = next;
+    }
+}
+
+void XmlManagerBase::Patch(const xmChangeSet& changes, xmlNode* rootNode)
+{
+    XmlManagerTraceSpan span( "XmlManagerBase::Patch" );
+    if ( rootNode == NULL )
+        throw NgoErrorInvalidArgument(2,"trying to patch an undefined rootNode","XmlManagerBase::Patch");
+
+    for ( size_t i = 0; i < changes.size(); ++i )
+    {
+        const xmChange& c = changes[i];
+
+        /* container and last segment, for the changes applying to all the childrens of a name */
+        size_t slash = c.path.rfind( '/' );
+        size_t containerEnd = ( slash == std::string::npos ) ? 0 : slash;
+        std::string name = ( slash == std::string::npos ) ? c.path : c.path.substr( slash + 1 );
+
+        switch ( c.type )
+        {
+            case xmChangeSetValue :
+            {
+                xmlNode* n = ResolveChangePath( rootNode , c.path , c.path.size() , true );
+                if ( Journaling() )
+                    JournalChange( rootNode , c );
+                SetNodeText( n , c.value.c_str() );
+                NotifyChange( n );
+                break;
+            }
+
+            case xmChangeClear :
+            {
+                xmlNode* n = ResolveChangePath( rootNode , c.path , c.path.size() , false );
+                if ( Journaling() )
+                    JournalChange( rootNode , c );
+                if ( n != NULL )
+                {
+                    while ( n->children != NULL )
+                        DetachNode( n->children );
+                    NotifyChange( n );
+                }
+                break;
+            }
+
+            case xmChangeSetAttribute :
+                SetAttributeText( ResolveChangePath( rootNode , c.path , c.path.size() , true ) , c.attribute , c.value.c_str() );
+                break;
+
+            case xmChangeDeleteAttribute :
+            {
+                xmlNode* n = ResolveChangePath( rootNode , c.path , c.path.size() , false );
+                if ( Journaling() )
+                    JournalChange( rootNode , c );
+                if ( n != NULL && xmlHasProp( n , (const xmlChar*) c.attribute.c_str() ) != NULL )
+                {
+                    IndexAttribute( n , c.attribute , NULL );
+                    xmlUnsetProp( n , (const xmlChar*) c.attribute.c_str() );
+                    NotifyChange( n );
+                }
+                break;
+            }
+
+            case xmChangeDelete :
+            {
+                if ( name.empty() )
+                    throw NgoErrorInvalidArgument(1,"trying to delete the patched root","XmlManagerBase::Patch");
+                xmlNode* e = ResolveChangePath( rootNode , c.path , containerEnd , false );
+                if ( Journaling() )
+                    JournalChange( rootNode , c );
+                if ( e != NULL )
+                {
+                    DeleteNamedChildrens( e , name.c_str() );
+                    NotifyChange( e );
+                }
+                break;
+            }
+
+            case xmChangeSetArray :
+                WriteArrayItems( ResolveChangePath( rootNode , c.path , containerEnd , true ) , name , c.items );
+                break;
+
+            case xmChangeSetNodes :
+            {
+                xmlNode* e = ResolveChangePath( rootNode , c.path , containerEnd , true );
+
+                xmlNode* list = NULL;
+                if ( xmlParseInNodeContext( e , c.value.data() , (int) c.value.size() , 0 , &list ) != XML_ERR_OK )
+                {
+                    xmlFreeNodeList( list );
+                    throw NgoErrorInvalidArgument(1,"invalid xml fragment in the change set","XmlManagerBase::Patch");
+                }
+                if ( Journaling() )
+                {
+                    try
+                    {
+                        JournalChange( rootNode , c );
+                    }
+                    catch ( ... )
+                    {
+                        xmlFreeNodeList( list );
+                        throw;
+                    }
+                }
+
+                DeleteNamedChildrens( e , name.c_str() );
+                if ( list != NULL )
+                    xmlAddChildList( e , list );
+                NotifyChange( e );
+                break;
+            }
+
+            default :
+                throw NgoErrorInvalidArgument(1,"unknown change type","XmlManagerBase::Patch");
+        }
+    }
+}
+
+/* names of the change types in a stored change set, indexed by xmChangeType */
+static const char* s_changeTypeNames[] = { "value" , "attribute" , "unset" , "delete" , "array" , "nodes" , "clear" };
+static const size_t s_changeTypeCount = sizeof( s_changeTypeNames ) / sizeof( s_changeTypeNames[0] );
+
+const char* XmlMgrChangeTypeName(xmChangeType type)
+{
+    return ( (size_t) type < s_changeTypeCount ) ? s_changeTypeNames[type] : NULL;
+}
+
+bool XmlMgrChangeTypeFromName(const char* name, xmChangeType* type)
+{
+    for ( size_t t = 0; t < s_changeTypeCount; ++t )
+    {
+        if ( strcmp( name , s_changeTypeNames[t] ) == 0 )
+        {
+            *type = (xmChangeType) t;
+            return true;
+        }
+    }
+    return false;
+}
+
+void XmlManagerBase::WriteChangeSet(const xmChangeSet& changes, xmlNode* rootNode)
+{
+    if ( rootNode == NULL )
+        throw NgoErrorInvalidArgument(2,"trying to write to an undefined rootNode","XmlManagerBase::WriteChangeSet");
+
+    for ( size_t i = 0; i < changes.size(); ++i )
+    {
+        const xmChange& c = changes[i];
+        if ( (size_t) c.type >= s_changeTypeCount )
+            throw NgoErrorInvalidArgument(1,"unknown change type","XmlManagerBase::WriteChangeSet");
+
+        xmlNode* n = xmlAddChild( rootNode , NewElement( rootNode->doc , "change" ) );
+        xmlSetProp( n , (const xmlChar*) "type" , (const xmlChar*) s_changeTypeNames[c.type] );
+        xmlSetProp( n , (const xmlChar*) "path" , (const xmlChar*) c.path.c_str() );
+        if ( !c.attribute.empty() )
+            xmlSetProp( n , (const xmlChar*) "attribute" , (const xmlChar*) c.attribute.c_str() );
+
+        if ( c.type == xmChangeSetArray )
+            WriteArrayItems( n , "item" , c.items );
+        else if ( !c.value.empty() )
+            xmlAddChild( n , NewText( n->doc , c.value.c_str() ) );
+    }
+
+    NotifyChange( rootNode );
+    if ( Journaling() )
+        JournalSubtree( rootNode );
+}
+
+void XmlManagerBase::ReadChangeSet(xmlNode* rootNode, xmChangeSet* changes)
+{
+    if ( rootNode == NULL )
+        throw NgoErrorInvalidArgument(2,"trying to read from an undefined rootNode","XmlManagerBase::ReadChangeSet");
+
+    std::string scratch;
+
+    for ( xmlNode* n = rootNode->children; n != NULL; n = n->next )
+    {
+        if ( n->type != XML_ELEMENT_NODE || strcmp( (const char*) n->name , "change" ) != 0 )
+            continue;
+
+        const char* type = AttributeText( n , "type" , &scratch );
+        xmChangeType t;
+        if ( type == NULL || !XmlMgrChangeTypeFromName( type , &t ) )
+            throw NgoErrorInvalidArgument(1,"unknown change type","XmlManagerBase::ReadChangeSet");
+
+        changes->push_back( xmChange() );
+        xmChange& c = changes->back();
+        c.type = t;
+
+        const char* path = AttributeText( n , "path" , &scratch );
+        c.path = ( path != NULL ) ? path : "";
+        const char* attribute = AttributeText( n , "attribute" , &scratch );
+        c.attribute = ( attribute != NULL ) ? attribute : "";
+
+        if ( c.type == xmChangeSetArray )
+        {
+            for ( xmlNode* item = NextArrayItem( n , NULL , "item" ); item != NULL; item = NextArrayItem( n , item , "item" ) )
+                c.items.push_back( NodeText( item , &scratch ) );
+        }
+        else
+            c.value = NodeText( n , &scratch );
+    }
+}
@@ -0,0 +1,224 @@
+/**
+*			@file XmlManagerGenerator.cpp
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*/
+/*******************************************************************************
+   LICENSE
+*******************************************************************************
+ Copyright (C) 2009 Numengo (admin@numengo.com)
+
+ This document is released under the terms of the numenGo EULA.  You should have received a
+ copy of the numenGo EULA along with this file; see  the file LICENSE.TXT. If not, write at
+ admin@numengo.com or at NUMENGO, 15 boulevard Vivier Merle, 69003 LYON - FRANCE
+ You are not allowed to use, copy, modify or distribute this file unless you  conform to numenGo
+ EULA license.
+*/
+
+#include <xmlmgr/XmlManagerBase.h>
+#include <xmlmgr/XmlManagerGenerator.h>
+#include "ngoerr/NgoError.h"
+
+#include <sstream>
+
+/* The documents are built through the public Write methods so that they exercise the same paths
+   as an application. The pseudo random sequence is a splitmix64 drawn by hand, the distributions of
+   the standard library are not the same on every platform. */
+
+namespace
+{
+
+const char* s_words[] = {
+    "alpha", "beta", "gamma", "delta", "epsilon", "zeta", "eta", "theta",
+    "iota", "kappa", "lambda", "mu", "nu", "xi", "omicron", "pi",
+    "rho", "sigma", "tau", "upsilon", "phi", "chi", "psi", "omega"
+};
+const size_t s_wordCount = sizeof( s_words ) / sizeof( s_words[0] );
+
+class Random
+{
+public :
+    Random(unsigned long long seed) : m_state( seed ) {};
+
+    unsigned long long Next()
+    {
+        unsigned long long z = ( m_state += 0x9E3779B97F4A7C15ULL );
+        z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+        z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+        return z ^ ( z >> 31 );
+    }
+
+    /** integer in [0, n) */
+    size_t Below(size_t n) { return n == 0 ? 0 : (size_t) ( Next() % n ); }
+
+    /** real in [0, 1) */
+    double Unit() { return ( Next() >> 11 ) * ( 1.0 / 9007199254740992.0 ); }
+
+private :
+    unsigned long long m_state;
+};
+
+class Generator
+{
+public :
+    Generator(const xmGeneratorOptions& options) :
+        m_mgr( XmlManagerBase::Get() ), m_options( options ), m_random( options.seed ),
+        m_vocabulary( options.names != 0 ? options.names : 1 )
+    {
+        m_result.elements = 0;
+        m_result.values = 0;
+        m_result.arrayItems = 0;
+        m_result.attributes = 0;
+    };
+
+    void Build(xmlNode* n, unsigned int level)
+    {
+        size_t count = Fanout();
+        size_t offset = m_random.Below( m_vocabulary );
+        bool values = level + 1 >= m_options.depth;
+
+        for ( size_t i = 0; i < count && !Full( 1 ); ++i )
+        {
+            std::string name = Name( i , offset );
+            ++m_result.elements;
+            if ( values )
+            {
+                WriteValue( name , n );
+                ++m_result.values;
+                Attributes( name , n );
+            }
+            else
+            {
+                xmlNode* child = m_mgr->GetNode( name , n , true );
+                Attributes( "" , child );
+                Build( child , level + 1 );
+            }
+        }
+
+        if ( !values )
+            return;
+
+        for ( size_t a = 0; a < m_options.arrays && !Full( 1 ); ++a )
+        {
+            size_t length = m_options.arrayLength;
+            if ( m_options.maxNodes != 0 && m_result.elements + 1 + length > m_options.maxNodes )
+                length = m_options.maxNodes - m_result.elements - 1;
+
+            std::string name = Name( count + a , offset ) + "/item";
+            if ( m_random.Below( 2 ) == 0 )
+            {
+                std::vector<double> items( length );
+                for ( size_t k = 0; k < length; ++k )
+                    items[k] = m_random.Unit() * 1000.0;
+                m_mgr->Write( name , n , items );
+            }
+            else
+            {
+                std::vector<int> items( length );
+                for ( size_t k = 0; k < length; ++k )
+                    items[k] = (int) m_random.Below( 100000 );
+                m_mgr->Write( name , n , items );
+            }
+            m_result.elements += 1 + length;
+            m_result.arrayItems += length;
+        }
+    }
+
+    const xmGeneratorResult& Result() const { return m_result; }
+
+private :
+    bool Full(size_t more) const
+    {
+        return m_options.maxNodes != 0 && m_result.elements + more > m_options.maxNodes;
+    }
+
+    size_t Fanout()
+    {
+        double spread = m_options.fanoutSpread < 0.0 ? 0.0 : ( m_options.fanoutSpread > 1.0 ? 1.0 : m_options.fanoutSpread );
+        size_t low = (size_t) ( m_options.fanout * ( 1.0 - spread ) + 0.5 );
+        size_t high = (size_t) ( m_options.fanout * ( 1.0 + spread ) + 0.5 );
+        return low + m_random.Below( high - low + 1 );
+    }
+
+    /** i-th distinct sibling name, the vocabulary words are reused with a suffix once exhausted */
+    std::string Name(size_t i, size_t offset) const
+    {
+        size_t word = ( offset + i ) % m_vocabulary;
+        std::stringstream s;
+        s << s_words[ word % s_wordCount ];
+        if ( word >= s_wordCount )
+            s << word / s_wordCount;
+        if ( i >= m_vocabulary )
+            s << '_' << i / m_vocabulary;
+        return s.str();
+    }
+
+    void WriteValue(const std::string& name, xmlNode* n)
+    {
+        switch ( m_random.Below( 4 ) )
+        {
+            case 0 : m_mgr->Write( name , n , m_random.Unit() * 1000.0 ); break;
+            case 1 : m_mgr->Write( name , n , (int) m_random.Below( 100000 ) ); break;
+            case 2 : m_mgr->Write( name , n , m_random.Below( 2 ) == 0 ); break;
+            default : m_mgr->Write( name , n , std::string( s_words[ m_random.Below( s_wordCount ) ] ) ); break;
+        }
+    }
+
+    void Attributes(const std::string& name, xmlNode* n)
+    {
+        double density = m_options.attributeDensity < 0.0 ? 0.0 : m_options.attributeDensity;
+        size_t count = (size_t) density;
+        if ( m_random.Unit() < density - count )
+            ++count;
+
+        for ( size_t k = 0; k < count; ++k )
+        {
+            std::stringstream attribute;
+            attribute << "a" << k;
+            m_mgr->WriteAttribute( name , n , attribute.str() , (int) m_random.Below( 1000 ) );
+            ++m_result.attributes;
+        }
+    }
+
+    XmlManagerBase* m_mgr;
+    const xmGeneratorOptions& m_options;
+    Random m_random;
+    size_t m_vocabulary;
+    xmGeneratorResult m_result;
+};
+
+} // end of anonymous namespace
+
+xmGeneratorOptions XmlMgrGeneratorDefaults(unsigned long long seed)
+{
+    xmGeneratorOptions options;
+    options.seed = seed;
+    options.depth = 3;
+    options.fanout = 8;
+    options.fanoutSpread = 0.5;
+    options.arrays = 1;
+    options.arrayLength = 16;
+    options.attributeDensity = 0.5;
+    options.names = 64;
+    options.maxNodes = 0;
+    return options;
+}
+
+void XmlMgrGenerate(xmlNode* rootNode, const xmGeneratorOptions& options, xmGeneratorResult* result)
+{
+    if ( rootNode == NULL )
+        throw NgoErrorInvalidArgument(2,"trying to generate a document under an undefined rootNode","XmlMgrGenerate");
+    if ( options.depth == 0 )
+        throw NgoErrorInvalidArgument(1,"a generated document needs a depth of at least 1","XmlMgrGenerate");
+
+    XmlManagerTraceSpan span( "XmlMgrGenerate" );
+    Generator generator( options );
+    generator.Build( rootNode , 0 );
+    if ( result != NULL )
+        *result = generator.Result();
+}
@@ -0,0 +1,241 @@
+/**
+*			@file XmlManagerIndex.cpp
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*/
+/*******************************************************************************
+   LICENSE
+*******************************************************************************
+ Copyright (C) 2009 Numengo (admin@numengo.com)
+
+ This document is released under the terms of the numenGo EULA.  You should have received a
+ copy of the numenGo EULA along with this file; see  the file LICENSE.TXT. If not, write at
+ admin@numengo.com or at NUMENGO, 15 boulevard Vivier Merle, 69003 LYON - FRANCE
+ You are not allowed to use, copy, modify or distribute this file unless you  conform to numenGo
+ EULA license.
+*/
+
+#include <xmlmgr/XmlManagerBase.h>
+#include "ngoerr/NgoError.h"
+
+#include <libxml/tree.h>
+
+/* reads the value of an attribute, the common single text child is used in place */
+static bool GetPropValue(xmlNode* n, const std::string& attribute, std::string* value)
+{
+    xmlAttr* attr = xmlHasProp( n , (const xmlChar*) attribute.c_str() );
+    if ( attr == NULL )
+        return false;
+
+    xmlNode* text = attr->children;
+    if ( text != NULL && text->next == NULL && text->type == XML_TEXT_NODE && text->content != NULL )
+    {
+        value->assign( (const char*) text->content );
+        return true;
+    }
+
+    xmlChar* prop = xmlNodeListGetString( n->doc , attr->children , 1 );
+    value->assign( prop != NULL ? (const char*) prop : "" );
+    xmlFree(prop);
+    return true;
+}
+
+/* removes n from the entries of index under value */
+static void EraseEntry(std::unordered_multimap<std::string, xmlNode*>& index, const std::string& value, xmlNode* n)
+{
+    std::pair<std::unordered_multimap<std::string, xmlNode*>::iterator, std::unordered_multimap<std::string, xmlNode*>::iterator> range =
+        index.equal_range( value );
+    for ( std::unordered_multimap<std::string, xmlNode*>::iterator i = range.first; i != range.second; ++i )
+    {
+        if ( i->second == n )
+        {
+            index.erase( i );
+            return;
+        }
+    }
+}
+
+void XmlManagerBase::CreateAttributeIndex(const std::string& path, xmlNode* rootNode, const std::string& attribute)
+{
+    std::string key(path);
+
+    if ( rootNode == NULL )
+        throw NgoErrorInvalidArgument(2,"trying to index an undefined rootNode","XmlManagerBase::CreateAttributeIndex");
+
+    xmlNode* e = AssertPath( key, rootNode );
+    xmlNode* n = GetUniqElement( e, key );
+
+    AttributeIndex index;
+    std::string value;
+    for ( xmlNode* child = n->children; child != NULL; child = child->next )
+    {
+        if ( child->type != XML_ELEMENT_NODE )
+            continue;
+        if ( GetPropValue( child , attribute , &value ) )
+            index.insert( std::make_pair( value , child ) );
+    }
+
+    std::lock_guard<std::mutex> guard( m_attributeIndexLock );
+    m_attributeIndexes[n->doc][n][attribute].swap( index );
+}
+
+void XmlManagerBase::DropAttributeIndex(const std::string& path, xmlNode* rootNode, const std::string& attribute)
+{
+    std::string key(path);
+
+    if ( rootNode == NULL )
+        throw NgoErrorInvalidArgument(2,"trying to drop an index from an undefined rootNode","XmlManagerBase::DropAttributeIndex");
+
+    xmlNode* e = AssertPath( key, rootNode, false );
+    if ( e == NULL )
+        return;
+
+    xmlNode* n = GetUniqElement( e, key, false );
+    if ( n == NULL )
+        return;
+
+    std::lock_guard<std::mutex> guard( m_attributeIndexLock );
+    std::map<xmlDoc*, std::map<xmlNode*, NodeIndexes> >::iterator doc = m_attributeIndexes.find( n->doc );
+    if ( doc == m_attributeIndexes.end() )
+        return;
+    std::map<xmlNode*, NodeIndexes>::iterator parent = doc->second.find( n );
+    if ( parent == doc->second.end() )
+        return;
+
+    parent->second.erase( attribute );
+    if ( parent->second.empty() )
+        doc->second.erase( parent );
+    if ( doc->second.empty() )
+        m_attributeIndexes.erase( doc );
+}
+
+xmlNode* XmlManagerBase::FindByAttribute(const std::string& path, xmlNode* rootNode, const std::string& attribute, const std::string& value)
+{
+    std::string key(path);
+
+    if ( rootNode == NULL )
+        throw NgoErrorInvalidArgument(2,"trying to search an undefined rootNode","XmlManagerBase::FindByAttribute");
+
+    xmlNode* e = AssertPath( key, rootNode, false );
+    if ( e == NULL )
+        return NULL;
+
+    xmlNode* n = GetUniqElement( e, key, false );
+    if ( n == NULL )
+        return NULL;
+
+    {
+        std::lock_guard<std::mutex> guard( m_attributeIndexLock );
+        std::map<xmlDoc*, std::map<xmlNode*, NodeIndexes> >::const_iterator doc = m_attributeIndexes.find( n->doc );
+        if ( doc != m_attributeIndexes.end() )
+        {
+            std::map<xmlNode*, NodeIndexes>::const_iterator parent = doc->second.find( n );
+            if ( parent != doc->second.end() )
+            {
+                NodeIndexes::const_iterator it = parent->second.find( attribute );
+                if ( it != parent->second.end() )
+                {
+                    AttributeIndex::const_iterator found = it->second.find( value );
+                    return found != it->second.end() ? found->second : NULL;
+                }
+            }
+        }
+    }
+
+    /* no index, linear scan */
+    std::string current;
+    size_t scanned = 0;
+    xmlNode* child = n->children;
+    for ( ; child != NULL; child = child->next )
+    {
+        if ( child->type != XML_ELEMENT_NODE )
+            continue;
+        ++scanned;
+        if ( GetPropValue( child , attribute , &current ) && current == value )
+            break;
+    }
+    if ( Profiling() )
+        ProfileLookup( n , attribute.c_str() , attribute.size() , scanned , child != NULL , true );
+    return child;
+}
+
+void XmlManagerBase::IndexAttribute(xmlNode* n, const std::string& attribute, const char* value)
+{
+    if ( n->parent == NULL )
+        return;
+
+    std::lock_guard<std::mutex> guard( m_attributeIndexLock );
+    if ( m_attributeIndexes.empty() )
+        return;
+    std::map<xmlDoc*, std::map<xmlNode*, NodeIndexes> >::iterator doc = m_attributeIndexes.find( n->doc );
+    if ( doc == m_attributeIndexes.end() )
+        return;
+    std::map<xmlNode*, NodeIndexes>::iterator parent = doc->second.find( n->parent );
+    if ( parent == doc->second.end() )
+        return;
+    NodeIndexes::iterator it = parent->second.find( attribute );
+    if ( it == parent->second.end() )
+        return;
+
+    std::string old;
+    if ( GetPropValue( n , attribute , &old ) )
+        EraseEntry( it->second , old , n );
+    if ( value != NULL )
+        it->second.insert( std::make_pair( std::string( value ) , n ) );
+}
+
+void XmlManagerBase::UnindexNode(xmlNode* n)
+{
+    if ( n == NULL )
+        return;
+
+    std::lock_guard<std::mutex> guard( m_attributeIndexLock );
+    if ( m_attributeIndexes.empty() )
+        return;
+    std::map<xmlDoc*, std::map<xmlNode*, NodeIndexes> >::iterator doc = m_attributeIndexes.find( n->doc );
+    if ( doc == m_attributeIndexes.end() )
+        return;
+    std::map<xmlNode*, NodeIndexes>& parents = doc->second;
+
+    /* the node is one of the indexed childrens */
+    std::map<xmlNode*, NodeIndexes>::iterator parent = parents.find( n->parent );
+    if ( parent != parents.end() )
+    {
+        std::string value;
+        for ( NodeIndexes::iterator it = parent->second.begin(); it != parent->second.end(); ++it )
+            if ( GetPropValue( n , it->first , &value ) )
+                EraseEntry( it->second , value , n );
+    }
+
+    /* indexed parents living in the detached subtree go with it, only those of the document are
+       looked at and a leaf holds none */
+    if ( n->children != NULL )
+    {
+        parent = parents.begin();
+        while ( parent != parents.end() )
+        {
+            xmlNode* p = parent->first;
+            while ( p != NULL && p != n )
+                p = p->parent;
+
+            if ( p == n )
+                parents.erase( parent++ );
+            else
+                ++parent;
+        }
+    }
+
+    if ( parents.empty() )
+        m_attributeIndexes.erase( doc );
+}
+
+void XmlManagerBase::DropAttributeIndexes(xmlDoc* doc)
+{
+    std::lock_guard<std::mutex> guard( m_attributeIndexLock );
+    m_attributeIndexes.erase( doc );
+}
@@ -0,0 +1,488 @@
+/**
+*			@file XmlManagerJournal.cpp
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*/
+/*******************************************************************************
+   LICENSE
+*******************************************************************************
+ Copyright (C) 2009 Numengo (admin@numengo.com)
+
+ This document is released under the terms of the numenGo EULA.  You should have received a
+ copy of the numenGo EULA along with this file; see  the file LICENSE.TXT. If not, write at
+ admin@numengo.com or at NUMENGO, 15 boulevard Vivier Merle, 69003 LYON - FRANCE
+ You are not allowed to use, copy, modify or distribute this file unless you  conform to numenGo
+ EULA license.
+*/
+
+#include <xmlmgr/XmlManagerBase.h>
+#include "ngoerr/NgoError.h"
+
+#include <libxml/tree.h>
+#include <libxml/parser.h>
+
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+/* A journal is a text file with one change per line :
+       type TAB path TAB attribute TAB value
+   or, for the arrays, the items in place of the value, one field each. Tabs, new lines and
+   backslashes of the fields are escaped with a backslash. A path segment naming an element that
+   has siblings of the same name carries its position, "item[2]" for the second one. Every record
+   is idempotent (it sets a state, it never increments one), so replaying a journal twice over the
+   same base, which happens when a compaction is interrupted after its save, gives the same
+   document.
+   The write paths journal a change before making it whenever the record can be built from the
+   written values, so a failed append leaves the tree as it was. WriteStruct, Merge and
+   WriteChangeSet are the exceptions : they rewrite a whole subtree and journal it once it is
+   written, a failed append leaves their write in the tree. A journal that fails an append is
+   closed, the records following a missing one would not replay to the same document. */
+
+struct XmlManagerBase::Journal
+{
+    FILE* file;
+    std::string path;
+    std::thread compaction;
+    /** true from CompactJournal to the end of its save, the thread is joined once it is false */
+    bool running;
+    bool compacted;
+};
+
+static std::string RotatedJournal(const std::string& journalFile)
+{
+    return journalFile + ".old";
+}
+
+static void AppendField(std::string* line, const char* field)
+{
+    line->push_back( '\t' );
+    for ( ; *field != '\0'; ++field )
+    {
+        switch ( *field )
+        {
+            case '\t' : line->append( "\\t" ); break;
+            case '\n' : line->append( "\\n" ); break;
+            case '\r' : line->append( "\\r" ); break;
+            case '\\' : line->append( "\\\\" ); break;
+            default : line->push_back( *field );
+        }
+    }
+}
+
+/* splits a record line in its unescaped fields */
+static void SplitFields(const std::string& line, std::vector<std::string>* fields)
+{
+    fields->assign( 1 , std::string() );
+    for ( size_t i = 0; i < line.size(); ++i )
+    {
+        char c = line[i];
+        if ( c == '\t' )
+            fields->push_back( std::string() );
+        else if ( c == '\\' && i + 1 < line.size() )
+        {
+            char e = line[++i];
+            fields->back().push_back( e == 't' ? '\t' : e == 'n' ? '\n' : e == 'r' ? '\r' : e );
+        }
+        else
+            fields->back().push_back( c );
+    }
+}
+
+/* position of n among the element siblings of its name, 1 based, 0 if it has no such sibling */
+static size_t SiblingPosition(xmlNode* n)
+{
+    size_t before = 0;
+    for ( xmlNode* s = n->prev; s != NULL; s = s->prev )
+        if ( s->type == XML_ELEMENT_NODE && xmlStrEqual( s->name , n->name ) )
+            ++before;
+    if ( before != 0 )
+        return before + 1;
+
+    for ( xmlNode* s = n->next; s != NULL; s = s->next )
+        if ( s->type == XML_ELEMENT_NODE && xmlStrEqual( s->name , n->name ) )
+            return 1;
+    return 0;
+}
+
+/* path of n from the root element of its document, false if n is not in the document tree */
+static bool DocumentPath(xmlNode* n, std::string* path)
+{
+    if ( n->doc == NULL )
+        return false;
+
+    xmlNode* root = xmlDocGetRootElement( n->doc );
+    std::vector<xmlNode*> nodes;
+    for ( xmlNode* p = n; p != root; p = p->parent )
+    {
+        if ( p == NULL || p->type != XML_ELEMENT_NODE )
+            return false;
+        nodes.push_back( p );
+    }
+
+    path->clear();
+    for ( size_t i = nodes.size(); i > 0; --i )
+    {
+        if ( !path->empty() )
+            path->push_back( '/' );
+        path->append( (const char*) nodes[i - 1]->name );
+
+        size_t position = SiblingPosition( nodes[i - 1] );
+        if ( position != 0 )
+        {
+            char index[32];
+            snprintf( index , sizeof( index ) , "[%u]" , (unsigned int) position );
+            path->append( index );
+        }
+    }
+    return true;
+}
+
+static std::string JoinPath(const std::string& base, const std::string& path)
+{
+    if ( base.empty() )
+        return path;
+    return path.empty() ? base : base + "/" + path;
+}
+
+/* xml of the element childrens of parent named name, skipping node */
+static std::string DumpNamedChildrens(xmlNode* parent, const xmlChar* name, xmlNode* skip)
+{
+    std::string ret;
+    xmlBuffer* buffer = xmlBufferCreate();
+    for ( xmlNode* child = parent->children; child != NULL; child = child->next )
+    {
+        if ( child == skip || child->type != XML_ELEMENT_NODE || !xmlStrEqual( child->name , name ) )
+            continue;
+        xmlBufferEmpty( buffer );
+        xmlNodeDump( buffer , child->doc , child , 0 , 0 );
+        ret.append( (const char*) xmlBufferContent( buffer ) , xmlBufferLength( buffer ) );
+    }
+    xmlBufferFree( buffer );
+    return ret;
+}
+
+void XmlManagerBase::JournalChange(xmlNode* rootNode, const xmChange& change)
+{
+    std::string base;
+    if ( !DocumentPath( rootNode , &base ) )
+        return;
+
+    std::string line( XmlMgrChangeTypeName( change.type ) );
+    AppendField( &line , JoinPath( base , change.path ).c_str() );
+    AppendField( &line , change.attribute.c_str() );
+    if ( change.type == xmChangeSetArray )
+    {
+        for ( size_t i = 0; i < change.items.size(); ++i )
+            AppendField( &line , change.items[i].c_str() );
+    }
+    else
+        AppendField( &line , change.value.c_str() );
+    line.push_back( '\n' );
+
+    std::unique_lock<std::mutex> lock( m_journalLock );
+    std::map<xmlDoc*, Journal*>::iterator it = m_journals.find( rootNode->doc );
+    if ( it == m_journals.end() )
+        return;
+
+    if ( fwrite( line.data() , 1 , line.size() , it->second->file ) == line.size() && fflush( it->second->file ) == 0 )
+        return;
+
+    it = IdleJournal( lock , rootNode->doc );
+    if ( it != m_journals.end() )
+    {
+        Journal* failed = it->second;
+        m_journals.erase( it );
+        m_journalCount.store( m_journals.size() );
+        lock.unlock();
+        fclose( failed->file );
+        delete failed;
+    }
+    throw NgoErrorInvalidArgument(1,"cannot append to the journal, the document is no longer journaled","XmlManagerBase::JournalChange");
+}
+
+void XmlManagerBase::JournalValue(xmlNode* n, xmChangeType type, const char* attribute, const char* value)
+{
+    xmChange c;
+    c.type = type;
+    if ( attribute != NULL )
+        c.attribute = attribute;
+    if ( value != NULL )
+        c.value = value;
+    JournalChange( n , c );
+}
+
+void XmlManagerBase::JournalArray(xmlNode* e, const std::string& item, std::vector<std::string>& items)
+{
+    xmChange c;
+    c.type = xmChangeSetArray;
+    c.path = item;
+    c.items.swap( items );
+    JournalChange( e , c );
+}
+
+void XmlManagerBase::JournalDelete(xmlNode* node)
+{
+    xmlNode* parent = node->parent;
+    if ( parent == NULL || node->type != XML_ELEMENT_NODE )
+        return;
+
+    /* the path names all the childrens of that name, the remaining ones are recorded as they are */
+    xmChange c;
+    c.path = (const char*) node->name;
+    c.value = DumpNamedChildrens( parent , node->name , node );
+    c.type = c.value.empty() ? xmChangeDelete : xmChangeSetNodes;
+    JournalChange( parent , c );
+}
+
+void XmlManagerBase::JournalSubtree(xmlNode* n)
+{
+    JournalValue( n , xmChangeClear , NULL , NULL );
+
+    for ( xmlAttr* attr = n->properties; attr != NULL; attr = attr->next )
+    {
+        xmlChar* value = xmlNodeListGetString( n->doc , attr->children , 1 );
+        JournalValue( n , xmChangeSetAttribute , (const char*) attr->name , value != NULL ? (const char*) value : "" );
+        xmlFree(value);
+    }
+
+    std::vector<const xmlChar*> done;
+    std::string scratch;
+    for ( xmlNode* child = n->children; child != NULL; child = child->next )
+    {
+        if ( child->type != XML_ELEMENT_NODE )
+            continue;
+
+        bool seen = false;
+        for ( size_t i = 0; i < done.size() && !seen; ++i )
+            seen = xmlStrEqual( done[i] , child->name );
+        if ( seen )
+            continue;
+        done.push_back( child->name );
+
+        xmChange c;
+        c.type = xmChangeSetNodes;
+        c.path = (const char*) child->name;
+        c.value = DumpNamedChildrens( n , child->name , NULL );
+        JournalChange( n , c );
+    }
+
+    if ( done.empty() && n->children != NULL )
+        JournalValue( n , xmChangeSetValue , NULL , NodeText( n , &scratch ) );
+}
+
+void XmlManagerBase::OpenJournal(xmlDoc* doc, const std::string& journalFile)
+{
+    if ( doc == NULL )
+        throw NgoErrorInvalidArgument(1,"trying to journal an undefined document","XmlManagerBase::OpenJournal");
+
+    FILE* file = fopen( journalFile.c_str() , "ab" );
+    if ( file == NULL )
+        throw NgoErrorInvalidArgument(2,"cannot open the journal","XmlManagerBase::OpenJournal");
+
+    std::lock_guard<std::mutex> lock( m_journalLock );
+    Journal*& journal = m_journals[doc];
+    if ( journal != NULL )
+    {
+        fclose( file );
+        throw NgoErrorInvalidArgument(1,"the document is already journaled","XmlManagerBase::OpenJournal");
+    }
+
+    journal = new Journal();
+    journal->file = file;
+    journal->path = journalFile;
+    journal->running = false;
+    journal->compacted = true;
+    m_journalCount.store( m_journals.size() );
+}
+
+std::map<xmlDoc*, XmlManagerBase::Journal*>::iterator XmlManagerBase::IdleJournal(std::unique_lock<std::mutex>& lock, xmlDoc* doc)
+{
+    /* the journal is looked up again after every wait, another thread may have closed it */
+    std::map<xmlDoc*, Journal*>::iterator it;
+    while ( ( it = m_journals.find( doc ) ) != m_journals.end() && it->second->running )
+        m_journalIdle.wait( lock );
+
+    /* the thread has left its last locked section, the join does not wait for the lock */
+    if ( it != m_journals.end() && it->second->compaction.joinable() )
+        it->second->compaction.join();
+    return it;
+}
+
+void XmlManagerBase::CloseJournal(xmlDoc* doc)
+{
+    std::unique_lock<std::mutex> lock( m_journalLock );
+    std::map<xmlDoc*, Journal*>::iterator it = IdleJournal( lock , doc );
+    if ( it == m_journals.end() )
+        return;
+
+    Journal* journal = it->second;
+    m_journals.erase( it );
+    m_journalCount.store( m_journals.size() );
+    lock.unlock();
+
+    fclose( journal->file );
+    delete journal;
+}
+
+size_t XmlManagerBase::ReplayJournal(xmlDoc* doc, const std::string& journalFile)
+{
+    XmlManagerTraceSpan span( "XmlManagerBase::ReplayJournal" );
+    if ( doc == NULL || xmlDocGetRootElement( doc ) == NULL )
+        throw NgoErrorInvalidArgument(1,"trying to replay a journal on an empty document","XmlManagerBase::ReplayJournal");
+
+    FILE* file = fopen( journalFile.c_str() , "rb" );
+    if ( file == NULL )
+        return 0;
+
+    xmChangeSet changes;
+    std::vector<std::string> fields;
+    std::string line;
+    char buffer[4096];
+
+    while ( fgets( buffer , sizeof( buffer ) , file ) != NULL )
+    {
+        line.append( buffer );
+        if ( line.empty() || line[line.size() - 1] != '\n' )
+            continue;
+
+        line.erase( line.size() - 1 );
+        SplitFields( line , &fields );
+        line.clear();
+
+        /* an empty array has no item field */
+        xmChangeType type;
+        if ( !XmlMgrChangeTypeFromName( fields[0].c_str() , &type ) || fields.size() < ( type == xmChangeSetArray ? 3u : 4u ) )
+        {
+            fclose( file );
+            throw NgoErrorInvalidArgument(2,"invalid record in the journal","XmlManagerBase::ReplayJournal");
+        }
+
+        changes.push_back( xmChange() );
+        xmChange& c = changes.back();
+        c.type = type;
+        c.path = fields[1];
+        c.attribute = fields[2];
+        if ( type == xmChangeSetArray )
+            c.items.assign( fields.begin() + 3 , fields.end() );
+        else
+            c.value = fields[3];
+    }
+    fclose( file );
+
+    /* an unterminated last line is a record cut by a crash, it is dropped */
+    Patch( changes , xmlDocGetRootElement( doc ) );
+    return changes.size();
+}
+
+xmlDoc* XmlManagerBase::LoadJournaledDoc(const std::string& file, const std::string& journalFile)
+{
+    XmlManagerTraceSpan span( "XmlManagerBase::LoadJournaledDoc" );
+    xmlDoc* doc = xmlParseFile( file.c_str() );
+    if ( doc == NULL )
+        return NULL;
+
+    ReplayJournal( doc , RotatedJournal( journalFile ) );
+    ReplayJournal( doc , journalFile );
+    return doc;
+}
+
+/* appends the content of from at the end of to */
+static bool AppendFile(const std::string& from, const std::string& to)
+{
+    FILE* in = fopen( from.c_str() , "rb" );
+    if ( in == NULL )
+        return false;
+    FILE* out = fopen( to.c_str() , "ab" );
+    if ( out == NULL )
+    {
+        fclose( in );
+        return false;
+    }
+
+    char buffer[4096];
+    size_t n;
+    bool ok = true;
+    while ( ok && ( n = fread( buffer , 1 , sizeof( buffer ) , in ) ) > 0 )
+        ok = fwrite( buffer , 1 , n , out ) == n;
+
+    fclose( in );
+    return fclose( out ) == 0 && ok;
+}
+
+void XmlManagerBase::CompactJournal(xmlDoc* doc, const std::string& file)
+{
+    XmlManagerTraceSpan span( "XmlManagerBase::CompactJournal" );
+
+    /* a compaction of the same document still running is waited for, they run one at a time */
+    std::unique_lock<std::mutex> lock( m_journalLock );
+    std::map<xmlDoc*, Journal*>::iterator it = IdleJournal( lock , doc );
+    if ( it == m_journals.end() )
+        throw NgoErrorInvalidArgument(1,"the document is not journaled","XmlManagerBase::CompactJournal");
+
+    Journal* journal = it->second;
+
+    /* the whole document is copied, with the nodes around the root, its encoding and standalone
+       flag; the copy gets no dictionary, the worker thread shares nothing with the live document */
+    xmlDoc* copy = xmlCopyDoc( doc , 1 );
+    if ( copy == NULL )
+        throw NgoErrorInvalidArgument(1,"cannot copy the document","XmlManagerBase::CompactJournal");
+
+    /* rotate the journal, a rotated journal left by a failed compaction is extended */
+    std::string rotated = RotatedJournal( journal->path );
+    fclose( journal->file );
+    bool rotation;
+    FILE* exists = fopen( rotated.c_str() , "rb" );
+    if ( exists != NULL )
+    {
+        fclose( exists );
+        rotation = AppendFile( journal->path , rotated ) && remove( journal->path.c_str() ) == 0;
+    }
+    else
+        rotation = rename( journal->path.c_str() , rotated.c_str() ) == 0;
+
+    /* the records are idempotent, a journal that could not be rotated is kept as it is and reopened */
+    journal->file = fopen( journal->path.c_str() , "ab" );
+    if ( journal->file == NULL || !rotation )
+        xmlFreeDoc( copy );
+    if ( journal->file == NULL )
+    {
+        m_journals.erase( it );
+        m_journalCount.store( m_journals.size() );
+        delete journal;
+        throw NgoErrorInvalidArgument(2,"cannot reopen the journal","XmlManagerBase::CompactJournal");
+    }
+    if ( !rotation )
+        throw NgoErrorInvalidArgument(2,"cannot rotate the journal, it is kept and the document is not saved","XmlManagerBase::CompactJournal");
+
+    journal->running = true;
+    journal->compacted = false;
+    journal->compaction = std::thread( [this, journal, copy, file, rotated]()
+    {
+        XmlManagerTraceSpan span( "XmlManagerBase::CompactJournal (background)" );
+        /* the base file is replaced only once the new one is complete and synced */
+        bool saved = SaveAtomic( copy , file ) >= 0;
+        if ( saved )
+            remove( rotated.c_str() );
+        xmlFreeDoc( copy );
+
+        {
+            std::lock_guard<std::mutex> lock( m_journalLock );
+            journal->compacted = saved;
+            journal->running = false;
+        }
+        m_journalIdle.notify_all();
+    } );
+}
+
+bool XmlManagerBase::WaitJournalCompaction(xmlDoc* doc)
+{
+    std::unique_lock<std::mutex> lock( m_journalLock );
+    std::map<xmlDoc*, Journal*>::iterator it = IdleJournal( lock , doc );
+    return it == m_journals.end() || it->second->compacted;
+}
@@ -0,0 +1,214 @@
+/**
+*			@file XmlManagerNodePool.cpp
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*/
+/*******************************************************************************
+   LICENSE
+*******************************************************************************
+ Copyright (C) 2009 Numengo (admin@numengo.com)
+
+ This document is released under the terms of the numenGo EULA.  You should have received a
+ copy of the numenGo EULA along with this file; see  the file LICENSE.TXT. If not, write at
+ admin@numengo.com or at NUMENGO, 15 boulevard Vivier Merle, 69003 LYON - FRANCE
+ You are not allowed to use, copy, modify or distribute this file unless you  conform to numenGo
+ EULA license.
+*/
+
+#include <xmlmgr/XmlManagerBase.h>
+
+#include <libxml/tree.h>
+#include <libxml/dict.h>
+
+#include <cstring>
+
+/* Deleted element and text nodes are kept per document, an element keeps its name buffer and a text
+   node its content buffer, so that rewriting a document of the same shape mostly reuses memory. The
+   names and contents may live in the dictionary of the document, which is why the pools are per
+   document and must be trimmed before the document is freed (XmlMgrFreeDoc does it). A document
+   freed with xmlFreeDoc would leave its pool behind, so the recycling is off until the application
+   enables it with SetNodePoolLimit. */
+
+void XmlManagerBase::ReleaseNode(xmlNode* node)
+{
+    std::unique_lock<std::mutex> lock( m_nodePoolLock );
+    if ( m_nodePoolLimit == 0 )
+    {
+        lock.unlock();
+        xmlFreeNode( node );
+        return;
+    }
+    NodePool& pool = m_nodePools[ node->doc ];
+
+    /* the subtree is flattened in a list chained by next, without recursion */
+    node->next = NULL;
+    xmlNode* pending = node;
+
+    while ( pending != NULL )
+    {
+        xmlNode* cur = pending;
+        pending = cur->next;
+
+        if ( cur->type == XML_ELEMENT_NODE && cur->children != NULL )
+        {
+            cur->last->next = pending;
+            pending = cur->children;
+            cur->children = NULL;
+            cur->last = NULL;
+        }
+
+        cur->parent = NULL;
+        cur->next = NULL;
+        cur->prev = NULL;
+
+        bool room = pool.elements.size() + pool.texts.size() < m_nodePoolLimit;
+
+        if ( room && cur->type == XML_ELEMENT_NODE )
+        {
+            if ( cur->properties != NULL )
+                xmlFreePropList( cur->properties );
+            if ( cur->nsDef != NULL )
+                xmlFreeNsList( cur->nsDef );
+            cur->properties = NULL;
+            cur->nsDef = NULL;
+            cur->ns = NULL;
+            pool.elements.push_back( cur );
+        }
+        else if ( room && cur->type == XML_TEXT_NODE && strcmp( (const char*) cur->name , "text" ) == 0 )
+            pool.texts.push_back( cur );
+        else
+            xmlFreeNode( cur );
+    }
+}
+
+xmlNode* XmlManagerBase::NewElement(xmlDoc* doc, const char* name)
+{
+    {
+        std::lock_guard<std::mutex> lock( m_nodePoolLock );
+        std::map<xmlDoc*, NodePool>::iterator it = m_nodePools.find( doc );
+        if ( it != m_nodePools.end() && !it->second.elements.empty() )
+        {
+            xmlNode* n = it->second.elements.back();
+            it->second.elements.pop_back();
+            if ( strcmp( (const char*) n->name , name ) != 0 )
+                xmlNodeSetName( n , (const xmlChar*) name );
+            return n;
+        }
+    }
+    if ( Counting() )
+        RecordNodes( 1 );
+    return xmlNewDocNode( doc , NULL , (const xmlChar*) name , NULL );
+}
+
+xmlNode* XmlManagerBase::NewText(xmlDoc* doc, const char* text)
+{
+    xmlNode* t = NULL;
+    {
+        std::lock_guard<std::mutex> lock( m_nodePoolLock );
+        std::map<xmlDoc*, NodePool>::iterator it = m_nodePools.find( doc );
+        if ( it != m_nodePools.end() && !it->second.texts.empty() )
+        {
+            t = it->second.texts.back();
+            it->second.texts.pop_back();
+        }
+    }
+
+    if ( t == NULL )
+    {
+        if ( Counting() )
+            RecordNodes( 1 );
+        return xmlNewDocText( doc , (const xmlChar*) text );
+    }
+
+    SetTextContent( t , text );
+    return t;
+}
+
+void XmlManagerBase::SetTextContent(xmlNode* t, const char* text)
+{
+    xmlChar* content = t->content;
+
+    /* the buffer can be written only if it has been allocated for this node */
+    bool owned = content != NULL && content != (xmlChar*) &(t->properties) &&
+                 !( t->doc != NULL && t->doc->dict != NULL && xmlDictOwns( t->doc->dict , content ) );
+
+    size_t len = strlen( text );
+    if ( owned && (size_t) xmlStrlen( content ) >= len )
+    {
+        memcpy( content , text , len + 1 );
+        return;
+    }
+
+    xmlNodeSetContent( t , (const xmlChar*) text );
+}
+
+void XmlManagerBase::SetNodePoolLimit(size_t limit)
+{
+    {
+        std::lock_guard<std::mutex> lock( m_nodePoolLock );
+        m_nodePoolLimit = limit;
+    }
+    TrimNodePool( NULL , limit );
+}
+
+/* frees the nodes of a pool beyond keep, elements first as they are the most expensive to keep */
+static void TrimPool(std::vector<xmlNode*>& elements, std::vector<xmlNode*>& texts, size_t keep)
+{
+    while ( elements.size() + texts.size() > keep && !elements.empty() )
+    {
+        xmlFreeNode( elements.back() );
+        elements.pop_back();
+    }
+    while ( texts.size() > keep )
+    {
+        xmlFreeNode( texts.back() );
+        texts.pop_back();
+    }
+}
+
+void XmlManagerBase::TrimNodePool(xmlDoc* doc, size_t keep)
+{
+    std::lock_guard<std::mutex> lock( m_nodePoolLock );
+
+    std::map<xmlDoc*, NodePool>::iterator it = ( doc == NULL ) ? m_nodePools.begin() : m_nodePools.find( doc );
+    while ( it != m_nodePools.end() )
+    {
+        TrimPool( it->second.elements , it->second.texts , keep );
+
+        if ( it->second.elements.empty() && it->second.texts.empty() )
+            m_nodePools.erase( it++ );
+        else
+            ++it;
+
+        if ( doc != NULL )
+            break;
+    }
+}
+
+size_t XmlManagerBase::GetNodePoolSize(xmlDoc* doc)
+{
+    std::lock_guard<std::mutex> lock( m_nodePoolLock );
+
+    std::map<xmlDoc*, NodePool>::const_iterator it = m_nodePools.find( doc );
+    return it != m_nodePools.end() ? it->second.elements.size() + it->second.texts.size() : 0;
+}
+
+void XmlManagerBase::ReleaseDocument(xmlDoc* doc)
+{
+    if ( doc == NULL )
+        return;
+
+    DropAttributeIndexes( doc );
+    xmlNode* root = xmlDocGetRootElement( doc );
+    if ( root != NULL )
+        DropSubscriptions( root , false );
+
+    CloseJournal( doc );
+
+    TrimNodePool( doc );
+}
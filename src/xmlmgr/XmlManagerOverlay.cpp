@@ -0,0 +1,168 @@
+/**
+*			@file XmlManagerOverlay.cpp
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*/
+/*******************************************************************************
+   LICENSE
+*******************************************************************************
+ Copyright (C) 2009 Numengo (admin@numengo.com)
+
+ This document is released under the terms of the numenGo EULA.  You should have received a
+ copy of the numenGo EULA along with this file; see  the file LICENSE.TXT. If not, write at
+ admin@numengo.com or at NUMENGO, 15 boulevard Vivier Merle, 69003 LYON - FRANCE
+ You are not allowed to use, copy, modify or distribute this file unless you  conform to numenGo
+ EULA license.
+*/
+
+#include <xmlmgr/XmlManagerOverlay.h>
+#include "ngoerr/NgoError.h"
+
+#include <libxml/tree.h>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+void XmlManagerOverlay::Push(xmlNode* rootNode)
+{
+    if ( rootNode == NULL )
+        throw NgoErrorInvalidArgument(1,"trying to push an undefined layer","XmlManagerOverlay::Push");
+
+    m_layers.push_back( rootNode );
+}
+
+void XmlManagerOverlay::Pop()
+{
+    if ( !m_layers.empty() )
+        m_layers.pop_back();
+}
+
+xmlNode* XmlManagerOverlay::Find(const std::string& name) const
+{
+    XmlManagerBase* mgr = XmlManagerBase::Get();
+    for ( size_t i = m_layers.size(); i > 0; --i )
+    {
+        xmlNode* n = mgr->GetNode( name , m_layers[i - 1] , false );
+        if ( n != NULL )
+            return n;
+    }
+    return NULL;
+}
+
+std::string XmlManagerOverlay::Read(const std::string& name, const std::string& defaultValue) const
+{
+    std::string value;
+    return ReadValue( name , &value ) ? value : defaultValue;
+}
+
+void XmlManagerOverlay::Flatten(xmlNode* target) const
+{
+    XmlManagerBase::Get()->Merge( m_layers , target );
+}
+
+/* next element child of parent named name after prev, the first one if prev is NULL */
+static xmlNode* NextElement(xmlNode* parent, xmlNode* prev, const xmlChar* name)
+{
+    for ( xmlNode* child = prev != NULL ? prev->next : parent->children; child != NULL; child = child->next )
+        if ( child->type == XML_ELEMENT_NODE && xmlStrEqual( child->name , name ) )
+            return child;
+    return NULL;
+}
+
+static bool HasElementChildren(xmlNode* n)
+{
+    for ( xmlNode* child = n->children; child != NULL; child = child->next )
+        if ( child->type == XML_ELEMENT_NODE )
+            return true;
+    return false;
+}
+
+void XmlManagerBase::Merge(xmlNode* source, xmlNode* target)
+{
+    Merge( std::vector<xmlNode*>( 1 , source ) , target );
+}
+
+void XmlManagerBase::Merge(const std::vector<xmlNode*>& sources, xmlNode* target)
+{
+    XmlManagerTraceSpan span( "XmlManagerBase::Merge" );
+    if ( target == NULL )
+        throw NgoErrorInvalidArgument(2,"trying to merge into an undefined node","XmlManagerBase::Merge");
+    for ( size_t i = 0; i < sources.size(); ++i )
+        if ( sources[i] == NULL )
+            throw NgoErrorInvalidArgument(1,"trying to merge an undefined node","XmlManagerBase::Merge");
+
+    /* the nodes touched by the merge, their subscribers are called once all the sources are in */
+    std::vector<xmlNode*> merged;
+    bool notify = m_subscriptionCount.load( std::memory_order_relaxed ) != 0;
+
+    for ( size_t i = 0; i < sources.size(); ++i )
+        MergeTree( sources[i] , target , notify ? &merged : NULL );
+
+    std::sort( merged.begin() , merged.end() );
+    merged.erase( std::unique( merged.begin() , merged.end() ) , merged.end() );
+    for ( size_t i = 0; i < merged.size(); ++i )
+        NotifyNode( merged[i] );
+    NotifyChange( target );
+    if ( Journaling() )
+        JournalSubtree( target );
+}
+
+void XmlManagerBase::MergeTree(xmlNode* source, xmlNode* target, std::vector<xmlNode*>* merged)
+{
+    std::vector<std::pair<xmlNode*, xmlNode*> > pending( 1 , std::make_pair( source , target ) );
+    std::string scratch;
+
+    while ( !pending.empty() )
+    {
+        xmlNode* from = pending.back().first;
+        xmlNode* into = pending.back().second;
+        pending.pop_back();
+        if ( into != target && merged != NULL )
+            merged->push_back( into );
+
+        /* the attributes are journaled and notified with the whole merge */
+        for ( xmlAttr* attr = from->properties; attr != NULL; attr = attr->next )
+        {
+            xmlChar* value = xmlNodeListGetString( from->doc , attr->children , 1 );
+            const char* text = value != NULL ? (const char*) value : "";
+            IndexAttribute( into , (const char*) attr->name , text );
+            xmlSetProp( into , attr->name , (const xmlChar*) text );
+            xmlFree(value);
+        }
+
+        /* a leaf holds a value that overrides the lower layers */
+        if ( !HasElementChildren( from ) )
+        {
+            if ( from->children != NULL )
+                SetNodeText( into , NodeText( from , &scratch ) );
+            continue;
+        }
+
+        /* last child of into matched for each name, repeated names are paired in order */
+        std::vector<std::pair<const xmlChar*, xmlNode*> > matched;
+        for ( xmlNode* child = from->children; child != NULL; child = child->next )
+        {
+            if ( child->type != XML_ELEMENT_NODE )
+                continue;
+
+            size_t k = 0;
+            while ( k < matched.size() && !xmlStrEqual( matched[k].first , child->name ) )
+                ++k;
+            if ( k == matched.size() )
+                matched.push_back( std::make_pair( child->name , (xmlNode*) NULL ) );
+
+            xmlNode* match = NextElement( into , matched[k].second , child->name );
+            if ( match == NULL )
+                match = xmlAddChild( into , NewElement( into->doc , (const char*) child->name ) );
+            matched[k].second = match;
+
+            pending.push_back( std::make_pair( child , match ) );
+        }
+    }
+}
@@ -0,0 +1,588 @@
+/**
+*			@file XmlManagerParallelParse.cpp
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*/
+/*******************************************************************************
+   LICENSE
+*******************************************************************************
+ Copyright (C) 2009 Numengo (admin@numengo.com)
+
+ This document is released under the terms of the numenGo EULA.  You should have received a
+ copy of the numenGo EULA along with this file; see  the file LICENSE.TXT. If not, write at
+ admin@numengo.com or at NUMENGO, 15 boulevard Vivier Merle, 69003 LYON - FRANCE
+ You are not allowed to use, copy, modify or distribute this file unless you  conform to numenGo
+ EULA license.
+*/
+
+#include <xmlmgr/XmlManagerBase.h>
+#include "ngoerr/NgoError.h"
+#include "XmlManagerWorkPool.h"
+
+#include <libxml/globals.h>
+#include <libxml/parser.h>
+#include <libxml/parserInternals.h>
+#include <libxml/tree.h>
+#include <libxml/uri.h>
+#include <libxml/valid.h>
+
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* The content of the root element is cut in slices, each slice starting at a child of the root. A
+   quick scan of the markup finds the cuts, it follows the depth of the elements but does not parse
+   anything. The prolog, the root tags and the epilog are parsed alone and give the document. Each
+   slice is parsed by a worker as a small document made of the xml declaration, the start tag of the
+   root, the slice and the end tag of the root, so that the namespaces and xml:space of the root
+   apply. The childrens of those roots are then moved under the root of the document : their
+   namespaces are mapped to those of the root and their line numbers are shifted to the place of the
+   slice in the file.
+
+   Like xmlParseFile, the parses keep no dictionary in the documents, every node owns its strings, so
+   that the nodes can move from a document to another without touching their names. Anything the
+   scan does not expect is parsed sequentially. */
+
+/** smallest slice, under two slices the parse is sequential */
+static const size_t s_parallelParseMinSlice = 64 * 1024;
+
+/** number of slices per worker, so that the work stealing evens out unequal childrens */
+static const size_t s_parallelParseSlicesPerWorker = 4;
+
+/** libxml caps the line numbers of the nodes */
+static const unsigned int s_maxLine = 65535;
+
+/* the parser settings of libxml are per thread, the workers take those of the caller */
+struct ParserDefaults
+{
+    int keepBlanks;
+    int substituteEntities;
+    int pedantic;
+    int lineNumbers;
+    int warnings;
+    int loadExtDtd;
+    int validate;
+
+    void Take()
+    {
+        keepBlanks = xmlKeepBlanksDefaultValue;
+        substituteEntities = xmlSubstituteEntitiesDefaultValue;
+        pedantic = xmlPedanticParserDefaultValue;
+        lineNumbers = xmlLineNumbersDefaultValue;
+        warnings = xmlGetWarningsDefaultValue;
+        loadExtDtd = xmlLoadExtDtdDefaultValue;
+        validate = xmlDoValidityCheckingDefaultValue;
+    }
+
+    void Apply() const
+    {
+        xmlKeepBlanksDefaultValue = keepBlanks;
+        xmlSubstituteEntitiesDefaultValue = substituteEntities;
+        xmlPedanticParserDefaultValue = pedantic;
+        xmlLineNumbersDefaultValue = lineNumbers;
+        xmlGetWarningsDefaultValue = warnings;
+        xmlLoadExtDtdDefaultValue = loadExtDtd;
+        xmlDoValidityCheckingDefaultValue = validate;
+    }
+};
+
+/* where the scan has cut the document */
+struct ParseLayout
+{
+    size_t declStart, declEnd;				/* xml declaration, empty if none */
+    size_t rootStart, contentStart;			/* start tag of the root */
+    size_t contentEnd;						/* end tag of the root */
+    std::string rootName;
+    std::vector<size_t> cuts;				/* slice starts, contentStart first */
+};
+
+/* one slice being parsed */
+struct ParseSlice
+{
+    xmlDoc* doc;
+    size_t newlines;				/* in the slice */
+    unsigned int lineShift;
+    std::vector<xmlAttr*> ids;
+};
+
+static void IgnoreError(void*, xmlError*)
+{
+}
+
+/* parses like xmlParseFile, NULL if the text is not well formed */
+static xmlDoc* ParseBuffer(const char* data, size_t size, const char* url, bool quiet)
+{
+    if ( size > (size_t) 0x7fffffff )
+        return NULL;
+    xmlParserCtxt* ctxt = xmlCreateMemoryParserCtxt( data , (int) size );
+    if ( ctxt == NULL )
+        return NULL;
+    /* as the file parser context, no dictionary names in the tree */
+    ctxt->linenumbers = 1;
+    ctxt->dictNames = 0;
+    if ( quiet )
+        ctxt->sax->serror = IgnoreError;
+    if ( url != NULL )
+    {
+        if ( ctxt->input->filename == NULL )
+            ctxt->input->filename = (const char*) xmlCanonicPath( (const xmlChar*) url );
+        if ( ctxt->directory == NULL )
+            ctxt->directory = xmlParserGetDirectory( url );
+    }
+
+    xmlParseDocument( ctxt );
+    xmlDoc* doc = ctxt->myDoc;
+    if ( !ctxt->wellFormed && doc != NULL )
+    {
+        xmlFreeDoc( doc );
+        doc = NULL;
+    }
+    ctxt->myDoc = NULL;
+    xmlFreeParserCtxt( ctxt );
+    return doc;
+}
+
+static bool IsBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static bool StartsWith(const char* data, size_t size, size_t at, const char* prefix)
+{
+    size_t len = strlen( prefix );
+    return at + len <= size && memcmp( data + at , prefix , len ) == 0;
+}
+
+/* position after the first occurrence of pattern from at, 0 if there is none */
+static size_t SkipPast(const char* data, size_t size, size_t at, const char* pattern)
+{
+    size_t len = strlen( pattern );
+    while ( at + len <= size )
+    {
+        const char* p = (const char*) memchr( data + at , pattern[0] , size - at - len + 1 );
+        if ( p == NULL )
+            return 0;
+        at = p - data;
+        if ( memcmp( p , pattern , len ) == 0 )
+            return at + len;
+        ++at;
+    }
+    return 0;
+}
+
+/* position after the '>' of a tag starting at at, 0 if there is none, empty is set for "/>" */
+static size_t SkipTag(const char* data, size_t size, size_t at, bool* empty)
+{
+    char quote = 0;
+    for ( size_t i = at + 1; i < size; ++i )
+    {
+        char c = data[i];
+        if ( quote != 0 )
+        {
+            if ( c == quote )
+                quote = 0;
+        }
+        else if ( c == '"' || c == '\'' )
+            quote = c;
+        else if ( c == '>' )
+        {
+            *empty = data[i - 1] == '/';
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+/* the declared encoding, if any, must be UTF-8 */
+static bool DeclaresUtf8(const char* decl, size_t size)
+{
+    std::string text( decl , size );
+    size_t at = text.find( "encoding" );
+    if ( at == std::string::npos )
+        return true;
+    at = text.find_first_of( "\"'" , at );
+    if ( at == std::string::npos )
+        return false;
+    size_t end = text.find( text[at] , at + 1 );
+    if ( end == std::string::npos )
+        return false;
+    std::string encoding = text.substr( at + 1 , end - at - 1 );
+    return xmlStrcasecmp( (const xmlChar*) encoding.c_str() , (const xmlChar*) "UTF-8" ) == 0;
+}
+
+/* finds the slices, false if the document must be parsed sequentially */
+static bool ScanLayout(const char* data, size_t size, size_t slices, ParseLayout* layout)
+{
+    size_t at = 0;
+    /* UTF-8 only, the byte order mark is skipped, others mean another encoding */
+    if ( StartsWith( data , size , 0 , "\xEF\xBB\xBF" ) )
+        at = 3;
+    if ( size <= at || data[at] != '<' )
+        return false;
+
+    layout->declStart = layout->declEnd = at;
+    if ( StartsWith( data , size , at , "<?xml" ) && at + 5 < size && IsBlank( data[at + 5] ) )
+    {
+        size_t end = SkipPast( data , size , at , "?>" );
+        if ( end == 0 || !DeclaresUtf8( data + at , end - at ) )
+            return false;
+        layout->declEnd = at = end;
+    }
+
+    /* prolog, a document type declaration may define entities and default attributes */
+    for ( ;; )
+    {
+        while ( at < size && IsBlank( data[at] ) )
+            ++at;
+        if ( at >= size || data[at] != '<' )
+            return false;
+        if ( StartsWith( data , size , at , "<!--" ) )
+            at = SkipPast( data , size , at + 4 , "-->" );
+        else if ( StartsWith( data , size , at , "<?" ) )
+            at = SkipPast( data , size , at + 2 , "?>" );
+        else if ( StartsWith( data , size , at , "<!" ) )
+            return false;
+        else
+            break;
+        if ( at == 0 )
+            return false;
+    }
+
+    bool empty = false;
+    layout->rootStart = at;
+    layout->contentStart = SkipTag( data , size , at , &empty );
+    if ( layout->contentStart == 0 || empty )
+        return false;
+    size_t nameEnd = at + 1;
+    while ( nameEnd < layout->contentStart && !IsBlank( data[nameEnd] ) && data[nameEnd] != '>' && data[nameEnd] != '/' )
+        ++nameEnd;
+    layout->rootName.assign( data + at + 1 , nameEnd - at - 1 );
+
+    size_t target = ( size - layout->contentStart ) / slices;
+    if ( target < s_parallelParseMinSlice )
+        target = s_parallelParseMinSlice;
+    layout->cuts.assign( 1 , layout->contentStart );
+
+    /* content of the root, only the depth is followed */
+    size_t depth = 1;
+    at = layout->contentStart;
+    for ( ;; )
+    {
+        const char* p = (const char*) memchr( data + at , '<' , size - at );
+        if ( p == NULL )
+            return false;
+        size_t tag = p - data;
+
+        /* text under the root would change how libxml treats the blanks around the cuts */
+        if ( depth == 1 )
+            for ( size_t i = at; i < tag; ++i )
+                if ( !IsBlank( data[i] ) )
+                    return false;
+
+        if ( StartsWith( data , size , tag , "</" ) )
+        {
+            at = SkipPast( data , size , tag , ">" );
+            if ( --depth == 0 )
+            {
+                layout->contentEnd = tag;
+                break;
+            }
+        }
+        else if ( StartsWith( data , size , tag , "<!--" ) )
+            at = SkipPast( data , size , tag + 4 , "-->" );
+        else if ( StartsWith( data , size , tag , "<![CDATA[" ) )
+        {
+            if ( depth == 1 )
+                return false;
+            at = SkipPast( data , size , tag + 9 , "]]>" );
+        }
+        else if ( StartsWith( data , size , tag , "<?" ) )
+            at = SkipPast( data , size , tag + 2 , "?>" );
+        else if ( StartsWith( data , size , tag , "<!" ) )
+            return false;
+        else
+        {
+            if ( depth == 1 && tag - layout->cuts.back() >= target )
+                layout->cuts.push_back( tag );
+            at = SkipTag( data , size , tag , &empty );
+            if ( !empty )
+                ++depth;
+        }
+        if ( at == 0 )
+            return false;
+    }
+
+    /* the last slice must be worth a worker too */
+    if ( layout->cuts.size() > 1 && layout->contentEnd - layout->cuts.back() < target / 2 )
+        layout->cuts.pop_back();
+    return layout->cuts.size() >= 2;
+}
+
+static size_t CountNewlines(const char* data, size_t size)
+{
+    size_t count = 0;
+    const char* end = data + size;
+    while ( ( data = (const char*) memchr( data , '\n' , end - data ) ) != NULL )
+    {
+        ++count;
+        ++data;
+    }
+    return count;
+}
+
+static unsigned short ShiftLine(unsigned short line, unsigned int shift)
+{
+    if ( line == 0 )
+        return 0;
+    unsigned int shifted = line + shift;
+    return (unsigned short) ( shifted > s_maxLine ? s_maxLine : shifted );
+}
+
+/* calls visit on every node below parent, attributes and their text included */
+template <class Visit>
+static void VisitSubtrees(xmlNode* parent, Visit visit)
+{
+    xmlNode* node = parent->children;
+    while ( node != NULL )
+    {
+        visit( node );
+        if ( node->type == XML_ELEMENT_NODE )
+        {
+            for ( xmlAttr* attr = node->properties; attr != NULL; attr = attr->next )
+            {
+                visit( (xmlNode*) attr );
+                for ( xmlNode* text = attr->children; text != NULL; text = text->next )
+                    visit( text );
+            }
+        }
+
+        if ( node->children != NULL && node->type != XML_ENTITY_REF_NODE )
+        {
+            node = node->children;
+            continue;
+        }
+        while ( node != NULL && node->next == NULL )
+        {
+            node = node->parent;
+            if ( node == parent )
+                return;
+        }
+        if ( node != NULL )
+            node = node->next;
+    }
+}
+
+/* the parsed document, NULL if it must be parsed sequentially, malformed documents are left to the
+   sequential parse too so that the errors are reported as usual */
+static xmlDoc* ParseParallel(const char* data, size_t size, const char* url, unsigned int threads)
+{
+    unsigned int workers = XmlManagerWorkPool::Workers( threads );
+    if ( workers < 2 || size < 2 * s_parallelParseMinSlice )
+        return NULL;
+
+    ParseLayout layout;
+    if ( !ScanLayout( data , size , workers * s_parallelParseSlicesPerWorker , &layout ) )
+        return NULL;
+
+    /* the document without the content of the root */
+    std::string skeleton( data , layout.contentStart );
+    skeleton.append( data + layout.contentEnd , size - layout.contentEnd );
+    xmlDoc* doc = ParseBuffer( skeleton.data() , skeleton.size() , url , true );
+    skeleton.clear();
+    xmlNode* root = xmlDocGetRootElement( doc );
+    if ( root == NULL || root->children != NULL || doc->intSubset != NULL )
+    {
+        if ( doc != NULL )
+            xmlFreeDoc( doc );
+        return NULL;
+    }
+
+    std::string head( data + layout.declStart , layout.declEnd - layout.declStart );
+    head.append( data + layout.rootStart , layout.contentStart - layout.rootStart );
+    std::string tail = "</" + layout.rootName + ">";
+    size_t headNewlines = CountNewlines( head.data() , head.size() );
+
+    ParserDefaults defaults;
+    defaults.Take();
+
+    size_t count = layout.cuts.size();
+    layout.cuts.push_back( layout.contentEnd );
+    std::vector<ParseSlice> slices( count );
+    for ( size_t s = 0; s < count; ++s )
+        slices[s].doc = NULL;
+
+    struct FreeSlices
+    {
+        std::vector<ParseSlice>& slices;
+        ~FreeSlices()
+        {
+            for ( size_t s = 0; s < slices.size(); ++s )
+                if ( slices[s].doc != NULL )
+                    xmlFreeDoc( slices[s].doc );
+        }
+    } freeSlices = { slices };
+
+    try
+    {
+        XmlManagerWorkPool::Run( count , [&](size_t s)
+        {
+            defaults.Apply();
+            ParseSlice& slice = slices[s];
+            size_t from = layout.cuts[s];
+            size_t to = layout.cuts[s + 1];
+            slice.newlines = CountNewlines( data + from , to - from );
+
+            std::string text;
+            text.reserve( head.size() + ( to - from ) + tail.size() );
+            text.append( head ).append( data + from , to - from ).append( tail );
+            slice.doc = ParseBuffer( text.data() , text.size() , NULL , true );
+        }, threads );
+    }
+    catch ( ... )
+    {
+        xmlFreeDoc( doc );
+        throw;
+    }
+
+    /* a slice starts at the line of its first byte minus the lines of the tags put before it */
+    size_t prologNewlines = CountNewlines( data , layout.contentStart );
+    size_t newlines = prologNewlines;
+    bool xmlNamespace = false;
+    for ( size_t s = 0; s < count; ++s )
+    {
+        ParseSlice& slice = slices[s];
+        if ( slice.doc == NULL || xmlDocGetRootElement( slice.doc ) == NULL )
+        {
+            xmlFreeDoc( doc );
+            return NULL;
+        }
+        slice.lineShift = (unsigned int) ( newlines - headNewlines );
+        newlines += slice.newlines;
+        xmlNamespace = xmlNamespace || slice.doc->oldNs != NULL;
+    }
+    xmlNs* xmlPrefix = xmlNamespace ? xmlSearchNs( doc , root , (const xmlChar*) "xml" ) : NULL;
+
+    XmlManagerWorkPool::Run( count , [&](size_t s)
+    {
+        ParseSlice& slice = slices[s];
+        xmlNode* top = xmlDocGetRootElement( slice.doc );
+
+        /* the namespaces declared by the root of the slice are those of the root of the document */
+        std::unordered_map<const xmlNs*, xmlNs*> namespaces;
+        for ( xmlNs *from = top->nsDef, *to = root->nsDef; from != NULL && to != NULL; from = from->next, to = to->next )
+            namespaces[from] = to;
+        if ( slice.doc->oldNs != NULL )
+            namespaces[slice.doc->oldNs] = xmlPrefix;
+
+        VisitSubtrees( top , [&](xmlNode* node)
+        {
+            node->doc = doc;
+            if ( node->type == XML_ATTRIBUTE_NODE )
+            {
+                /* the ids are registered by the calling thread, the table of the document is not thread safe */
+                xmlAttr* attr = (xmlAttr*) node;
+                if ( attr->atype == XML_ATTRIBUTE_ID )
+                    slice.ids.push_back( attr );
+            }
+            else
+                node->line = ShiftLine( node->line , slice.lineShift );
+            if ( ( node->type == XML_ELEMENT_NODE || node->type == XML_ATTRIBUTE_NODE ) && node->ns != NULL )
+            {
+                std::unordered_map<const xmlNs*, xmlNs*>::const_iterator it = namespaces.find( node->ns );
+                if ( it != namespaces.end() )
+                    node->ns = it->second;
+            }
+        } );
+        for ( xmlNode* child = top->children; child != NULL; child = child->next )
+            child->parent = root;
+    }, threads );
+
+    /* grafting, in document order */
+    for ( size_t s = 0; s < count; ++s )
+    {
+        xmlNode* top = xmlDocGetRootElement( slices[s].doc );
+        if ( top->children == NULL )
+            continue;
+        if ( root->last == NULL )
+            root->children = top->children;
+        else
+        {
+            root->last->next = top->children;
+            top->children->prev = root->last;
+        }
+        root->last = top->last;
+        top->children = top->last = NULL;
+
+        for ( size_t i = 0; i < slices[s].ids.size(); ++i )
+        {
+            xmlAttr* attr = slices[s].ids[i];
+            xmlChar* value = xmlNodeListGetString( doc , attr->children , 1 );
+            if ( value != NULL )
+            {
+                /* a duplicate is not an id, as for the sequential parse */
+                if ( xmlAddID( NULL , doc , value , attr ) == NULL )
+                    attr->atype = (xmlAttributeType) 0;
+                xmlFree( value );
+            }
+        }
+    }
+
+    /* the epilog was parsed right after the root start tag */
+    for ( xmlNode* node = root->next; node != NULL; node = node->next )
+        node->line = ShiftLine( node->line , (unsigned int) ( newlines - prologNewlines ) );
+    return doc;
+}
+
+_xmlDoc * XmlMgrParseMemoryParallel(const char * buffer, size_t size, const char * url, unsigned int threads)
+{
+    if ( buffer == NULL )
+        throw NgoErrorInvalidArgument(1,"trying to parse an undefined buffer","XmlMgrParseMemoryParallel");
+
+    XmlManagerTraceSpan span( "XmlMgrParseMemoryParallel" );
+    xmlDoc* doc = ParseParallel( buffer , size , url , threads );
+    if ( doc == NULL )
+        doc = ParseBuffer( buffer , size , url , false );
+    return doc;
+}
+
+_xmlDoc * XmlMgrParseFileParallel(const char * filename, unsigned int threads)
+{
+    if ( filename == NULL )
+        throw NgoErrorInvalidArgument(1,"trying to parse an undefined file","XmlMgrParseFileParallel");
+
+    XmlManagerTraceSpan span( "XmlMgrParseFileParallel" );
+
+    /* compressed files, urls and unreadable files are left to libxml */
+    std::string data;
+    std::ifstream in( filename , std::ios::in | std::ios::binary );
+    if ( in )
+    {
+        in.seekg( 0 , std::ios::end );
+        std::streamoff length = in.tellg();
+        in.seekg( 0 , std::ios::beg );
+        if ( length > 0 )
+        {
+            data.resize( (size_t) length );
+            if ( !in.read( &data[0] , length ) )
+                data.clear();
+        }
+    }
+    if ( data.size() < 2 || ( data[0] == '\x1f' && data[1] == '\x8b' ) )
+        return XmlMgrParseFile( filename );
+
+    xmlDoc* doc = ParseParallel( data.data() , data.size() , filename , threads );
+    if ( doc == NULL )
+    {
+        data.clear();
+        data.shrink_to_fit();
+        doc = XmlMgrParseFile( filename );
+    }
+    return doc;
+}
@@ -0,0 +1,297 @@
+/**
+*			@file XmlManagerParallelSave.cpp
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*/
+/*******************************************************************************
+   LICENSE
+*******************************************************************************
+ Copyright (C) 2009 Numengo (admin@numengo.com)
+
+ This document is released under the terms of the numenGo EULA.  You should have received a
+ copy of the numenGo EULA along with this file; see  the file LICENSE.TXT. If not, write at
+ admin@numengo.com or at NUMENGO, 15 boulevard Vivier Merle, 69003 LYON - FRANCE
+ You are not allowed to use, copy, modify or distribute this file unless you  conform to numenGo
+ EULA license.
+*/
+
+#include <xmlmgr/XmlManagerBase.h>
+#include "ngoerr/NgoError.h"
+#include "XmlManagerWorkPool.h"
+
+#include <libxml/globals.h>
+#include <libxml/tree.h>
+#include <libxml/xmlIO.h>
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+    #include <io.h>
+    #include <fcntl.h>
+    #include <sys/stat.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/uio.h>
+#endif
+
+/* The document is cut in three kinds of pieces. The skeleton is a copy of the document where every
+   element child of the root is replaced by an empty placeholder element, serialized by libxml as the
+   sequential save would do it, then split at the placeholders : it gives the prolog, the root tags
+   and the indentation between the childrens. The childrens are serialized by the workers with
+   xmlNodeDumpOutput at level 1, which is the depth the sequential save gives them. Every piece is
+   UTF-8 with the same escaping, so their concatenation is the sequential output. */
+
+/** below this number of element childrens of the root the save is sequential */
+static const size_t s_parallelSaveMinChildrens = 16;
+
+/** number of children ranges per worker, so that the work stealing evens out unequal subtrees */
+static const size_t s_parallelSaveRangesPerWorker = 4;
+
+static const char s_slotName[] = "xmParallelSaveSlot";
+
+static int AppendToString(void* context, const char* data, int len)
+{
+    ((std::string*) context)->append( data , len );
+    return len;
+}
+
+static bool IsUtf8(const char* encoding)
+{
+    return encoding != NULL && xmlStrcasecmp( (const xmlChar*) encoding , (const xmlChar*) "UTF-8" ) == 0;
+}
+
+/* the serialization of the skeleton split at the placeholders, false if the document does not fit */
+static bool SkeletonPieces(xmlDoc* doc, xmlNode* root, const char* encoding, int format, size_t slots, std::vector<std::string>* pieces)
+{
+    xmlDoc* skeleton = xmlNewDoc( doc->version != NULL ? doc->version : (const xmlChar*) "1.0" );
+    if ( skeleton == NULL )
+        return false;
+    skeleton->standalone = doc->standalone;
+
+    bool ok = true;
+    for ( xmlNode* n = doc->children; n != NULL && ok; n = n->next )
+    {
+        if ( n != root )
+        {
+            xmlNode* copy = xmlDocCopyNode( n , skeleton , 1 );
+            ok = copy != NULL && xmlAddChild( (xmlNode*) skeleton , copy ) != NULL;
+            continue;
+        }
+
+        xmlNode* top = xmlDocCopyNode( root , skeleton , 2 );
+        ok = top != NULL && xmlAddChild( (xmlNode*) skeleton , top ) != NULL;
+        for ( xmlNode* child = root->children; child != NULL && ok; child = child->next )
+        {
+            xmlNode* copy = ( child->type == XML_ELEMENT_NODE ) ?
+                            xmlNewDocNode( skeleton , NULL , (const xmlChar*) s_slotName , NULL ) :
+                            xmlDocCopyNode( child , skeleton , 1 );
+            ok = copy != NULL && xmlAddChild( top , copy ) != NULL;
+        }
+    }
+
+    std::string text;
+    if ( ok )
+    {
+        xmlOutputBuffer* out = xmlOutputBufferCreateIO( AppendToString , NULL , &text , NULL );
+        ok = out != NULL && xmlSaveFormatFileTo( out , skeleton , encoding , format ) >= 0;
+    }
+    xmlFreeDoc( skeleton );
+    if ( !ok )
+        return false;
+
+    /* a comment or a processing instruction could hold the placeholder text, the count tells */
+    std::string slot = std::string( "<" ) + s_slotName + "/>";
+    pieces->clear();
+    size_t from = 0;
+    size_t at;
+    while ( ( at = text.find( slot , from ) ) != std::string::npos )
+    {
+        pieces->push_back( text.substr( from , at - from ) );
+        from = at + slot.size();
+    }
+    pieces->push_back( text.substr( from ) );
+    return pieces->size() == slots + 1;
+}
+
+/* the output in order, false if the document must be saved sequentially */
+static bool SerializeParallel(xmlDoc* doc, const char* encoding, int format, unsigned int threads, std::vector<std::string>* parts)
+{
+    if ( doc == NULL )
+        throw NgoErrorInvalidArgument(1,"trying to save an undefined document","XmlMgrSaveParallel");
+
+    xmlNode* root = xmlDocGetRootElement( doc );
+    if ( root == NULL || doc->type != XML_DOCUMENT_NODE || doc->intSubset != NULL || doc->extSubset != NULL || !IsUtf8( encoding ) )
+        return false;
+
+    unsigned int workers = XmlManagerWorkPool::Workers( threads );
+    if ( workers < 2 )
+        return false;
+
+    std::vector<xmlNode*> childrens;
+    for ( xmlNode* child = root->children; child != NULL; child = child->next )
+    {
+        /* text under the root switches the formatting of all its childrens off, keep it simple */
+        if ( child->type == XML_TEXT_NODE || child->type == XML_CDATA_SECTION_NODE || child->type == XML_ENTITY_REF_NODE )
+            return false;
+        if ( child->type == XML_ELEMENT_NODE )
+            childrens.push_back( child );
+    }
+    if ( childrens.size() < s_parallelSaveMinChildrens )
+        return false;
+
+    std::vector<std::string> pieces;
+    if ( !SkeletonPieces( doc , root , encoding , format , childrens.size() , &pieces ) )
+        return false;
+
+    /* part 0 is the prolog, part r + 1 holds the range r of childrens each followed by its separator */
+    size_t ranges = workers * s_parallelSaveRangesPerWorker;
+    if ( ranges > childrens.size() )
+        ranges = childrens.size();
+    parts->assign( ranges + 1 , std::string() );
+    (*parts)[0].swap( pieces[0] );
+
+    /* the formatting settings of libxml are per thread, the workers take those of the caller */
+    int indentTree = xmlIndentTreeOutput;
+    const char* indentString = xmlTreeIndentString;
+    int noEmptyTags = xmlSaveNoEmptyTags;
+
+    std::vector<char> failed( ranges , 0 );
+    XmlManagerWorkPool::Run( ranges , [&](size_t r)
+    {
+        xmlIndentTreeOutput = indentTree;
+        xmlTreeIndentString = indentString;
+        xmlSaveNoEmptyTags = noEmptyTags;
+
+        size_t first = childrens.size() * r / ranges;
+        size_t last = childrens.size() * ( r + 1 ) / ranges;
+        std::string& part = (*parts)[r + 1];
+
+        xmlOutputBuffer* out = xmlOutputBufferCreateIO( AppendToString , NULL , &part , NULL );
+        if ( out == NULL )
+        {
+            failed[r] = 1;
+            return;
+        }
+        for ( size_t i = first; i < last; ++i )
+        {
+            xmlNodeDumpOutput( out , doc , childrens[i] , 1 , format , encoding );
+            /* flush before appending the separator, the buffer writes to the same string */
+            xmlOutputBufferFlush( out );
+            part.append( pieces[i + 1] );
+        }
+        if ( out->error != 0 )
+            failed[r] = 1;
+        xmlOutputBufferClose( out );
+    }, threads );
+
+    for ( size_t r = 0; r < ranges; ++r )
+        if ( failed[r] )
+            throw NgoErrorInvalidArgument(4,"serialization of a subtree failed","XmlMgrSaveParallel");
+    return true;
+}
+
+/* writes the parts in order, as few system calls as the platform allows */
+static int WriteParts(int fd, const std::vector<std::string>& parts)
+{
+    size_t total = 0;
+#ifdef _WIN32
+    for ( size_t i = 0; i < parts.size(); ++i )
+    {
+        size_t done = 0;
+        while ( done < parts[i].size() )
+        {
+            int n = _write( fd , parts[i].data() + done , (unsigned int) ( parts[i].size() - done ) );
+            if ( n <= 0 )
+                return -1;
+            done += n;
+        }
+        total += done;
+    }
+#else
+    std::vector<struct iovec> iov;
+    for ( size_t i = 0; i < parts.size(); ++i )
+    {
+        if ( parts[i].empty() )
+            continue;
+        struct iovec v;
+        v.iov_base = (void*) parts[i].data();
+        v.iov_len = parts[i].size();
+        iov.push_back( v );
+        total += v.iov_len;
+    }
+
+    long maxIov = sysconf( _SC_IOV_MAX );
+    size_t batch = maxIov > 0 ? (size_t) maxIov : 16;
+    size_t next = 0;
+    while ( next < iov.size() )
+    {
+        int count = (int) ( iov.size() - next < batch ? iov.size() - next : batch );
+        ssize_t n = writev( fd , &iov[next] , count );
+        if ( n < 0 && errno == EINTR )
+            continue;
+        if ( n <= 0 )
+            return -1;
+
+        /* skip what has been written, a partial write leaves a vector half done */
+        size_t written = (size_t) n;
+        while ( next < iov.size() && written >= iov[next].iov_len )
+            written -= iov[next++].iov_len;
+        if ( written > 0 )
+        {
+            iov[next].iov_base = (char*) iov[next].iov_base + written;
+            iov[next].iov_len -= written;
+        }
+    }
+#endif
+    return total > 0x7fffffff ? 0x7fffffff : (int) total;
+}
+
+int XmlMgrSaveParallelToFd(xmlDoc* doc, int fd, const char* encoding, int format, unsigned int threads)
+{
+    if ( fd < 0 )
+        throw NgoErrorInvalidArgument(2,"trying to save in an invalid file descriptor","XmlMgrSaveParallelToFd");
+
+    XmlManagerTraceSpan span( "XmlMgrSaveParallelToFd" );
+    std::vector<std::string> parts;
+    if ( !SerializeParallel( doc , encoding , format , threads , &parts ) )
+        return XmlMgrSaveToFd( doc , fd , encoding , format );
+    return WriteParts( fd , parts );
+}
+
+int XmlMgrSaveParallelFileEnc(const char* filename, xmlDoc* doc, const char* encoding, int format, unsigned int threads)
+{
+    if ( filename == NULL )
+        throw NgoErrorInvalidArgument(1,"trying to save in an undefined file","XmlMgrSaveParallelFileEnc");
+
+    XmlManagerTraceSpan span( "XmlMgrSaveParallelFileEnc" );
+    std::vector<std::string> parts;
+    if ( !SerializeParallel( doc , encoding , format , threads , &parts ) )
+        return XmlMgrSaveFormatFileEnc( filename , doc , encoding , format );
+
+#ifdef _WIN32
+    int fd = _open( filename , _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY , _S_IREAD | _S_IWRITE );
+#else
+    int fd = open( filename , O_WRONLY | O_CREAT | O_TRUNC , 0644 );
+#endif
+    if ( fd < 0 )
+        return -1;
+
+    int bytes = WriteParts( fd , parts );
+#ifdef _WIN32
+    if ( _close( fd ) != 0 )
+        bytes = -1;
+#else
+    if ( close( fd ) != 0 )
+        bytes = -1;
+#endif
+    return bytes;
+}
@@ -0,0 +1,167 @@
+/**
+*			@file XmlManagerProfile.cpp
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*/
+/*******************************************************************************
+   LICENSE
+*******************************************************************************
+ Copyright (C) 2009 Numengo (admin@numengo.com)
+
+ This document is released under the terms of the numenGo EULA.  You should have received a
+ copy of the numenGo EULA along with this file; see  the file LICENSE.TXT. If not, write at
+ admin@numengo.com or at NUMENGO, 15 boulevard Vivier Merle, 69003 LYON - FRANCE
+ You are not allowed to use, copy, modify or distribute this file unless you  conform to numenGo
+ EULA license.
+*/
+
+#include <xmlmgr/XmlManagerBase.h>
+
+#include <libxml/tree.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <unordered_map>
+
+/* The profile only looks at the scans longer than the threshold, those compute the xpath of their
+   parent and take the profile lock. The composition of the childrens, which drives the advice, is
+   measured again each time a lookup scans more siblings than before. */
+
+namespace
+{
+
+bool MoreScanned(const xmLookupProfile& a, const xmLookupProfile& b)
+{
+    return a.scannedSiblings > b.scannedSiblings;
+}
+
+/** counts the element childrens of parent and the largest group sharing a name */
+void Composition(xmlNode* parent, size_t* childrens, size_t* repeated)
+{
+    std::unordered_map<std::string, size_t> counts;
+    *childrens = 0;
+    *repeated = 0;
+    for ( xmlNode* child = parent->children; child != NULL; child = child->next )
+    {
+        if ( child->type != XML_ELEMENT_NODE )
+            continue;
+        ++*childrens;
+        size_t& count = counts[ (const char*) child->name ];
+        if ( ++count > *repeated )
+            *repeated = count;
+    }
+}
+
+} // end of anonymous namespace
+
+const char* XmlMgrLookupAdviceText(xmLookupAdvice advice)
+{
+    switch ( advice )
+    {
+        case xmAdviceChildIndex : return "many distinct siblings, index the childrens by name or split the parent";
+        case xmAdviceAttributeIndex : return "searched by attribute, declare CreateAttributeIndex on the parent";
+        case xmAdvicePackedArray : return "mostly repeated siblings, store them as an array and read them with ReadArray";
+        default : return "unknown";
+    }
+}
+
+void XmlManagerBase::EnableLookupProfile(bool enable, size_t minSiblings)
+{
+    m_profileMinSiblings.store( minSiblings , std::memory_order_relaxed );
+    m_profileEnabled.store( enable , std::memory_order_relaxed );
+}
+
+void XmlManagerBase::ProfileLookup(xmlNode* parent, const char* name, size_t length, size_t scanned, bool found, bool attribute)
+{
+    if ( scanned < m_profileMinSiblings.load( std::memory_order_relaxed ) )
+        return;
+
+    xmlChar* path = xmlGetNodePath( parent );
+    std::pair<std::string, std::string> key( path != NULL ? (const char*) path : "" , std::string() );
+    xmlFree( path );
+
+    if ( attribute )
+        key.second = "@";
+    for ( size_t k = 0; k < length; ++k )
+        key.second += attribute ? name[k] : xmPathChar( name[k] );
+
+    std::lock_guard<std::mutex> lock( m_profileLock );
+    std::map<std::pair<std::string, std::string>, xmLookupProfile>::iterator it = m_lookups.find( key );
+    if ( it == m_lookups.end() )
+    {
+        xmLookupProfile entry;
+        entry.parent = key.first;
+        entry.name = key.second;
+        entry.calls = 0;
+        entry.misses = 0;
+        entry.scannedSiblings = 0;
+        entry.maxSiblings = 0;
+        entry.childrens = 0;
+        entry.repeated = 0;
+        entry.advice = xmAdviceChildIndex;
+        it = m_lookups.insert( std::make_pair( key , entry ) ).first;
+    }
+
+    xmLookupProfile& entry = it->second;
+    ++entry.calls;
+    if ( !found )
+        ++entry.misses;
+    entry.scannedSiblings += scanned;
+
+    if ( scanned > entry.maxSiblings )
+    {
+        entry.maxSiblings = scanned;
+        Composition( parent , &entry.childrens , &entry.repeated );
+        if ( attribute )
+            entry.advice = xmAdviceAttributeIndex;
+        else if ( entry.repeated * 2 >= entry.childrens )
+            entry.advice = xmAdvicePackedArray;
+        else
+            entry.advice = xmAdviceChildIndex;
+    }
+}
+
+std::vector<xmLookupProfile> XmlManagerBase::GetLookupProfile(size_t top)
+{
+    std::vector<xmLookupProfile> entries;
+    {
+        std::lock_guard<std::mutex> lock( m_profileLock );
+        entries.reserve( m_lookups.size() );
+        std::map<std::pair<std::string, std::string>, xmLookupProfile>::const_iterator it;
+        for ( it = m_lookups.begin(); it != m_lookups.end(); ++it )
+            entries.push_back( it->second );
+    }
+
+    std::stable_sort( entries.begin() , entries.end() , MoreScanned );
+    if ( top != 0 && entries.size() > top )
+        entries.resize( top );
+    return entries;
+}
+
+void XmlManagerBase::WriteLookupReport(std::ostream& out, size_t top)
+{
+    std::vector<xmLookupProfile> entries = GetLookupProfile( top );
+
+    out << "slow lookups, most siblings visited first" << std::endl;
+    for ( size_t i = 0; i < entries.size(); ++i )
+    {
+        const xmLookupProfile& e = entries[i];
+        out << std::setw(3) << i + 1 << ". " << e.parent << " / " << e.name << std::endl
+            << "     " << e.calls << " lookups (" << e.misses << " misses), "
+            << e.scannedSiblings << " siblings visited, " << e.scannedSiblings / ( e.calls != 0 ? e.calls : 1 ) << " per lookup, "
+            << e.maxSiblings << " at most" << std::endl
+            << "     " << e.childrens << " childrens, " << e.repeated << " sharing a name : "
+            << XmlMgrLookupAdviceText( e.advice ) << std::endl;
+    }
+}
+
+void XmlManagerBase::ResetLookupProfile()
+{
+    std::lock_guard<std::mutex> lock( m_profileLock );
+    m_lookups.clear();
+}
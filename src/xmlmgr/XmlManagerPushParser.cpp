@@ -0,0 +1,175 @@
+/**
+*			@file XmlManagerPushParser.cpp
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*/
+/*******************************************************************************
+   LICENSE
+*******************************************************************************
+ Copyright (C) 2009 Numengo (admin@numengo.com)
+
+ This document is released under the terms of the numenGo EULA.  You should have received a
+ copy of the numenGo EULA along with this file; see  the file LICENSE.TXT. If not, write at
+ admin@numengo.com or at NUMENGO, 15 boulevard Vivier Merle, 69003 LYON - FRANCE
+ You are not allowed to use, copy, modify or distribute this file unless you  conform to numenGo
+ EULA license.
+*/
+
+#include <xmlmgr/XmlManagerBase.h>
+#include <xmlmgr/XmlManagerPushParser.h>
+
+#include <libxml/parser.h>
+#include <libxml/SAX2.h>
+#include <libxml/tree.h>
+
+#include <cstring>
+#include <vector>
+
+/* The parser is the libxml push parser building the tree with the default SAX2 handlers, only the
+   end of element is hooked to spot the childrens of the root element. The hook runs inside
+   xmlParseChunk, so exceptions of the handler are caught there and stop the parser. */
+
+XmlManagerPushParser::XmlManagerPushParser(XmlManagerPushHandler* handler, const char* filename, int options) :
+    m_handler( handler ), m_ctxt( NULL ), m_subtrees( 0 ), m_failed( false ), m_finished( false )
+{
+    xmlSAXHandler sax;
+    memset( &sax , 0 , sizeof(sax) );
+    xmlSAXVersion( &sax , 2 );
+    if ( m_handler != NULL )
+        sax.endElementNs = EndElement;
+
+    /* no user data, the SAX2 handlers expect the context itself */
+    m_ctxt = xmlCreatePushParserCtxt( &sax , NULL , NULL , 0 , filename );
+    if ( m_ctxt == NULL )
+    {
+        m_failed = true;
+        m_error = "cannot create the push parser";
+        return;
+    }
+    m_ctxt->_private = this;
+    xmlCtxtUseOptions( m_ctxt , options );
+}
+
+XmlManagerPushParser::~XmlManagerPushParser()
+{
+    if ( m_ctxt == NULL )
+        return;
+    if ( m_ctxt->myDoc != NULL )
+        XmlMgrFreeDoc( m_ctxt->myDoc );
+    xmlFreeParserCtxt( m_ctxt );
+}
+
+bool XmlManagerPushParser::Push(const char* chunk, size_t size)
+{
+    if ( m_failed || m_finished )
+        return false;
+
+    XmlManagerTraceSpan span( "XmlManagerPushParser::Push" );
+
+    /* xmlParseChunk takes an int size */
+    while ( size > 0 && !m_failed )
+    {
+        int part = size > (size_t) 0x40000000 ? 0x40000000 : (int) size;
+        if ( xmlParseChunk( m_ctxt , chunk , part , 0 ) != 0 || !m_ctxt->wellFormed )
+        {
+            m_failed = true;
+            KeepError( "malformed document" );
+        }
+        chunk += part;
+        size -= part;
+    }
+    return !m_failed;
+}
+
+bool XmlManagerPushParser::PushStream(std::istream& in, size_t chunkSize)
+{
+    std::vector<char> buffer( chunkSize != 0 ? chunkSize : XM_PUSH_CHUNK_SIZE );
+    while ( in )
+    {
+        in.read( &buffer[0] , buffer.size() );
+        if ( in.gcount() > 0 && !Push( &buffer[0] , (size_t) in.gcount() ) )
+            return false;
+    }
+    return !m_failed;
+}
+
+xmlDoc* XmlManagerPushParser::Finish()
+{
+    if ( m_ctxt == NULL || m_finished )
+        return NULL;
+    m_finished = true;
+
+    XmlManagerTraceSpan span( "XmlManagerPushParser::Finish" );
+
+    if ( !m_failed && ( xmlParseChunk( m_ctxt , NULL , 0 , 1 ) != 0 || !m_ctxt->wellFormed ) )
+    {
+        m_failed = true;
+        KeepError( "malformed document" );
+    }
+
+    xmlDoc* doc = m_ctxt->myDoc;
+    m_ctxt->myDoc = NULL;
+    if ( m_failed && doc != NULL )
+    {
+        XmlMgrFreeDoc( doc );
+        doc = NULL;
+    }
+    return doc;
+}
+
+void XmlManagerPushParser::EndElement(void* ctx, const unsigned char* localname, const unsigned char* prefix, const unsigned char* uri)
+{
+    xmlParserCtxt* ctxt = (xmlParserCtxt*) ctx;
+    XmlManagerPushParser* parser = (XmlManagerPushParser*) ctxt->_private;
+
+    xmlNode* node = ctxt->node;
+    xmlSAX2EndElementNs( ctx , localname , prefix , uri );
+
+    if ( node == NULL || node->parent == NULL || node->parent->type != XML_ELEMENT_NODE ||
+         node->parent->parent == NULL || node->parent->parent->type != XML_DOCUMENT_NODE )
+        return;
+
+    ++parser->m_subtrees;
+    try
+    {
+        if ( !parser->m_handler->SubtreeParsed( node ) )
+        {
+            xmlUnlinkNode( node );
+            xmlFreeNode( node );
+        }
+    }
+    catch ( std::exception& e )
+    {
+        parser->m_error = e.what();
+        parser->m_failed = true;
+        xmlStopParser( ctxt );
+    }
+    catch ( ... )
+    {
+        parser->m_error = "the subtree handler has thrown";
+        parser->m_failed = true;
+        xmlStopParser( ctxt );
+    }
+}
+
+void XmlManagerPushParser::KeepError(const char* fallback)
+{
+    if ( !m_error.empty() )
+        return;
+
+    xmlErrorPtr error = xmlCtxtGetLastError( m_ctxt );
+    if ( error != NULL && error->message != NULL )
+    {
+        m_error = error->message;
+        /* libxml messages end with a new line */
+        while ( !m_error.empty() && ( m_error[ m_error.size() - 1 ] == '\n' ) )
+            m_error.erase( m_error.size() - 1 );
+    }
+    else
+        m_error = fallback;
+}
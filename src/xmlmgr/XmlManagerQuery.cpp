@@ -0,0 +1,138 @@
+/**
+*			@file XmlManagerQuery.cpp
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*/
+/*******************************************************************************
+   LICENSE
+*******************************************************************************
+ Copyright (C) 2009 Numengo (admin@numengo.com)
+
+ This document is released under the terms of the numenGo EULA.  You should have received a
+ copy of the numenGo EULA along with this file; see  the file LICENSE.TXT. If not, write at
+ admin@numengo.com or at NUMENGO, 15 boulevard Vivier Merle, 69003 LYON - FRANCE
+ You are not allowed to use, copy, modify or distribute this file unless you  conform to numenGo
+ EULA license.
+*/
+
+#include <xmlmgr/XmlManagerBase.h>
+#include "ngoerr/NgoError.h"
+
+#include <libxml/xpath.h>
+
+/* past this number of distinct expressions the cache is flushed, queries built from values
+   would otherwise make it grow without bound */
+static const size_t s_queryCacheMaxSize = 256;
+
+/*--------------------------------------------------------------------------------------------------------------------------------------------------
+* Query results
+---------------------------------------------------------------------------------------------------------------------------------------------------*/
+XmlManagerQueryResult::XmlManagerQueryResult(xmlXPathObject* result)
+    : m_result(result), m_nodes(NULL), m_count(0)
+{
+    if ( result != NULL && result->type == XPATH_NODESET && result->nodesetval != NULL )
+    {
+        m_nodes = result->nodesetval->nodeTab;
+        m_count = result->nodesetval->nodeNr;
+    }
+}
+
+XmlManagerQueryResult::XmlManagerQueryResult(XmlManagerQueryResult&& other)
+    : m_result(other.m_result), m_nodes(other.m_nodes), m_count(other.m_count)
+{
+    other.m_result = NULL;
+    other.m_nodes = NULL;
+    other.m_count = 0;
+}
+
+XmlManagerQueryResult& XmlManagerQueryResult::operator=(XmlManagerQueryResult&& other)
+{
+    if ( this != &other )
+    {
+        if ( m_result != NULL )
+            xmlXPathFreeObject(m_result);
+
+        m_result = other.m_result;
+        m_nodes = other.m_nodes;
+        m_count = other.m_count;
+        other.m_result = NULL;
+        other.m_nodes = NULL;
+        other.m_count = 0;
+    }
+    return *this;
+}
+
+XmlManagerQueryResult::~XmlManagerQueryResult()
+{
+    if ( m_result != NULL )
+        xmlXPathFreeObject(m_result);
+}
+
+/*--------------------------------------------------------------------------------------------------------------------------------------------------
+* Queries
+---------------------------------------------------------------------------------------------------------------------------------------------------*/
+namespace
+{
+    /* evaluation contexts are not shareable between threads, each thread keeps its own */
+    struct QueryContext
+    {
+        xmlXPathContext* ctxt;
+        QueryContext() : ctxt(xmlXPathNewContext(NULL)) {}
+        ~QueryContext() { xmlXPathFreeContext(ctxt); }
+    };
+}
+
+std::shared_ptr<xmlXPathCompExpr> XmlManagerBase::CompileQuery(const std::string& xpath)
+{
+    std::lock_guard<std::mutex> guard(m_queryCacheLock);
+
+    std::map<std::string, std::shared_ptr<xmlXPathCompExpr> >::iterator it = m_queryCache.find(xpath);
+    if ( it != m_queryCache.end() )
+        return it->second;
+
+    xmlXPathCompExpr* comp = xmlXPathCompile( (const xmlChar*) xpath.c_str() );
+    if ( comp == NULL )
+        throw NgoErrorInvalidArgument(1,"invalid xpath expression","XmlManagerBase::Query");
+
+    /* expressions still being evaluated by other threads are released with their last user */
+    if ( m_queryCache.size() >= s_queryCacheMaxSize )
+        m_queryCache.clear();
+
+    std::shared_ptr<xmlXPathCompExpr> ret(comp, xmlXPathFreeCompExpr);
+    m_queryCache[xpath] = ret;
+    return ret;
+}
+
+XmlManagerQueryResult XmlManagerBase::Query(const std::string& xpath, xmlNode* rootNode)
+{
+    if ( rootNode == NULL )
+        throw NgoErrorInvalidArgument(2,"trying to query an undefined rootNode","XmlManagerBase::Query");
+
+    std::shared_ptr<xmlXPathCompExpr> comp = CompileQuery(xpath);
+
+    static thread_local QueryContext context;
+    xmlXPathContext* ctxt = context.ctxt;
+    if ( ctxt == NULL )
+        throw NgoErrorInvalidArgument(1,"unable to create an xpath context","XmlManagerBase::Query");
+
+    ctxt->doc = rootNode->doc;
+    ctxt->node = rootNode;
+
+    xmlXPathObject* result = xmlXPathCompiledEval(comp.get(), ctxt);
+
+    ctxt->doc = NULL;
+    ctxt->node = NULL;
+
+    return XmlManagerQueryResult(result);
+}
+
+void XmlManagerBase::ClearQueryCache()
+{
+    std::lock_guard<std::mutex> guard(m_queryCacheLock);
+    m_queryCache.clear();
+}
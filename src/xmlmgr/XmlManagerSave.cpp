@@ -0,0 +1,420 @@
+/**
+*			@file XmlManagerSave.cpp
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*/
+/*******************************************************************************
+   LICENSE
+*******************************************************************************
+ Copyright (C) 2009 Numengo (admin@numengo.com)
+
+ This document is released under the terms of the numenGo EULA.  You should have received a
+ copy of the numenGo EULA along with this file; see  the file LICENSE.TXT. If not, write at
+ admin@numengo.com or at NUMENGO, 15 boulevard Vivier Merle, 69003 LYON - FRANCE
+ You are not allowed to use, copy, modify or distribute this file unless you  conform to numenGo
+ EULA license.
+*/
+
+#include <xmlmgr/XmlManagerBase.h>
+#include "ngoerr/NgoError.h"
+
+#include <libxml/tree.h>
+#include <libxml/xmlIO.h>
+#include <libxml/encoding.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <set>
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <io.h>
+    #include <fcntl.h>
+    #include <process.h>
+    #include <sys/stat.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+/* ------------------------------------------------------------------------------------------------------------------
+*  File primitives
+*  ------------------------------------------------------------------------------------------------------------------*/
+
+static int OpenTemp(const std::string& name)
+{
+#ifdef _WIN32
+    return _open( name.c_str() , _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY , _S_IREAD | _S_IWRITE );
+#else
+    return open( name.c_str() , O_WRONLY | O_CREAT | O_TRUNC , 0644 );
+#endif
+}
+
+static bool SyncFile(int fd)
+{
+#ifdef _WIN32
+    return _commit( fd ) == 0;
+#else
+    return fsync( fd ) == 0;
+#endif
+}
+
+static void CloseFile(int fd)
+{
+#ifdef _WIN32
+    _close( fd );
+#else
+    close( fd );
+#endif
+}
+
+static bool ReplaceFile(const std::string& from, const std::string& to)
+{
+#ifdef _WIN32
+    return MoveFileExA( from.c_str() , to.c_str() , MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH ) != 0;
+#else
+    return rename( from.c_str() , to.c_str() ) == 0;
+#endif
+}
+
+/* the rename itself is durable once the directory holding the file is synced */
+static void SyncDirectory(const std::string& dir)
+{
+#ifndef _WIN32
+    int fd = open( dir.c_str() , O_RDONLY );
+    if ( fd < 0 )
+        return;
+    fsync( fd );
+    close( fd );
+#endif
+}
+
+static std::string DirectoryOf(const std::string& filename)
+{
+    size_t slash = filename.find_last_of( "/\\" );
+    if ( slash == std::string::npos )
+        return ".";
+    return slash == 0 ? filename.substr( 0 , 1 ) : filename.substr( 0 , slash );
+}
+
+/* temporary file next to the target, unique across processes and threads */
+static std::string TempName(const std::string& filename)
+{
+    static std::atomic<unsigned long> counter( 0 );
+    std::stringstream s;
+#ifdef _WIN32
+    s << filename << ".tmp" << _getpid() << "." << counter++;
+#else
+    s << filename << ".tmp" << getpid() << "." << counter++;
+#endif
+    return s.str();
+}
+
+static double Seconds(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to)
+{
+    return std::chrono::duration<double>( to - from ).count();
+}
+
+/* ------------------------------------------------------------------------------------------------------------------
+*  Saves to memory, descriptors and callbacks
+*  ------------------------------------------------------------------------------------------------------------------*/
+
+/* UTF-8 needs no conversion, libxml then writes the serialized text straight to the output
+   instead of copying it through the converter */
+static xmlCharEncodingHandler* SaveEncoder(const char* encoding, bool* known)
+{
+    *known = true;
+    if ( encoding == NULL || xmlStrcasecmp( (const xmlChar*) encoding , (const xmlChar*) "UTF-8" ) == 0 )
+        return NULL;
+
+    xmlCharEncodingHandler* handler = xmlFindCharEncodingHandler( encoding );
+    *known = handler != NULL;
+    return handler;
+}
+
+/* counts the bytes given to the caller, the return of xmlSaveFormatFileTo includes nothing else */
+struct SaveTarget
+{
+    xmSaveWriteFunc write;
+    void* context;
+    std::string* buffer;
+    int fd;
+    bool failed;
+};
+
+static int SaveTargetWrite(void* context, const char* data, int len)
+{
+    SaveTarget* target = (SaveTarget*) context;
+    if ( target->buffer != NULL )
+    {
+        target->buffer->append( data , len );
+        return len;
+    }
+
+    if ( target->write != NULL )
+    {
+        int written = target->write( target->context , data , len );
+        if ( written < 0 )
+            target->failed = true;
+        return written;
+    }
+
+    int done = 0;
+    while ( done < len )
+    {
+#ifdef _WIN32
+        int n = _write( target->fd , data + done , len - done );
+#else
+        int n = (int) write( target->fd , data + done , len - done );
+        if ( n < 0 && errno == EINTR )
+            continue;
+#endif
+        if ( n <= 0 )
+        {
+            target->failed = true;
+            return -1;
+        }
+        done += n;
+    }
+    return len;
+}
+
+static int SaveTargetClose(void*)
+{
+    return 0;
+}
+
+static int SaveToTarget(xmlDoc* doc, SaveTarget* target, const char* encoding, int format, const char* where)
+{
+    if ( doc == NULL )
+        throw NgoErrorInvalidArgument(1,"trying to save an undefined document",where);
+
+    bool known;
+    xmlCharEncodingHandler* handler = SaveEncoder( encoding , &known );
+    if ( !known )
+        throw NgoErrorInvalidArgument(3,"unknown encoding",where);
+
+    XmlManagerTraceSpan span( where );
+    xmlOutputBuffer* out = xmlOutputBufferCreateIO( SaveTargetWrite , SaveTargetClose , target , handler );
+    if ( out == NULL )
+        return -1;
+
+    int bytes = xmlSaveFormatFileTo( out , doc , encoding , format );
+    return target->failed ? -1 : bytes;
+}
+
+int XmlMgrSaveToBuffer(xmlDoc* doc, std::string* buffer, const char* encoding, int format)
+{
+    if ( buffer == NULL )
+        throw NgoErrorInvalidArgument(2,"trying to save in an undefined buffer","XmlMgrSaveToBuffer");
+
+    buffer->clear();
+    SaveTarget target = { NULL , NULL , buffer , -1 , false };
+    return SaveToTarget( doc , &target , encoding , format , "XmlMgrSaveToBuffer" );
+}
+
+int XmlMgrSaveToFd(xmlDoc* doc, int fd, const char* encoding, int format)
+{
+    if ( fd < 0 )
+        throw NgoErrorInvalidArgument(2,"trying to save in an invalid file descriptor","XmlMgrSaveToFd");
+
+    SaveTarget target = { NULL , NULL , NULL , fd , false };
+    return SaveToTarget( doc , &target , encoding , format , "XmlMgrSaveToFd" );
+}
+
+int XmlMgrSaveToIO(xmlDoc* doc, xmSaveWriteFunc write, void* context, const char* encoding, int format)
+{
+    if ( write == NULL )
+        throw NgoErrorInvalidArgument(2,"trying to save through an undefined callback","XmlMgrSaveToIO");
+
+    SaveTarget target = { write , context , NULL , -1 , false };
+    return SaveToTarget( doc , &target , encoding , format , "XmlMgrSaveToIO" );
+}
+
+/* ------------------------------------------------------------------------------------------------------------------
+*  Group commit
+*  ------------------------------------------------------------------------------------------------------------------*/
+
+struct XmlManagerBase::PendingCommit
+{
+    int fd;
+    std::string temp;
+    std::string target;
+    bool done;
+    bool ok;
+    size_t groupSize;
+};
+
+void XmlManagerBase::CommitFiles(PendingCommit* commits, size_t count)
+{
+    std::unique_lock<std::mutex> lock( m_commitLock );
+
+    for ( size_t i = 0; i < count; ++i )
+        m_commitQueue.push_back( &commits[i] );
+
+    for ( size_t i = 0; i < count; ++i )
+    {
+        while ( !commits[i].done )
+        {
+            if ( m_commitRunning )
+            {
+                m_commitDone.wait( lock );
+                continue;
+            }
+
+            /* this thread leads the next round, for its files and the ones queued meanwhile */
+            m_commitRunning = true;
+            if ( m_commitWindow != 0 )
+            {
+                lock.unlock();
+                std::this_thread::sleep_for( std::chrono::microseconds( m_commitWindow ) );
+                lock.lock();
+            }
+
+            std::vector<PendingCommit*> batch;
+            batch.swap( m_commitQueue );
+            lock.unlock();
+
+            SyncRound( batch );
+
+            lock.lock();
+            for ( size_t k = 0; k < batch.size(); ++k )
+                batch[k]->done = true;
+            m_commitRunning = false;
+            m_commitDone.notify_all();
+        }
+    }
+}
+
+/* one fsync round : files first, then the renames, then each directory once */
+void XmlManagerBase::SyncRound(const std::vector<PendingCommit*>& batch)
+{
+    XmlManagerTraceSpan span( "XmlManagerBase::SyncRound" );
+    for ( size_t i = 0; i < batch.size(); ++i )
+    {
+        batch[i]->ok = SyncFile( batch[i]->fd );
+        CloseFile( batch[i]->fd );
+    }
+
+    std::set<std::string> directories;
+    for ( size_t i = 0; i < batch.size(); ++i )
+    {
+        batch[i]->groupSize = batch.size();
+        if ( batch[i]->ok )
+            batch[i]->ok = ReplaceFile( batch[i]->temp , batch[i]->target );
+        if ( batch[i]->ok )
+            directories.insert( DirectoryOf( batch[i]->target ) );
+        else
+            remove( batch[i]->temp.c_str() );
+    }
+
+    for ( std::set<std::string>::const_iterator it = directories.begin(); it != directories.end(); ++it )
+        SyncDirectory( *it );
+}
+
+/* ------------------------------------------------------------------------------------------------------------------
+*  Saves
+*  ------------------------------------------------------------------------------------------------------------------*/
+
+bool XmlManagerBase::SaveAtomic(std::vector<xmSaveJob>& jobs, const char* encoding, int format)
+{
+    XmlManagerTraceSpan span( "XmlManagerBase::SaveAtomic" );
+    typedef std::chrono::steady_clock Clock;
+
+    std::vector<PendingCommit> commits( jobs.size() );
+    std::vector<Clock::time_point> started( jobs.size() ), written( jobs.size() );
+    std::vector<size_t> slot( jobs.size() , (size_t) -1 );
+    size_t pending = 0;
+
+    /* the encoding and the documents are checked before any file is written, xmlSaveFormatFileTo
+       closes the handler it is given so every job looks up its own */
+    bool known;
+    xmlCharEncodingHandler* handler = SaveEncoder( encoding , &known );
+    if ( !known )
+        throw NgoErrorInvalidArgument(3,"unknown encoding","XmlManagerBase::SaveAtomic");
+    if ( handler != NULL )
+        xmlCharEncCloseFunc( handler );
+
+    for ( size_t i = 0; i < jobs.size(); ++i )
+        if ( jobs[i].doc == NULL )
+            throw NgoErrorInvalidArgument(1,"trying to save an undefined document","XmlManagerBase::SaveAtomic");
+
+    for ( size_t i = 0; i < jobs.size(); ++i )
+    {
+        xmSaveJob& job = jobs[i];
+        started[i] = Clock::now();
+        job.result.bytes = -1;
+        job.result.groupSize = 0;
+
+        PendingCommit& c = commits[pending];
+        c.temp = TempName( job.filename );
+        c.target = job.filename;
+        c.done = false;
+        c.ok = false;
+        c.groupSize = 0;
+        c.fd = OpenTemp( c.temp );
+
+        if ( c.fd >= 0 )
+        {
+            /* the buffer does not own the descriptor, it is kept open for the fsync */
+            xmlOutputBuffer* out = xmlOutputBufferCreateFd( c.fd , SaveEncoder( encoding , &known ) );
+            job.result.bytes = ( out != NULL ) ? xmlSaveFormatFileTo( out , job.doc , encoding , format ) : -1;
+            if ( job.result.bytes < 0 )
+            {
+                CloseFile( c.fd );
+                remove( c.temp.c_str() );
+            }
+        }
+
+        written[i] = Clock::now();
+        job.result.writeTime = Seconds( started[i] , written[i] );
+        if ( job.result.bytes >= 0 )
+            slot[i] = pending++;
+    }
+
+    CommitFiles( commits.data() , pending );
+
+    bool ok = true;
+    Clock::time_point committed = Clock::now();
+    for ( size_t i = 0; i < jobs.size(); ++i )
+    {
+        xmSaveResult& r = jobs[i].result;
+        if ( slot[i] != (size_t) -1 )
+        {
+            const PendingCommit& c = commits[slot[i]];
+            r.groupSize = c.groupSize;
+            if ( !c.ok )
+                r.bytes = -1;
+        }
+        r.commitTime = ( r.bytes >= 0 ) ? Seconds( written[i] , committed ) : 0.0;
+        r.totalTime = Seconds( started[i] , committed );
+        ok = ok && r.bytes >= 0;
+    }
+    return ok;
+}
+
+int XmlManagerBase::SaveAtomic(xmlDoc* doc, const std::string& filename, xmSaveResult* result, const char* encoding, int format)
+{
+    std::vector<xmSaveJob> jobs( 1 );
+    jobs[0].doc = doc;
+    jobs[0].filename = filename;
+    SaveAtomic( jobs , encoding , format );
+
+    if ( result != NULL )
+        *result = jobs[0].result;
+    return jobs[0].result.bytes;
+}
+
+void XmlManagerBase::SetSaveGroupWindow(unsigned int microseconds)
+{
+    std::lock_guard<std::mutex> lock( m_commitLock );
+    m_commitWindow = microseconds;
+}
@@ -0,0 +1,199 @@
+/**
+*			@file XmlManagerStats.cpp
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*/
+/*******************************************************************************
+   LICENSE
+*******************************************************************************
+ Copyright (C) 2009 Numengo (admin@numengo.com)
+
+ This document is released under the terms of the numenGo EULA.  You should have received a
+ copy of the numenGo EULA along with this file; see  the file LICENSE.TXT. If not, write at
+ admin@numengo.com or at NUMENGO, 15 boulevard Vivier Merle, 69003 LYON - FRANCE
+ You are not allowed to use, copy, modify or distribute this file unless you  conform to numenGo
+ EULA license.
+*/
+
+#include <xmlmgr/XmlManagerBase.h>
+#include "XmlManagerThreadBlocks.h"
+
+#include <chrono>
+
+/* Every thread counts in its own block of relaxed atomics, a block has a single writer so a count
+   is a load and a store, never a locked instruction. A snapshot sums the blocks under the registry
+   lock. */
+
+namespace
+{
+
+typedef std::atomic<unsigned long long> Counter;
+
+struct ThreadCounters
+{
+    Counter calls[xmStatsCallCount];
+    Counter latency[xmStatsCallCount][XM_STATS_BUCKETS];
+    Counter scans;
+    Counter scannedSiblings;
+    Counter scanLength[XM_STATS_BUCKETS];
+    Counter nodesCreated;
+    Counter contentCopies;
+    Counter contentBytes;
+    /** true while a thread counts in the block */
+    std::atomic<bool> used;
+};
+
+typedef XmlManagerThreadBlocks<ThreadCounters> CounterBlocks;
+
+ThreadCounters* NewCounters(size_t)
+{
+    return new ThreadCounters();
+}
+
+inline ThreadCounters* LocalCounters()
+{
+    return CounterBlocks::Local( NewCounters );
+}
+
+inline void Bump(Counter& c, unsigned long long n)
+{
+    c.store( c.load( std::memory_order_relaxed ) + n , std::memory_order_relaxed );
+}
+
+inline unsigned long long Load(const Counter& c)
+{
+    return c.load( std::memory_order_relaxed );
+}
+
+} // end of anonymous namespace
+
+const char* XmlMgrStatsCallName(xmStatsCall call)
+{
+    switch ( call )
+    {
+        case xmStatsReadValue : return "read_value";
+        case xmStatsWriteValue : return "write_value";
+        case xmStatsReadArray : return "read_array";
+        case xmStatsWriteArray : return "write_array";
+        case xmStatsReadAttribute : return "read_attribute";
+        case xmStatsWriteAttribute : return "write_attribute";
+        case xmStatsGetNode : return "get_node";
+        default : return "unknown";
+    }
+}
+
+unsigned long long XmlMgrStatsPercentile(const unsigned long long* histogram, double p)
+{
+    unsigned long long total = 0;
+    for ( size_t b = 0; b < XM_STATS_BUCKETS; ++b )
+        total += histogram[b];
+    if ( total == 0 )
+        return 0;
+
+    unsigned long long rank = (unsigned long long) ( p * total );
+    if ( rank >= total )
+        rank = total - 1;
+
+    unsigned long long seen = 0;
+    for ( size_t b = 0; b < XM_STATS_BUCKETS; ++b )
+    {
+        seen += histogram[b];
+        if ( seen > rank )
+            return b == 0 ? 0 : ( 1ULL << b ) - 1;
+    }
+    return ( 1ULL << ( XM_STATS_BUCKETS - 1 ) ) - 1;
+}
+
+void XmlManagerBase::EnableStats(bool enable)
+{
+    m_statsEnabled.store( enable , std::memory_order_relaxed );
+}
+
+void XmlManagerBase::GetStats(xmStats* stats)
+{
+    *stats = xmStats();
+
+    std::lock_guard<std::mutex> lock( CounterBlocks::Lock() );
+    const std::vector<ThreadCounters*>& blocks = CounterBlocks::Blocks();
+    stats->threads = blocks.size();
+
+    for ( size_t i = 0; i < blocks.size(); ++i )
+    {
+        const ThreadCounters* c = blocks[i];
+        for ( size_t k = 0; k < xmStatsCallCount; ++k )
+        {
+            stats->calls[k] += Load( c->calls[k] );
+            for ( size_t b = 0; b < XM_STATS_BUCKETS; ++b )
+                stats->latency[k][b] += Load( c->latency[k][b] );
+        }
+        stats->scans += Load( c->scans );
+        stats->scannedSiblings += Load( c->scannedSiblings );
+        for ( size_t b = 0; b < XM_STATS_BUCKETS; ++b )
+            stats->scanLength[b] += Load( c->scanLength[b] );
+        stats->nodesCreated += Load( c->nodesCreated );
+        stats->contentCopies += Load( c->contentCopies );
+        stats->contentBytes += Load( c->contentBytes );
+    }
+}
+
+void XmlManagerBase::ResetStats()
+{
+    std::lock_guard<std::mutex> lock( CounterBlocks::Lock() );
+    const std::vector<ThreadCounters*>& blocks = CounterBlocks::Blocks();
+
+    /* a count racing with the reset may be lost, the counters are statistics */
+    for ( size_t i = 0; i < blocks.size(); ++i )
+    {
+        ThreadCounters* c = blocks[i];
+        for ( size_t k = 0; k < xmStatsCallCount; ++k )
+        {
+            c->calls[k].store( 0 , std::memory_order_relaxed );
+            for ( size_t b = 0; b < XM_STATS_BUCKETS; ++b )
+                c->latency[k][b].store( 0 , std::memory_order_relaxed );
+        }
+        c->scans.store( 0 , std::memory_order_relaxed );
+        c->scannedSiblings.store( 0 , std::memory_order_relaxed );
+        for ( size_t b = 0; b < XM_STATS_BUCKETS; ++b )
+            c->scanLength[b].store( 0 , std::memory_order_relaxed );
+        c->nodesCreated.store( 0 , std::memory_order_relaxed );
+        c->contentCopies.store( 0 , std::memory_order_relaxed );
+        c->contentBytes.store( 0 , std::memory_order_relaxed );
+    }
+}
+
+unsigned long long XmlManagerBase::StatsClock()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+void XmlManagerBase::RecordCall(xmStatsCall call, unsigned long long nanoseconds)
+{
+    ThreadCounters* c = LocalCounters();
+    Bump( c->calls[call] , 1 );
+    Bump( c->latency[call][ XmlMgrStatsBucket( nanoseconds ) ] , 1 );
+}
+
+void XmlManagerBase::RecordScan(size_t siblings)
+{
+    ThreadCounters* c = LocalCounters();
+    Bump( c->scans , 1 );
+    Bump( c->scannedSiblings , siblings );
+    Bump( c->scanLength[ XmlMgrStatsBucket( siblings ) ] , 1 );
+}
+
+void XmlManagerBase::RecordNodes(size_t count)
+{
+    Bump( LocalCounters()->nodesCreated , count );
+}
+
+void XmlManagerBase::RecordContent(size_t bytes)
+{
+    ThreadCounters* c = LocalCounters();
+    Bump( c->contentCopies , 1 );
+    Bump( c->contentBytes , bytes );
+}
@@ -0,0 +1,162 @@
+/**
+*			@file XmlManagerSubscription.cpp
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*/
+/*******************************************************************************
+   LICENSE
+*******************************************************************************
+ Copyright (C) 2009 Numengo (admin@numengo.com)
+
+ This document is released under the terms of the numenGo EULA.  You should have received a
+ copy of the numenGo EULA along with this file; see  the file LICENSE.TXT. If not, write at
+ admin@numengo.com or at NUMENGO, 15 boulevard Vivier Merle, 69003 LYON - FRANCE
+ You are not allowed to use, copy, modify or distribute this file unless you  conform to numenGo
+ EULA license.
+*/
+
+#include <xmlmgr/XmlManagerBase.h>
+#include "ngoerr/NgoError.h"
+
+#include <libxml/tree.h>
+
+/* Subscriptions are indexed by the watched node. A write looks up the changed node and its
+   ancestors, so the cost is one hash lookup per level, and nothing but an atomic load when
+   there is no subscription. The subscribers are called once the lock is released. */
+
+typedef std::pair<xmlNode*, XmlManagerListener*> Call;
+
+static void Fire(const std::vector<Call>& calls, const std::vector<std::atomic<bool>*>& flags, xmlNode* changed)
+{
+    for ( size_t i = 0; i < flags.size(); ++i )
+        flags[i]->store( true );
+    for ( size_t i = 0; i < calls.size(); ++i )
+        calls[i].second->Changed( calls[i].first , changed );
+}
+
+size_t XmlManagerBase::Subscribe(const std::string& path, xmlNode* rootNode, XmlManagerListener* listener)
+{
+    if ( listener == NULL )
+        throw NgoErrorInvalidArgument(3,"trying to subscribe an undefined listener","XmlManagerBase::Subscribe");
+    if ( rootNode == NULL )
+        throw NgoErrorInvalidArgument(2,"trying to subscribe to an undefined rootNode","XmlManagerBase::Subscribe");
+
+    xmlNode* n = GetNode( path , rootNode , false );
+    if ( n == NULL )
+        throw NgoErrorInvalidArgument(1,"trying to subscribe to an unexisting node","XmlManagerBase::Subscribe");
+
+    std::lock_guard<std::mutex> lock( m_subscriptionLock );
+    Subscription s = { m_nextSubscription++ , listener , NULL };
+    m_subscriptions.insert( std::make_pair( n , s ) );
+    m_subscriptionCount.store( m_subscriptions.size() );
+    return s.id;
+}
+
+size_t XmlManagerBase::Subscribe(const std::string& path, xmlNode* rootNode, std::atomic<bool>* dirty)
+{
+    if ( dirty == NULL )
+        throw NgoErrorInvalidArgument(3,"trying to subscribe an undefined flag","XmlManagerBase::Subscribe");
+    if ( rootNode == NULL )
+        throw NgoErrorInvalidArgument(2,"trying to subscribe to an undefined rootNode","XmlManagerBase::Subscribe");
+
+    xmlNode* n = GetNode( path , rootNode , false );
+    if ( n == NULL )
+        throw NgoErrorInvalidArgument(1,"trying to subscribe to an unexisting node","XmlManagerBase::Subscribe");
+
+    std::lock_guard<std::mutex> lock( m_subscriptionLock );
+    Subscription s = { m_nextSubscription++ , NULL , dirty };
+    m_subscriptions.insert( std::make_pair( n , s ) );
+    m_subscriptionCount.store( m_subscriptions.size() );
+    return s.id;
+}
+
+void XmlManagerBase::Unsubscribe(size_t id)
+{
+    std::lock_guard<std::mutex> lock( m_subscriptionLock );
+
+    for ( std::unordered_multimap<xmlNode*, Subscription>::iterator it = m_subscriptions.begin(); it != m_subscriptions.end(); ++it )
+    {
+        if ( it->second.id == id )
+        {
+            m_subscriptions.erase( it );
+            break;
+        }
+    }
+    m_subscriptionCount.store( m_subscriptions.size() );
+}
+
+void XmlManagerBase::DispatchChange(xmlNode* n, bool ancestors)
+{
+    std::vector<Call> calls;
+    std::vector<std::atomic<bool>*> flags;
+
+    {
+        std::lock_guard<std::mutex> lock( m_subscriptionLock );
+
+        for ( xmlNode* p = n; p != NULL; p = ancestors ? p->parent : NULL )
+        {
+            std::pair<std::unordered_multimap<xmlNode*, Subscription>::iterator,
+                      std::unordered_multimap<xmlNode*, Subscription>::iterator> range = m_subscriptions.equal_range( p );
+
+            for ( std::unordered_multimap<xmlNode*, Subscription>::iterator it = range.first; it != range.second; ++it )
+            {
+                if ( it->second.listener != NULL )
+                    calls.push_back( Call( p , it->second.listener ) );
+                else
+                    flags.push_back( it->second.dirty );
+            }
+        }
+    }
+
+    Fire( calls , flags , n );
+}
+
+void XmlManagerBase::DropSubscriptions(xmlNode* n, bool fire)
+{
+    if ( m_subscriptionCount.load( std::memory_order_relaxed ) == 0 )
+        return;
+
+    std::vector<Call> calls;
+    std::vector<std::atomic<bool>*> flags;
+
+    {
+        std::lock_guard<std::mutex> lock( m_subscriptionLock );
+
+        /* the watched nodes living in the deleted subtree lose their subscriptions, the subtree is
+           walked once with one lookup per element */
+        xmlNode* p = n;
+        while ( p != NULL && !m_subscriptions.empty() )
+        {
+            std::pair<std::unordered_multimap<xmlNode*, Subscription>::iterator,
+                      std::unordered_multimap<xmlNode*, Subscription>::iterator> range = m_subscriptions.equal_range( p );
+
+            for ( std::unordered_multimap<xmlNode*, Subscription>::iterator it = range.first; it != range.second; ++it )
+            {
+                if ( it->second.listener != NULL )
+                    calls.push_back( Call( p , it->second.listener ) );
+                else
+                    flags.push_back( it->second.dirty );
+            }
+            m_subscriptions.erase( range.first , range.second );
+
+            /* next element in document order without leaving the subtree */
+            if ( p->children != NULL && p->type == XML_ELEMENT_NODE )
+            {
+                p = p->children;
+                continue;
+            }
+            while ( p != n && p->next == NULL )
+                p = p->parent;
+            p = p != n ? p->next : NULL;
+        }
+        m_subscriptionCount.store( m_subscriptions.size() );
+    }
+
+    if ( fire )
+        Fire( calls , flags , n );
+}
@@ -0,0 +1,116 @@
+/**
+*			@file XmlManagerThreadBlocks.h
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*/
+
+#ifndef _XmlManagerThreadBlocks_h_
+#define _XmlManagerThreadBlocks_h_
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+/**
+*		@class XmlManagerThreadBlocks
+*
+*		@brief Internal registry of per-thread blocks used by the statistics and the trace of the XmlManager
+*
+*		Every thread gets its own block, the thread is its only writer. A block is given back when its
+*		thread exits and reused by the next thread, the blocks and the registry are never freed so that a
+*		thread may outlive the manager. Readers walk the blocks under the registry lock.
+*
+*		Block must have a std::atomic<bool> used member, true while a thread owns the block.
+*/
+template <class Block>
+class XmlManagerThreadBlocks
+{
+public :
+    /**
+    * @brief Returns the block of the calling thread
+    *
+    *	@param create called as create(index) under the registry lock when no block is free, index
+    *	being the position of the new block in the registry, it returns a block allocated with new
+    */
+    template <class Create>
+    static Block* Local(Create create)
+    {
+        Slot& slot = LocalSlot();
+        if ( slot.block == NULL )
+            slot.block = Acquire( create );
+        return slot.block;
+    }
+
+    /**
+    * @brief Returns the lock to hold while reading Blocks
+    */
+    static std::mutex& Lock()
+    {
+        return Get().lock;
+    }
+
+    /**
+    * @brief Returns every block handed out so far, the registry lock must be held
+    */
+    static const std::vector<Block*>& Blocks()
+    {
+        return Get().blocks;
+    }
+
+private :
+    struct Registry
+    {
+        std::mutex lock;
+        std::vector<Block*> blocks;
+    };
+
+    /** block of the calling thread, released at thread exit */
+    struct Slot
+    {
+        Block* block;
+        ~Slot()
+        {
+            if ( block != NULL )
+                block->used.store( false , std::memory_order_release );
+        }
+    };
+
+    static Registry& Get()
+    {
+        static Registry* registry = new Registry;
+        return *registry;
+    }
+
+    static Slot& LocalSlot()
+    {
+        static thread_local Slot slot = { NULL };
+        return slot;
+    }
+
+    template <class Create>
+    static Block* Acquire(Create create)
+    {
+        Registry& registry = Get();
+        std::lock_guard<std::mutex> lock( registry.lock );
+
+        Block* block = NULL;
+        for ( size_t i = 0; i < registry.blocks.size() && block == NULL; ++i )
+            if ( !registry.blocks[i]->used.load( std::memory_order_acquire ) )
+                block = registry.blocks[i];
+        if ( block == NULL )
+        {
+            block = create( registry.blocks.size() );
+            registry.blocks.push_back( block );
+        }
+        block->used.store( true , std::memory_order_relaxed );
+        return block;
+    }
+};
+
+#endif
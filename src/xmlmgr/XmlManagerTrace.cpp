@@ -0,0 +1,194 @@
+/**
+*			@file XmlManagerTrace.cpp
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*/
+/*******************************************************************************
+   LICENSE
+*******************************************************************************
+ Copyright (C) 2009 Numengo (admin@numengo.com)
+
+ This document is released under the terms of the numenGo EULA.  You should have received a
+ copy of the numenGo EULA along with this file; see  the file LICENSE.TXT. If not, write at
+ admin@numengo.com or at NUMENGO, 15 boulevard Vivier Merle, 69003 LYON - FRANCE
+ You are not allowed to use, copy, modify or distribute this file unless you  conform to numenGo
+ EULA license.
+*/
+
+#include <xmlmgr/XmlManagerBase.h>
+#include <xmlmgr/XmlManagerTrace.h>
+#include "XmlManagerThreadBlocks.h"
+
+#include <chrono>
+#include <fstream>
+
+/* Every thread records its spans in its own ring, the owner is the only writer so a span is a few
+   relaxed stores and a release of the ring head, without lock. Dumping reads the last spans of every ring, a span being written at the same time
+   may come out torn, dump when the traced work is done. */
+
+std::atomic<bool> XmlManagerTraceSpan::s_enabled( false );
+std::atomic<size_t> XmlManagerTraceSpan::s_capacity( XM_TRACE_CAPACITY );
+
+namespace
+{
+
+struct TraceEvent
+{
+    std::atomic<const char*> name;
+    std::atomic<unsigned long long> start;
+    std::atomic<unsigned long long> end;
+};
+
+struct TraceRing
+{
+    /** thread id shown in the trace */
+    size_t tid;
+    size_t capacity;
+    TraceEvent* events;
+    /** number of spans recorded, the last capacity ones are kept */
+    std::atomic<unsigned long long> head;
+    /** true while a thread records in the ring */
+    std::atomic<bool> used;
+};
+
+typedef XmlManagerThreadBlocks<TraceRing> RingBlocks;
+
+/** creates the ring at position index of the registry */
+struct NewRing
+{
+    size_t capacity;
+    TraceRing* operator()(size_t index) const
+    {
+        TraceRing* ring = new TraceRing();
+        ring->tid = index + 1;
+        ring->capacity = capacity;
+        ring->events = new TraceEvent[capacity]();
+        return ring;
+    }
+};
+
+void WriteName(std::ostream& out, const char* name)
+{
+    out << '"';
+    for ( const char* c = name; *c != '\0'; ++c )
+    {
+        if ( *c == '"' || *c == '\\' )
+            out << '\\';
+        if ( (unsigned char) *c >= 0x20 )
+            out << *c;
+    }
+    out << '"';
+}
+
+} // end of anonymous namespace
+
+unsigned long long XmlManagerTraceSpan::Now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+void XmlManagerTraceSpan::Record(const char* name, unsigned long long start, unsigned long long end)
+{
+    NewRing create = { s_capacity.load( std::memory_order_relaxed ) };
+    TraceRing* ring = RingBlocks::Local( create );
+    unsigned long long head = ring->head.load( std::memory_order_relaxed );
+
+    TraceEvent& e = ring->events[ head % ring->capacity ];
+    e.name.store( name , std::memory_order_relaxed );
+    e.start.store( start , std::memory_order_relaxed );
+    e.end.store( end , std::memory_order_relaxed );
+    ring->head.store( head + 1 , std::memory_order_release );
+}
+
+void XmlManagerBase::EnableTrace(bool enable, size_t capacity)
+{
+    XmlManagerTraceSpan::s_capacity.store( capacity != 0 ? capacity : XM_TRACE_CAPACITY , std::memory_order_relaxed );
+    XmlManagerTraceSpan::s_enabled.store( enable , std::memory_order_relaxed );
+}
+
+bool XmlManagerBase::IsTraceEnabled() const
+{
+    return XmlManagerTraceSpan::s_enabled.load( std::memory_order_relaxed );
+}
+
+void XmlManagerBase::ClearTrace()
+{
+    std::lock_guard<std::mutex> lock( RingBlocks::Lock() );
+    const std::vector<TraceRing*>& rings = RingBlocks::Blocks();
+    for ( size_t i = 0; i < rings.size(); ++i )
+        rings[i]->head.store( 0 , std::memory_order_relaxed );
+}
+
+size_t XmlManagerBase::WriteTrace(std::ostream& out)
+{
+    std::lock_guard<std::mutex> lock( RingBlocks::Lock() );
+    const std::vector<TraceRing*>& rings = RingBlocks::Blocks();
+
+    /* the spans of a ring and their range, times are written relative to the first span */
+    struct Range { TraceRing* ring; unsigned long long first; unsigned long long last; };
+    std::vector<Range> ranges;
+    unsigned long long origin = ~0ULL;
+
+    for ( size_t i = 0; i < rings.size(); ++i )
+    {
+        TraceRing* ring = rings[i];
+        unsigned long long head = ring->head.load( std::memory_order_acquire );
+        unsigned long long first = head > ring->capacity ? head - ring->capacity : 0;
+        if ( first == head )
+            continue;
+
+        Range r = { ring , first , head };
+        ranges.push_back( r );
+        for ( unsigned long long k = first; k < head; ++k )
+        {
+            unsigned long long start = ring->events[ k % ring->capacity ].start.load( std::memory_order_relaxed );
+            if ( start < origin )
+                origin = start;
+        }
+    }
+
+    size_t written = 0;
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    for ( size_t i = 0; i < ranges.size(); ++i )
+    {
+        const Range& r = ranges[i];
+        out << ( i == 0 ? "\n" : ",\n" );
+        out << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << r.ring->tid
+            << ",\"args\":{\"name\":\"thread " << r.ring->tid << "\"}}";
+
+        for ( unsigned long long k = r.first; k < r.last; ++k )
+        {
+            const TraceEvent& e = r.ring->events[ k % r.ring->capacity ];
+            const char* name = e.name.load( std::memory_order_relaxed );
+            unsigned long long start = e.start.load( std::memory_order_relaxed );
+            unsigned long long end = e.end.load( std::memory_order_relaxed );
+            if ( name == NULL || end < start || start < origin )
+                continue;
+
+            out << ",\n{\"ph\":\"X\",\"cat\":\"xmlmgr\",\"name\":";
+            WriteName( out , name );
+            out << ",\"pid\":1,\"tid\":" << r.ring->tid
+                << ",\"ts\":" << ( start - origin ) / 1000 << '.' << ( ( start - origin ) % 1000 ) / 100
+                << ",\"dur\":" << ( end - start ) / 1000 << '.' << ( ( end - start ) % 1000 ) / 100 << '}';
+            ++written;
+        }
+    }
+    out << "\n]}\n";
+    return written;
+}
+
+bool XmlManagerBase::WriteTrace(const std::string& filename)
+{
+    std::ofstream out( filename.c_str() );
+    if ( !out )
+        return false;
+
+    WriteTrace( out );
+    out.close();
+    return !out.fail();
+}
@@ -0,0 +1,256 @@
+/**
+*			@file XmlManagerWorkPool.cpp
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*/
+/*******************************************************************************
+   LICENSE
+*******************************************************************************
+ Copyright (C) 2009 Numengo (admin@numengo.com)
+
+ This document is released under the terms of the numenGo EULA.  You should have received a
+ copy of the numenGo EULA along with this file; see  the file LICENSE.TXT. If not, write at
+ admin@numengo.com or at NUMENGO, 15 boulevard Vivier Merle, 69003 LYON - FRANCE
+ You are not allowed to use, copy, modify or distribute this file unless you  conform to numenGo
+ EULA license.
+*/
+
+#include "XmlManagerWorkPool.h"
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    /** range of task indexes owned by one worker */
+    struct WorkRange
+    {
+        std::mutex lock;
+        size_t begin;
+        size_t end;
+    };
+
+    struct WorkState
+    {
+        std::vector<WorkRange> ranges;
+        const std::function<void(size_t)>* task;
+        std::mutex errorLock;
+        std::exception_ptr error;
+
+        explicit WorkState(size_t n) : ranges(n), task(NULL) {}
+    };
+
+    /* pop the next task of our own range */
+    bool PopFront(WorkRange& r, size_t* index)
+    {
+        std::lock_guard<std::mutex> guard(r.lock);
+        if ( r.begin >= r.end )
+            return false;
+        *index = r.begin++;
+        return true;
+    }
+
+    /* steal the back half of the largest range and make it ours */
+    bool Steal(WorkState& state, size_t self)
+    {
+        size_t victim = self;
+        size_t best = 0;
+        for ( size_t i = 0; i < state.ranges.size(); ++i )
+        {
+            if ( i == self )
+                continue;
+            WorkRange& r = state.ranges[i];
+            std::lock_guard<std::mutex> guard(r.lock);
+            if ( r.end > r.begin && r.end - r.begin > best )
+            {
+                best = r.end - r.begin;
+                victim = i;
+            }
+        }
+        if ( victim == self )
+            return false;
+
+        size_t b, e;
+        {
+            WorkRange& r = state.ranges[victim];
+            std::lock_guard<std::mutex> guard(r.lock);
+            if ( r.begin >= r.end )
+                return true; // emptied meanwhile, look again
+            size_t half = (r.end - r.begin + 1) / 2;
+            e = r.end;
+            b = r.end - half;
+            r.end = b;
+        }
+
+        WorkRange& mine = state.ranges[self];
+        std::lock_guard<std::mutex> guard(mine.lock);
+        mine.begin = b;
+        mine.end = e;
+        return true;
+    }
+
+    void Work(WorkState* state, size_t self)
+    {
+        size_t index;
+        for ( ;; )
+        {
+            while ( PopFront(state->ranges[self], &index) )
+            {
+                try
+                {
+                    (*state->task)(index);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> guard(state->errorLock);
+                    if ( !state->error )
+                        state->error = std::current_exception();
+                }
+            }
+            if ( !Steal(*state, self) )
+                return;
+        }
+    }
+}
+
+unsigned int XmlManagerWorkPool::Workers(unsigned int threads)
+{
+    if ( threads == 0 )
+        threads = std::thread::hardware_concurrency();
+    if ( threads == 0 )
+        threads = 1;
+    return threads;
+}
+
+namespace
+{
+    /* true on the threads running a task, a nested Run is sequential */
+    thread_local bool t_inRun = false;
+
+    /** threads started once and parked between the runs */
+    class WorkThreads
+    {
+    public :
+        WorkThreads() : m_state( NULL ), m_workers( 0 ), m_pending( 0 ), m_generation( 0 ) {}
+
+        /* one run at a time, the calling thread is worker 0 */
+        void Run(WorkState* state, size_t workers)
+        {
+            std::lock_guard<std::mutex> run(m_runLock);
+            {
+                std::unique_lock<std::mutex> guard(m_lock);
+                while ( m_threads.size() + 1 < workers )
+                {
+                    size_t self = m_threads.size() + 1;
+                    m_threads.push_back( std::thread(&WorkThreads::Loop, this, self, m_generation) );
+                    m_threads.back().detach();
+                }
+                m_state = state;
+                m_workers = workers;
+                m_pending = workers - 1;
+                ++m_generation;
+            }
+            m_wake.notify_all();
+
+            Work(state, 0);
+
+            std::unique_lock<std::mutex> guard(m_lock);
+            while ( m_pending != 0 )
+                m_done.wait(guard);
+            m_state = NULL;
+        }
+
+    private :
+        void Loop(size_t self, unsigned long seen)
+        {
+            t_inRun = true;
+            std::unique_lock<std::mutex> guard(m_lock);
+            for ( ;; )
+            {
+                while ( m_generation == seen )
+                    m_wake.wait(guard);
+                seen = m_generation;
+                if ( self >= m_workers )
+                    continue;
+
+                WorkState* state = m_state;
+                guard.unlock();
+                Work(state, self);
+                guard.lock();
+                if ( --m_pending == 0 )
+                    m_done.notify_one();
+            }
+        }
+
+        std::mutex m_runLock;
+        std::mutex m_lock;
+        std::condition_variable m_wake;
+        std::condition_variable m_done;
+        std::vector<std::thread> m_threads;
+        WorkState* m_state;
+        size_t m_workers;
+        size_t m_pending;
+        unsigned long m_generation;
+    };
+
+    /* never freed, the parked threads live until the process exits */
+    WorkThreads& Threads()
+    {
+        static WorkThreads* threads = new WorkThreads();
+        return *threads;
+    }
+}
+
+void XmlManagerWorkPool::Run(size_t count, const std::function<void(size_t)>& task, unsigned int threads)
+{
+    if ( count == 0 )
+        return;
+
+    size_t workers = Workers(threads);
+    if ( workers > count )
+        workers = count;
+
+    if ( workers <= 1 || t_inRun )
+    {
+        for ( size_t i = 0; i < count; ++i )
+            task(i);
+        return;
+    }
+
+    WorkState state(workers);
+    state.task = &task;
+
+    /* contiguous initial partition, the remainder goes to the first ranges */
+    size_t chunk = count / workers;
+    size_t extra = count % workers;
+    size_t pos = 0;
+    for ( size_t i = 0; i < workers; ++i )
+    {
+        state.ranges[i].begin = pos;
+        pos += chunk + ( i < extra ? 1 : 0 );
+        state.ranges[i].end = pos;
+    }
+
+    t_inRun = true;
+    try
+    {
+        Threads().Run(&state, workers);
+    }
+    catch (...)
+    {
+        t_inRun = false;
+        throw;
+    }
+    t_inRun = false;
+
+    if ( state.error )
+        std::rethrow_exception(state.error);
+}
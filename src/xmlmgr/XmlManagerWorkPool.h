@@ -0,0 +1,50 @@
+/**
+*			@file XmlManagerWorkPool.h
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*/
+
+#ifndef _XmlManagerWorkPool_h_
+#define _XmlManagerWorkPool_h_
+
+#include <functional>
+#include <cstddef>
+
+/**
+*		@class XmlManagerWorkPool
+*
+*		@brief Internal work-stealing scheduler used by the parallel operations of the XmlManager
+*
+*		Task indexes are split in contiguous ranges, one per worker. A worker consumes its own range
+*		from the front (document order) and, once it is exhausted, steals the back half of the
+*		largest remaining range. The calling thread takes part in the work.
+*
+*		The worker threads are started by the first run that needs them and wait for the next runs,
+*		runs from several threads take turns. A Run called from a task is sequential.
+*/
+class XmlManagerWorkPool
+{
+public :
+    /**
+    * @brief Runs task(i) for every i in [0,count) and returns once all tasks are done
+    *
+    *	@param count number of tasks
+    *	@param task the task to run, it is called concurrently from several threads
+    *	@param threads number of workers, 0 means the hardware concurrency
+    *
+    *	The first exception thrown by a task is rethrown in the calling thread.
+    */
+    static void Run(size_t count, const std::function<void(size_t)>& task, unsigned int threads = 0);
+
+    /**
+    * @brief Returns the number of workers that Run would use for the given request
+    */
+    static unsigned int Workers(unsigned int threads);
+};
+
+#endif
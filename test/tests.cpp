@@ -1,6 +1,43 @@
-
 #include "UnitTest++.h"
 
+#include <xmlmgr/XmlManagerBase.h>
+#include <xmlmgr/XmlManagerGenerator.h>
+#include <xmlmgr/XmlManagerOverlay.h>
+#include <xmlmgr/XmlManagerPushParser.h>
+#include "ngoerr/NgoError.h"
+
+#include <libxml/tree.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* user codec : a fraction stored as "num/den" */
+struct Fraction
+{
+   int num;
+   int den;
+};
+
+template <> struct xmCodec<Fraction>
+{
+   static bool Decode(const char* text, Fraction* value)
+   {
+      return sscanf(text, "%d/%d", &value->num, &value->den) == 2;
+   }
+   static const char* Encode(const Fraction& value, char* buffer)
+   {
+      snprintf(buffer, XM_CODEC_BUFFER_SIZE, "%d/%d", value.num, value.den);
+      return buffer;
+   }
+};
+
 namespace
 {
 
@@ -9,5 +46,1132 @@ TEST(FirstTest)
    bool nothing;
 }
 
+/* small helper document: a root node owned by a fresh xmlDoc */
+struct TestDoc
+{
+   xmlDoc* doc;
+   xmlNode* root;
+
+   TestDoc()
+   {
+      doc = XmlMgrNewDoc("1.0");
+      root = XmlMgrNewDocNode(doc, NULL, "root", NULL);
+      XmlMgrDocSetRootElement(doc, root);
+   }
+   ~TestDoc() { XmlMgrFreeDoc(doc); }
+};
+
+std::string ItemName(int i)
+{
+   std::stringstream s;
+   s << "item" << i;
+   return s.str();
+}
+
+struct OrderVisitor : public XmlManagerVisitor
+{
+   std::vector<unsigned int> depths;
+   bool Visit(const xmlNode* node, unsigned int depth) { depths.push_back(depth); return true; }
+};
+
+struct CountVisitor : public XmlManagerVisitor
+{
+   std::atomic<int> count;
+   CountVisitor() : count(0) {}
+   bool Visit(const xmlNode* node, unsigned int depth) { ++count; return true; }
+};
+
+struct NestedVisitor : public XmlManagerVisitor
+{
+   xmlNode* root;
+   CountVisitor inner;
+   NestedVisitor(xmlNode* r) : root(r) {}
+   bool Visit(const xmlNode* node, unsigned int depth)
+   {
+      if ( depth == 0 )
+         XmlManagerBase::Get()->VisitChildrens("items", root, inner, xmVisitParallel, 4);
+      return true;
+   }
+};
+
+TEST(VisitChildrens)
+{
+   XmlManagerBase* mgr = XmlManagerBase::Get();
+   TestDoc t;
+   for (int i = 0; i < 200; ++i)
+      mgr->Write("items/" + ItemName(i) + "/value", t.root, i);
+
+   OrderVisitor seq;
+   mgr->VisitChildrens("items", t.root, seq);
+   CHECK_EQUAL(400u, seq.depths.size());
+   CHECK_EQUAL(0u, seq.depths[0]);
+   CHECK_EQUAL(1u, seq.depths[1]);
+
+   CountVisitor par;
+   mgr->VisitChildrens("items", t.root, par, xmVisitParallel, 4);
+   CHECK_EQUAL(400, par.count.load());
+
+   // the worker threads are kept between runs, whatever the number asked
+   for (unsigned int threads = 2; threads < 6; ++threads)
+   {
+      CountVisitor again;
+      mgr->VisitChildrens("items", t.root, again, xmVisitParallel, threads);
+      CHECK_EQUAL(400, again.count.load());
+   }
+
+   // a parallel visit from a task runs in the calling task
+   NestedVisitor nested(t.root);
+   mgr->VisitChildrens("items", t.root, nested, xmVisitParallel, 4);
+   CHECK_EQUAL(200 * 400, nested.inner.count.load());
+}
+
+TEST(QueryStreams)
+{
+   XmlManagerBase* mgr = XmlManagerBase::Get();
+   TestDoc t;
+   for (int i = 0; i < 10; ++i)
+   {
+      mgr->Write("streams/" + ItemName(i) + "/flow", t.root, double(i));
+      mgr->WriteAttribute("streams/" + ItemName(i), t.root, "phase", std::string(i % 2 ? "vapor" : "liquid"), true);
+   }
+
+   XmlManagerQueryResult vapor = mgr->Query("streams/*[@phase='vapor']", t.root);
+   CHECK_EQUAL(5u, vapor.size());
+
+   double sum = 0.0;
+   for (XmlManagerQueryResult::const_iterator it = vapor.begin(); it != vapor.end(); ++it)
+      sum += mgr->ReadDouble("flow", *it);
+   CHECK_CLOSE(25.0, sum, 1e-9);
+
+   // second run goes through the compiled expression cache
+   CHECK_EQUAL(5u, mgr->Query("streams/*[@phase='vapor']", t.root).size());
+   CHECK(mgr->Query("streams/*[@phase='solid']", t.root).empty());
+}
+
+struct LookupVisitor : public XmlManagerVisitor
+{
+   xmlNode* root;
+   std::atomic<int> found;
+   LookupVisitor(xmlNode* r) : root(r), found(0) {}
+   bool Visit(const xmlNode* node, unsigned int depth)
+   {
+      xmlChar* name = xmlGetProp(node, (const xmlChar*) "name");
+      if ( name != NULL && XmlManagerBase::Get()->FindByAttribute("components", root, "name", (const char*) name) == node )
+         ++found;
+      xmlFree(name);
+      return true;
+   }
+};
+
+TEST(AttributeIndex)
+{
+   XmlManagerBase* mgr = XmlManagerBase::Get();
+   TestDoc t;
+   for (int i = 0; i < 50; ++i)
+      mgr->WriteAttribute("components/" + ItemName(i), t.root, "name", "c" + ItemName(i), true);
+
+   mgr->CreateAttributeIndex("components", t.root, "name");
+   xmlNode* n = mgr->FindByAttribute("components", t.root, "name", "citem7");
+   CHECK(n != NULL);
+
+   // renaming through WriteAttribute keeps the index in sync
+   mgr->WriteAttribute("components/item7", t.root, "name", std::string("methane"), true);
+   CHECK(mgr->FindByAttribute("components", t.root, "name", "citem7") == NULL);
+   CHECK(mgr->FindByAttribute("components", t.root, "name", "methane") == n);
+
+   // same answer without the index
+   mgr->DropAttributeIndex("components", t.root, "name");
+   CHECK(mgr->FindByAttribute("components", t.root, "name", "methane") == n);
+
+   mgr->CreateAttributeIndex("components", t.root, "name");
+
+   // indexed lookups from the workers of a parallel visit
+   LookupVisitor lookups(t.root);
+   mgr->VisitChildrens("components", t.root, lookups, xmVisitParallel, 4);
+   CHECK_EQUAL(50, lookups.found.load());
+
+   // a deleted child leaves the index
+   xmlNode* third = mgr->FindByAttribute("components", t.root, "name", "citem3");
+   mgr->DeleteNode(third);
+   CHECK(mgr->FindByAttribute("components", t.root, "name", "citem3") == NULL);
+
+   mgr->DeleteChildrens("components", t.root);
+   CHECK(mgr->FindByAttribute("components", t.root, "name", "methane") == NULL);
+
+   // the indexes of a freed document are dropped with it
+   {
+      TestDoc other;
+      mgr->WriteAttribute("components/item0", other.root, "name", std::string("water"), true);
+      mgr->CreateAttributeIndex("components", other.root, "name");
+      CHECK(mgr->FindByAttribute("components", other.root, "name", "water") != NULL);
+   }
+   TestDoc reused;
+   mgr->WriteAttribute("components/item0", reused.root, "name", std::string("steam"), true);
+   CHECK(mgr->FindByAttribute("components", reused.root, "name", "steam") != NULL);
+}
+
+std::string FileText(const char* filename)
+{
+   std::ifstream in(filename, std::ios::binary);
+   return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+TEST(BoundStructures)
+{
+   XmlManagerBase* mgr = XmlManagerBase::Get();
+   TestDoc t;
+
+   xmTemperaturePressureDensity tpd;
+   tpd.temperature.value = 300.0;
+   tpd.temperature.units = "K";
+   tpd.pressure.value = 1.0e5;
+   tpd.pressure.units = "Pa";
+   tpd.density.value = 1.2;
+   tpd.density.units = "kg/m3";
+   mgr->WriteStruct("feed/state", t.root, tpd);
+   CHECK_CLOSE(1.0e5, mgr->ReadDouble("feed/state/pressure/value", t.root), 1e-6);
+
+   xmTemperaturePressureDensity back;
+   CHECK(mgr->ReadStruct("feed/state", t.root, &back));
+   CHECK_CLOSE(300.0, back.temperature.value, 1e-9);
+   CHECK_EQUAL(std::string("kg/m3"), back.density.units);
+
+   // the texts are written as they are
+   tpd.density.units = "kg&m3";
+   mgr->WriteStruct("feed/state", t.root, tpd);
+   CHECK(mgr->ReadStruct("feed/state", t.root, &back));
+   CHECK_EQUAL(std::string("kg&m3"), back.density.units);
+
+   xmArrayElement water(2);
+   water[0].name = "H";
+   water[0].num_of_atoms = 2;
+   water[1].name = "O";
+   water[1].num_of_atoms = 1;
+   mgr->WriteStruct("water/elements", t.root, water);
+
+   // a shrinking vector is journaled once, as the whole structure
+   remove("bound_test.log");
+   mgr->OpenJournal(t.doc, "bound_test.log");
+   water.pop_back();
+   mgr->WriteStruct("water/elements", t.root, water);
+   mgr->CloseJournal(t.doc);
+   std::string journal = FileText("bound_test.log");
+   CHECK_EQUAL(0u, journal.find("clear\twater/elements\t"));
+   CHECK_EQUAL(std::string::npos, journal.find("clear", 1));
+   CHECK_EQUAL(std::string::npos, journal.find("delete"));
+   remove("bound_test.log");
+
+   xmArrayElement read;
+   CHECK(mgr->ReadStruct("water/elements", t.root, &read));
+   CHECK_EQUAL(1u, read.size());
+   CHECK_EQUAL(2, read[0].num_of_atoms);
+   CHECK(!mgr->ReadStruct("nothing", t.root, &read));
+}
+
+TEST(PathLiterals)
+{
+   XmlManagerBase* mgr = XmlManagerBase::Get();
+   TestDoc t;
+
+   static constexpr xmPath alpha = "/thermo//model/alpha"_xp;
+   static_assert(alpha.Count() == 3, "segments are collapsed at compile time");
+
+   mgr->Write(alpha, t.root, 0.5);
+   CHECK_CLOSE(0.5, mgr->ReadDouble("thermo/model/alpha", t.root), 1e-12);
+
+   mgr->Write("thermo/model.name", t.root, std::string("PR"));
+   std::string model;
+   CHECK(mgr->Read("thermo/model.name"_xp, t.root, &model));
+   CHECK_EQUAL(std::string("PR"), model);
+
+   int missing = 3;
+   CHECK(!mgr->Read("thermo/none"_xp, t.root, &missing));
+   CHECK_EQUAL(3, missing);
+   CHECK(mgr->GetNode(""_xp, t.root) == t.root);
+
+   // names are matched whole and created whole, whatever their length
+   CHECK(mgr->GetNode("thermo/model/alph"_xp, t.root) == NULL);
+   const std::string longName(300, 'n');
+   xmlNode* created = mgr->GetNode("thermo/nnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnnn"_xp, t.root, true);
+   CHECK(created != NULL);
+   CHECK_EQUAL(longName, std::string((const char*) created->name));
+}
+
+TEST(TypedAccessEngine)
+{
+   XmlManagerBase* mgr = XmlManagerBase::Get();
+   TestDoc t;
+
+   Fraction f = { 3, 4 };
+   mgr->WriteValue("ratio", t.root, f);
+   CHECK_EQUAL(std::string("3/4"), mgr->Read("ratio", t.root));
+
+   Fraction g = { 0, 0 };
+   CHECK(mgr->ReadValue("ratio", t.root, &g));
+   CHECK_EQUAL(4, g.den);
+
+   // the built-in codecs reject what they cannot hold
+   int i = 7;
+   CHECK(!xmCodec<int>::Decode("4294967296", &i));
+   CHECK_EQUAL(7, i);
+   CHECK(xmCodec<int>::Decode("-2147483648", &i));
+   CHECK_EQUAL(-2147483647 - 1, i);
+   bool b = false;
+   CHECK(!xmCodec<bool>::Decode("trueish", &b));
+   CHECK(!xmCodec<bool>::Decode("falsehood", &b));
+   CHECK(xmCodec<bool>::Decode(" true \n", &b));
+   CHECK(b);
+
+   std::vector<Fraction> fs(2, f);
+   mgr->WriteArray("ratios/ratio", t.root, fs);
+   std::vector<Fraction> back;
+   mgr->ReadArray("ratios/ratio", t.root, &back);
+   CHECK_EQUAL(2u, back.size());
+
+   mgr->WriteAttributeValue("ratio", t.root, "inverse", Fraction { 4, 3 });
+   CHECK(mgr->ReadAttributeValue("ratio", t.root, "inverse", &g));
+   CHECK_EQUAL(3, g.den);
+
+   // the historical overloads run through the same engine
+   std::vector<int> ints;
+   ints.push_back(1);
+   ints.push_back(2);
+   mgr->Write("list/v", t.root, ints);
+   mgr->Write("list/v", t.root, ints);
+   CHECK_EQUAL(2u, mgr->ReadStdArrayInt("list/v", t.root).size());
+   mgr->Write("flag", t.root, true);
+   CHECK(mgr->ReadBool("flag", t.root, false));
+   mgr->WriteAttribute("flag", t.root, "on", std::string("true"), true);
+   CHECK(mgr->ReadAttributeBool("flag", t.root, "on", false));
+   CHECK_EQUAL(7, mgr->ReadInt("missing", t.root, 7));
+}
+
+TEST(ChildIteration)
+{
+   XmlManagerBase* mgr = XmlManagerBase::Get();
+   TestDoc t;
+   for (int i = 0; i < 20; ++i)
+      mgr->Write("streams/" + ItemName(i) + "/flow", t.root, double(i));
+
+   double total = 0.0;
+   int count = 0;
+   for (XmlManagerChildIterator it = mgr->Children("streams", t.root).begin(); it != XmlManagerChildIterator(); ++it)
+   {
+      CHECK_EQUAL(ItemName(count), std::string(it.Name()));
+      total += mgr->ReadDouble("flow", *it);
+      ++count;
+   }
+   CHECK_EQUAL(20, count);
+   CHECK_CLOSE(190.0, total, 1e-9);
+
+   CHECK_EQUAL(20u, mgr->Children("streams"_xp, t.root).size());
+   CHECK(mgr->Children("nothing", t.root).empty());
+}
+
+TEST(LazyArrayRange)
+{
+   XmlManagerBase* mgr = XmlManagerBase::Get();
+   TestDoc t;
+   std::vector<double> values;
+   for (int i = 0; i < 1000; ++i)
+      values.push_back(i);
+   mgr->Write("profile/value", t.root, values);
+
+   // early termination
+   XmlManagerArrayRange<double> range = mgr->ReadArrayRange<double>("profile/value", t.root);
+   int seen = 0;
+   for (XmlManagerArrayRange<double>::const_iterator it = range.begin(); it != range.end(); ++it)
+      if (++seen == 10)
+         break;
+   CHECK_EQUAL(10, seen);
+
+   // chunked decoding into a fixed buffer
+   double buffer[64];
+   double sum = 0.0;
+   size_t n, chunks = 0;
+   while ((n = range.ReadChunk(buffer, 64)) > 0)
+   {
+      for (size_t i = 0; i < n; ++i)
+         sum += buffer[i];
+      ++chunks;
+   }
+   CHECK_EQUAL(16u, chunks);
+   CHECK_CLOSE(499500.0, sum, 1e-6);
+   CHECK(mgr->ReadArrayRange<int>("none/value", t.root).empty());
+}
+
+TEST(ArrayIntoBuffer)
+{
+   XmlManagerBase* mgr = XmlManagerBase::Get();
+   TestDoc t;
+   std::vector<int> values;
+   for (int i = 0; i < 100; ++i)
+      values.push_back(i);
+   mgr->Write("samples/s", t.root, values);
+
+   CHECK_EQUAL(100u, mgr->CountArray("samples/s", t.root));
+
+   int buffer[100];
+   size_t total = 0;
+   CHECK_EQUAL(100u, mgr->ReadArray("samples/s", t.root, buffer, 100, &total));
+   CHECK_EQUAL(100u, total);
+   CHECK_EQUAL(99, buffer[99]);
+
+   // truncated read through a path literal
+   int small[10];
+   CHECK_EQUAL(10u, mgr->ReadArray("samples/s"_xp, t.root, small, 10, &total));
+   CHECK_EQUAL(100u, total);
+   CHECK_EQUAL(9, small[9]);
+   CHECK_EQUAL(0u, mgr->ReadArray("none/s"_xp, t.root, small, 10, &total));
+   CHECK_EQUAL(0u, total);
+}
+
+TEST(ArrayRewriteInPlace)
+{
+   XmlManagerBase* mgr = XmlManagerBase::Get();
+   TestDoc t;
+   std::vector<double> values(8, 1.0);
+   mgr->Write("dump/x", t.root, values);
+   xmlNode* first = mgr->Children("dump", t.root).begin().Node();
+
+   // same length: the item nodes are reused
+   values[0] = 2.0;
+   mgr->Write("dump/x", t.root, values);
+   CHECK(mgr->Children("dump", t.root).begin().Node() == first);
+   CHECK_EQUAL(8u, mgr->CountArray("dump/x", t.root));
+   CHECK_CLOSE(2.0, mgr->ReadStdArrayDouble("dump/x", t.root)[0], 1e-12);
+
+   // shorter then longer
+   values.resize(3);
+   mgr->Write("dump/x", t.root, values);
+   CHECK_EQUAL(3u, mgr->CountArray("dump/x", t.root));
+   values.resize(5, 4.0);
+   mgr->Write("dump/x", t.root, values);
+   CHECK_EQUAL(5u, mgr->CountArray("dump/x", t.root));
+   CHECK_CLOSE(4.0, mgr->ReadStdArrayDouble("dump/x", t.root)[4], 1e-12);
+}
+
+TEST(NodeRecycling)
+{
+   XmlManagerBase* mgr = XmlManagerBase::Get();
+   TestDoc t;
+   for (int i = 0; i < 10; ++i)
+      mgr->Write("state/" + ItemName(i), t.root, i);
+
+   // nothing is kept until the recycling is enabled
+   mgr->DeleteChildrens("state", t.root);
+   CHECK_EQUAL(0u, mgr->GetNodePoolSize(t.doc));
+
+   mgr->SetNodePoolLimit(4096);
+   for (int i = 0; i < 10; ++i)
+      mgr->Write("state/" + ItemName(i), t.root, i);
+   mgr->DeleteChildrens("state", t.root);
+   CHECK_EQUAL(20u, mgr->GetNodePoolSize(t.doc));
+   mgr->GetNode("deep/er/path", t.root, true);
+   mgr->GetNode("deep/er/path/leaf"_xp, t.root, true);
+   CHECK_EQUAL(16u, mgr->GetNodePoolSize(t.doc));
+
+   // the next writes take their nodes from the pool
+   for (int i = 0; i < 10; ++i)
+      mgr->Write("state/" + ItemName(i), t.root, i * 2);
+   CHECK_EQUAL(0u, mgr->GetNodePoolSize(t.doc));
+   CHECK_EQUAL(18, mgr->ReadInt("state/item9", t.root, 0));
+
+   mgr->SetNodePoolLimit(5);
+   mgr->DeleteChildrens("state", t.root);
+   CHECK_EQUAL(5u, mgr->GetNodePoolSize(t.doc));
+   mgr->TrimNodePool(t.doc);
+   CHECK_EQUAL(0u, mgr->GetNodePoolSize(t.doc));
+   mgr->SetNodePoolLimit(XM_NODE_POOL_LIMIT);
+}
+
+TEST(LayeredOverlay)
+{
+   XmlManagerBase* mgr = XmlManagerBase::Get();
+   TestDoc defaults, site, user;
+   mgr->Write("solver/tolerance", defaults.root, 1e-6);
+   mgr->Write("solver/iterations", defaults.root, 100);
+   mgr->Write("solver/name", defaults.root, std::string("newton"));
+   mgr->Write("solver/iterations", site.root, 200);
+   mgr->Write("solver/tolerance", user.root, 1e-8);
+
+   XmlManagerOverlay overlay;
+   overlay.Push(defaults.root);
+   overlay.Push(site.root);
+   overlay.Push(user.root);
+
+   double tolerance = 0.0;
+   int iterations = 0;
+   CHECK(overlay.ReadValue("solver/tolerance", &tolerance));
+   CHECK_CLOSE(1e-8, tolerance, 1e-20);
+   CHECK(overlay.Read("solver/iterations"_xp, &iterations));
+   CHECK_EQUAL(200, iterations);
+   CHECK_EQUAL(std::string("newton"), overlay.Read("solver/name"));
+   CHECK(overlay.Find("solver/none") == NULL);
+
+   TestDoc flat;
+   overlay.Flatten(flat.root);
+   CHECK_CLOSE(1e-8, mgr->ReadDouble("solver/tolerance", flat.root), 1e-20);
+   CHECK_EQUAL(200, mgr->ReadInt("solver/iterations", flat.root, 0));
+   CHECK_EQUAL(std::string("newton"), mgr->Read("solver/name", flat.root));
+
+   // arrays are merged item by item, the longer layer adds its items
+   std::vector<int> weights(3, 1);
+   weights[1] = 2;
+   weights[2] = 3;
+   mgr->Write("solver/weights/v", defaults.root, weights);
+   mgr->Write("solver/weights/v", user.root, std::vector<int>(1, 7));
+   mgr->Write("solver/weights/v", site.root, std::vector<int>(4, 5));
+   TestDoc merged;
+   overlay.Flatten(merged.root);
+   std::vector<int> back = mgr->ReadStdArrayInt("solver/weights/v", merged.root);
+   CHECK_EQUAL(4u, back.size());
+   if ( back.size() == 4 )
+   {
+      CHECK_EQUAL(7, back[0]);
+      CHECK_EQUAL(5, back[1]);
+      CHECK_EQUAL(5, back[3]);
+   }
+
+   // the flattened tree is journaled once, not once per layer
+   mgr->WriteAttribute("solver", user.root, "kind", std::string("implicit"), true);
+   TestDoc journaled;
+   remove("overlay_test.log");
+   mgr->OpenJournal(journaled.doc, "overlay_test.log");
+   overlay.Flatten(journaled.root);
+   mgr->CloseJournal(journaled.doc);
+   std::string journal = FileText("overlay_test.log");
+   CHECK_EQUAL(0u, journal.find("clear\t"));
+   CHECK_EQUAL(std::string::npos, journal.find("clear\t", 1));
+   CHECK_EQUAL(std::string::npos, journal.find("attribute\t"));
+   remove("overlay_test.log");
+}
+
+TEST(DiffAndPatch)
+{
+   XmlManagerBase* mgr = XmlManagerBase::Get();
+   TestDoc before, after, live, wire;
+
+   mgr->Write("unit/feed/flow", before.root, 10.0);
+   mgr->Write("unit/feed/name", before.root, std::string("feed"));
+   mgr->Write("unit/old", before.root, 1);
+   mgr->WriteAttribute("unit", before.root, "kind", std::string("flash"), true);
+   std::vector<int> stages(3, 1);
+   mgr->Write("unit/stages/n", before.root, stages);
+   mgr->Merge(before.root, live.root);
+
+   mgr->Write("unit/feed/flow", after.root, 12.5);
+   mgr->Write("unit/feed/name", after.root, std::string("feed"));
+   mgr->WriteAttribute("unit", after.root, "kind", std::string("column"), true);
+   stages.push_back(2);
+   mgr->Write("unit/stages/n", after.root, stages);
+   mgr->Write("unit/new-key", after.root, std::string("added"));
+
+   xmChangeSet changes;
+   mgr->Diff(before.root, after.root, &changes);
+   CHECK_EQUAL(5u, changes.size());
+
+   // ship the changes through a document and apply them to the live tree
+   mgr->WriteChangeSet(changes, wire.root);
+   xmChangeSet received;
+   mgr->ReadChangeSet(wire.root, &received);
+   CHECK_EQUAL(changes.size(), received.size());
+   mgr->Patch(received, live.root);
+
+   xmChangeSet remaining;
+   mgr->Diff(live.root, after.root, &remaining);
+   CHECK_EQUAL(0u, remaining.size());
+   CHECK_CLOSE(12.5, mgr->ReadDouble("unit/feed/flow", live.root), 1e-12);
+   CHECK_EQUAL(4u, mgr->CountArray("unit/stages/n", live.root));
+   CHECK(mgr->GetNode("unit/old", live.root) == NULL);
+
+   // values are stored as they are, '&' is no entity reference
+   xmChangeSet company(1);
+   company[0].type = xmChangeSetValue;
+   company[0].path = "unit/feed/name";
+   company[0].value = "AT&T <co>";
+   mgr->Patch(company, live.root);
+   CHECK_EQUAL(company[0].value, mgr->Read("unit/feed/name", live.root));
+   mgr->Write("unit/vendor", after.root, std::string("R&D &amp; co"));
+   mgr->Merge(after.root, live.root);
+   CHECK_EQUAL(std::string("R&D &amp; co"), mgr->Read("unit/vendor", live.root));
+}
+
+struct CountListener : public XmlManagerListener
+{
+   int calls;
+   xmlNode* last;
+   CountListener() : calls(0), last(NULL) {}
+   void Changed(xmlNode* watched, xmlNode* changed) { ++calls; last = changed; }
+};
+
+TEST(ChangeSubscriptions)
+{
+   XmlManagerBase* mgr = XmlManagerBase::Get();
+   TestDoc t;
+   mgr->Write("plant/reactor/temperature", t.root, 300.0);
+   mgr->Write("plant/column/pressure", t.root, 1.0);
+
+   CountListener reactor;
+   std::atomic<bool> dirty(false);
+   size_t id = mgr->Subscribe("plant/reactor", t.root, &reactor);
+   mgr->Subscribe("plant", t.root, &dirty);
+
+   mgr->Write("plant/column/pressure", t.root, 2.0);
+   CHECK_EQUAL(0, reactor.calls);
+   CHECK(dirty.exchange(false));
+
+   mgr->Write("plant/reactor/temperature", t.root, 310.0);
+   mgr->WriteAttribute("plant/reactor", t.root, "state", std::string("on"), true);
+   std::vector<double> profile(3, 1.0);
+   mgr->Write("plant/reactor/profile/x", t.root, profile);
+   CHECK_EQUAL(3, reactor.calls);
+   CHECK(dirty.load());
+
+   // deleting the childrens notifies once
+   mgr->DeleteChildrens("plant/reactor", t.root);
+   CHECK_EQUAL(4, reactor.calls);
+
+   mgr->Unsubscribe(id);
+   mgr->Write("plant/reactor/temperature", t.root, 320.0);
+   CHECK_EQUAL(4, reactor.calls);
+
+   // a deleted watched node drops its subscription
+   CountListener column, pressure;
+   mgr->Subscribe("plant/column", t.root, &column);
+   mgr->Subscribe("plant/column/pressure", t.root, &pressure);
+   xmlNode* node = mgr->GetNode("plant/column", t.root);
+   mgr->DeleteNode(node);
+   CHECK_EQUAL(1, column.calls);
+   CHECK(column.last == node);
+   CHECK_EQUAL(1, pressure.calls);
+   mgr->Write("plant/column/pressure", t.root, 3.0);
+   CHECK_EQUAL(1, column.calls);
+   CHECK_EQUAL(1, pressure.calls);
+
+   // subscribing does not create the watched node
+   CountListener missing;
+   CHECK_THROW(mgr->Subscribe("plant/missing", t.root, &missing), NgoErrorInvalidArgument);
+   CHECK(mgr->GetNode("plant/missing", t.root) == NULL);
+
+   // structure writes and merges call the subscribers of the fields they rewrite
+   xmValueUnit q;
+   q.value = 1.0;
+   q.units = "bar";
+   mgr->WriteStruct("plant/pressure", t.root, q);
+   CountListener units;
+   mgr->Subscribe("plant/pressure/units", t.root, &units);
+   q.units = "Pa";
+   mgr->WriteStruct("plant/pressure", t.root, q);
+   CHECK_EQUAL(1, units.calls);
+   TestDoc layer;
+   mgr->Write("plant/pressure/units", layer.root, std::string("kPa"));
+   mgr->Merge(layer.root, t.root);
+   CHECK_EQUAL(2, units.calls);
+   CHECK_EQUAL(std::string("kPa"), mgr->Read("plant/pressure/units", t.root));
+}
+
+TEST(WriteJournal)
+{
+   XmlManagerBase* mgr = XmlManagerBase::Get();
+   const char* base = "journal_test.xml";
+   const char* journal = "journal_test.log";
+   remove(journal);
+
+   TestDoc t;
+   mgr->Write("state/temperature", t.root, 300.0);
+   mgr->Write("state/obsolete", t.root, 1);
+   mgr->Write("state/items/a", t.root, 1);
+   mgr->Write("state/items/b", t.root, 2);
+   CHECK(XmlMgrSaveFormatFileEnc(base, t.doc, "UTF-8", 1) > 0);
+
+   mgr->OpenJournal(t.doc, journal);
+   mgr->Write("state/temperature", t.root, 310.0);
+   mgr->WriteAttribute("state", t.root, "mode", std::string("run\ttab"), true);
+   std::vector<double> profile(4, 2.5);
+   mgr->Write("state/profile/x", t.root, profile);
+   mgr->DeleteNode(mgr->GetNode("state/obsolete", t.root));
+   mgr->DeleteChildrens("state/items", t.root);
+   mgr->Write("state/note", t.root, std::string("two\nlines"));
+   mgr->Write("state/vendor", t.root, std::string("AT&T"));
+   mgr->Write("state/empty/x", t.root, std::vector<double>());
+
+   xmlDoc* loaded = mgr->LoadJournaledDoc(base, journal);
+   CHECK(loaded != NULL);
+   xmChangeSet changes;
+   mgr->Diff(XmlMgrDocGetRootElement(loaded), t.root, &changes);
+   CHECK_EQUAL(0u, changes.size());
+   XmlMgrFreeDoc(loaded);
+
+   // compaction folds the journal into the base file while the writes go on
+   mgr->CompactJournal(t.doc, base);
+   mgr->Write("state/temperature", t.root, 320.0);
+   CHECK(mgr->WaitJournalCompaction(t.doc));
+   mgr->CloseJournal(t.doc);
+
+   loaded = mgr->LoadJournaledDoc(base, journal);
+   changes.clear();
+   mgr->Diff(XmlMgrDocGetRootElement(loaded), t.root, &changes);
+   CHECK_EQUAL(0u, changes.size());
+   CHECK_CLOSE(320.0, mgr->ReadDouble("state/temperature", XmlMgrDocGetRootElement(loaded)), 1e-9);
+   XmlMgrFreeDoc(loaded);
+
+   // concurrent compactions run one after the other and keep the nodes around the root
+   xmlAddPrevSibling(t.root, xmlNewDocComment(t.doc, (const xmlChar*) "kept"));
+   mgr->OpenJournal(t.doc, journal);
+   std::vector<std::thread> compactions;
+   for (int i = 0; i < 3; ++i)
+      compactions.push_back(std::thread([mgr, &t, base]() { mgr->CompactJournal(t.doc, base); }));
+   for (size_t i = 0; i < compactions.size(); ++i)
+      compactions[i].join();
+   CHECK(mgr->WaitJournalCompaction(t.doc));
+   mgr->CloseJournal(t.doc);
+   CHECK(FileText(base).find("<!--kept-->") != std::string::npos);
+   remove(journal);
+
+   // a write to the second of the same name siblings replays onto the second one
+   TestDoc r;
+   xmlNode* runs = mgr->GetNode("runs", r.root, true);
+   for ( int i = 0; i < 3; ++i )
+      xmlNewChild(runs, NULL, (const xmlChar*) "run", NULL);
+   CHECK(XmlMgrSaveFormatFileEnc(base, r.doc, "UTF-8", 0) > 0);
+   mgr->OpenJournal(r.doc, journal);
+   mgr->Write("flow", xmlNextElementSibling(xmlFirstElementChild(runs)), 7.0);
+   mgr->CloseJournal(r.doc);
+
+   loaded = mgr->LoadJournaledDoc(base, journal);
+   xmlNode* replayed = mgr->GetNode("runs", XmlMgrDocGetRootElement(loaded));
+   CHECK(replayed != NULL);
+   if ( replayed != NULL )
+   {
+      CHECK(mgr->GetNode("flow", xmlFirstElementChild(replayed)) == NULL);
+      CHECK_CLOSE(7.0, mgr->ReadDouble("flow", xmlNextElementSibling(xmlFirstElementChild(replayed))), 1e-9);
+   }
+   XmlMgrFreeDoc(loaded);
+
+   remove(base);
+   remove(journal);
+}
+
+TEST(AtomicSave)
+{
+   XmlManagerBase* mgr = XmlManagerBase::Get();
+   TestDoc a, b;
+   mgr->Write("value", a.root, 1);
+   mgr->Write("value", b.root, 2);
+
+   xmSaveResult result;
+   CHECK(mgr->SaveAtomic(a.doc, "atomic_a.xml", &result) > 0);
+   CHECK_EQUAL(1u, result.groupSize);
+   CHECK(result.totalTime >= result.writeTime);
+
+   // a batch shares one fsync round
+   std::vector<xmSaveJob> jobs(2);
+   jobs[0].doc = a.doc;
+   jobs[0].filename = "atomic_a.xml";
+   jobs[1].doc = b.doc;
+   jobs[1].filename = "atomic_b.xml";
+   CHECK(mgr->SaveAtomic(jobs));
+   CHECK_EQUAL(2u, jobs[1].result.groupSize);
+
+   // every job of a converted batch gets its own encoder
+   jobs.push_back(jobs[0]);
+   jobs[2].filename = "atomic_c.xml";
+   CHECK(mgr->SaveAtomic(jobs, "ISO-8859-15"));
+   for (size_t i = 0; i < jobs.size(); ++i)
+   {
+      CHECK(jobs[i].result.bytes > 0);
+      CHECK(FileText(jobs[i].filename.c_str()).find("ISO-8859-15") != std::string::npos);
+   }
+   remove("atomic_c.xml");
+
+   // an undefined document is rejected before anything is written
+   std::vector<xmSaveJob> invalid(2);
+   invalid[0].doc = a.doc;
+   invalid[0].filename = "atomic_d.xml";
+   invalid[1].filename = "atomic_e.xml";
+   CHECK_THROW(mgr->SaveAtomic(invalid), NgoErrorInvalidArgument);
+   CHECK(FileText("atomic_d.xml").empty());
+
+   // concurrent saves
+   std::vector<std::thread> threads;
+   for (int i = 0; i < 4; ++i)
+      threads.push_back(std::thread([mgr, &b, i]() { mgr->SaveAtomic(b.doc, "atomic_" + ItemName(i) + ".xml"); }));
+   for (size_t i = 0; i < threads.size(); ++i)
+      threads[i].join();
+
+   xmlDoc* back = XmlMgrParseFile("atomic_item3.xml");
+   CHECK(back != NULL);
+   CHECK_EQUAL(2, mgr->ReadInt("value", XmlMgrDocGetRootElement(back), 0));
+   XmlMgrFreeDoc(back);
+
+   // a failed save leaves nothing behind
+   CHECK_EQUAL(-1, mgr->SaveAtomic(a.doc, "no_such_dir/atomic.xml"));
+
+   remove("atomic_a.xml");
+   remove("atomic_b.xml");
+   for (int i = 0; i < 4; ++i)
+      remove(("atomic_" + ItemName(i) + ".xml").c_str());
+}
+
+TEST(HotPathStats)
+{
+   XmlManagerBase* mgr = XmlManagerBase::Get();
+   TestDoc t;
+   xmStats stats;
+
+   // nothing is counted while the counters are off
+   mgr->ResetStats();
+   mgr->Write("a/b/value", t.root, 1.5);
+   mgr->GetStats(&stats);
+   CHECK_EQUAL(0u, stats.calls[xmStatsWriteValue]);
+
+   mgr->EnableStats(true);
+   mgr->Write("a/c/value", t.root, 2.5);
+   CHECK_CLOSE(1.5, mgr->ReadDouble("a/b/value", t.root), 1e-12);
+   mgr->ReadAttribute("a/b/value", t.root, "unit");
+   std::thread other([mgr, &t]() { mgr->ReadInt("a/b/value", t.root); });
+   other.join();
+   mgr->EnableStats(false);
+
+   mgr->GetStats(&stats);
+   CHECK_EQUAL(1u, stats.calls[xmStatsWriteValue]);
+   CHECK_EQUAL(2u, stats.calls[xmStatsReadValue]);
+   CHECK_EQUAL(1u, stats.calls[xmStatsReadAttribute]);
+   CHECK(stats.threads >= 2u);
+   CHECK(stats.nodesCreated >= 2u);
+   CHECK(stats.scans > 0u && stats.scannedSiblings > 0u);
+
+   unsigned long long reads = 0;
+   for (size_t b = 0; b < XM_STATS_BUCKETS; ++b)
+      reads += stats.latency[xmStatsReadValue][b];
+   CHECK_EQUAL(2u, reads);
+   CHECK(XmlMgrStatsPercentile(stats.latency[xmStatsReadValue], 0.5) > 0u);
+   CHECK_EQUAL(std::string("read_value"), std::string(XmlMgrStatsCallName(xmStatsReadValue)));
+
+   mgr->ResetStats();
+   mgr->GetStats(&stats);
+   CHECK_EQUAL(0u, stats.calls[xmStatsReadValue]);
+   CHECK_EQUAL(0u, stats.scans);
+}
+
+TEST(TraceSpans)
+{
+   XmlManagerBase* mgr = XmlManagerBase::Get();
+   TestDoc t;
+   std::vector<double> values(100, 1.0);
+
+   mgr->ClearTrace();
+   mgr->Write("arrays/x", t.root, values);
+   std::stringstream off;
+   CHECK_EQUAL(0u, mgr->WriteTrace(off));
+
+   mgr->EnableTrace(true, 4);
+   for (int i = 0; i < 3; ++i)
+      mgr->Write("arrays/x", t.root, values);
+   std::thread other([mgr, &t]() { mgr->ReadStdArrayDouble("arrays/x", t.root); });
+   other.join();
+   {
+      XmlManagerTraceSpan span("TestSpan");
+   }
+   mgr->EnableTrace(false);
+
+   std::stringstream trace;
+   CHECK_EQUAL(5u, mgr->WriteTrace(trace));
+   std::string json = trace.str();
+   CHECK(json.find("\"traceEvents\"") != std::string::npos);
+   CHECK(json.find("\"name\":\"XmlManagerBase::WriteArray\"") != std::string::npos);
+   CHECK(json.find("\"name\":\"XmlManagerBase::ReadArray\"") != std::string::npos);
+   CHECK(json.find("\"name\":\"TestSpan\"") != std::string::npos);
+
+   mgr->ClearTrace();
+   std::stringstream cleared;
+   CHECK_EQUAL(0u, mgr->WriteTrace(cleared));
+}
+
+TEST(GeneratedDocuments)
+{
+   xmGeneratorOptions options = XmlMgrGeneratorDefaults(7);
+   options.depth = 3;
+   options.fanout = 6;
+   options.names = 4;
+   options.attributeDensity = 1.5;
+
+   TestDoc a, b, c;
+   xmGeneratorResult result;
+   XmlMgrGenerate(a.root, options, &result);
+   XmlMgrGenerate(b.root, options);
+   CHECK(result.elements > 0u && result.values > 0u);
+   CHECK(result.arrayItems > 0u && result.attributes > 0u);
+
+   // same seed, same document
+   xmChangeSet changes;
+   XmlManagerBase::Get()->Diff(a.root, b.root, &changes);
+   CHECK(changes.empty());
+
+   options.seed = 8;
+   XmlMgrGenerate(c.root, options);
+   XmlManagerBase::Get()->Diff(a.root, c.root, &changes);
+   CHECK(!changes.empty());
+
+   // the node budget is a hard limit
+   TestDoc d;
+   options.maxNodes = 50;
+   XmlMgrGenerate(d.root, options, &result);
+   CHECK(result.elements <= 50u);
+}
+
+TEST(LookupProfile)
+{
+   XmlManagerBase* mgr = XmlManagerBase::Get();
+   TestDoc t;
+   std::vector<int> items(100, 1);
+   mgr->Write("packed/item", t.root, items);
+   for (int i = 0; i < 100; ++i)
+   {
+      mgr->Write("wide/" + ItemName(i), t.root, i);
+      mgr->WriteAttribute("packed/item", t.root, "id", i);
+   }
+
+   mgr->ResetLookupProfile();
+   mgr->EnableLookupProfile(true, 16);
+   for (int i = 0; i < 10; ++i)
+      mgr->ReadInt("wide/" + ItemName(99), t.root);
+   mgr->ReadInt("packed/missing", t.root);
+   mgr->FindByAttribute("packed", t.root, "id", "42");
+   mgr->ReadInt("wide/" + ItemName(1), t.root);   // short scan, not recorded
+   mgr->EnableLookupProfile(false);
+   mgr->ReadInt("wide/" + ItemName(98), t.root);
+
+   std::vector<xmLookupProfile> profile = mgr->GetLookupProfile();
+   CHECK_EQUAL(3u, profile.size());
+   CHECK_EQUAL(std::string("/root/wide"), profile[0].parent);
+   CHECK_EQUAL(ItemName(99), profile[0].name);
+   CHECK_EQUAL(10u, profile[0].calls);
+   CHECK_EQUAL(1000u, profile[0].scannedSiblings);
+   CHECK_EQUAL(xmAdviceChildIndex, profile[0].advice);
+
+   for (size_t i = 1; i < profile.size(); ++i)
+   {
+      if (profile[i].name == "missing")
+      {
+         CHECK_EQUAL(1u, profile[i].misses);
+         CHECK_EQUAL(xmAdvicePackedArray, profile[i].advice);
+      }
+      else
+      {
+         CHECK_EQUAL(std::string("@id"), profile[i].name);
+         CHECK_EQUAL(xmAdviceAttributeIndex, profile[i].advice);
+      }
+   }
+
+   std::stringstream report;
+   mgr->WriteLookupReport(report, 1);
+   CHECK(report.str().find("/root/wide") != std::string::npos);
+   CHECK(report.str().find("missing") == std::string::npos);
+
+   mgr->ResetLookupProfile();
+   CHECK(mgr->GetLookupProfile().empty());
+}
+
+struct RecordCounter : public XmlManagerPushHandler
+{
+   int kept;
+   int seen;
+   RecordCounter() : kept(0), seen(0) {}
+   bool SubtreeParsed(xmlNode* subtree)
+   {
+      ++seen;
+      // the subtree is complete when it is handed over, keep the even records
+      if (XmlManagerBase::Get()->ReadInt("value", subtree, -1) % 2 != 0)
+         return false;
+      ++kept;
+      return true;
+   }
+};
+
+TEST(PushParser)
+{
+   std::string xml = "<?xml version=\"1.0\"?>\n<root>";
+   for (int i = 0; i < 50; ++i)
+      xml += "<record id=\"" + ItemName(i) + "\"><value>" + std::to_string(i) + "</value><text>a&amp;b</text></record>";
+   xml += "</root>";
+
+   // fed in small chunks, records are handed over while parsing
+   RecordCounter counter;
+   XmlManagerPushParser parser(&counter);
+   for (size_t i = 0; i < xml.size(); i += 7)
+      CHECK(parser.Push(xml.data() + i, std::min<size_t>(7, xml.size() - i)));
+   CHECK_EQUAL(50, counter.seen);
+   xmlDoc* doc = parser.Finish();
+   CHECK(doc != NULL);
+   CHECK_EQUAL(25u, XmlManagerBase::Get()->EnumerateChildrens("", XmlMgrDocGetRootElement(doc)).size());
+   CHECK_EQUAL(std::string("a&b"), XmlManagerBase::Get()->Read("record/text", XmlMgrDocGetRootElement(doc)));
+   XmlMgrFreeDoc(doc);
+
+   // without handler, from a stream
+   std::stringstream in(xml);
+   XmlManagerPushParser whole;
+   CHECK(whole.PushStream(in, 64));
+   doc = whole.Finish();
+   CHECK(doc != NULL);
+   CHECK_EQUAL(50u, XmlManagerBase::Get()->EnumerateChildrens("", XmlMgrDocGetRootElement(doc)).size());
+   XmlMgrFreeDoc(doc);
+
+   // malformed documents report an error
+   XmlManagerPushParser broken;
+   std::string bad = "<root><a></b></root>";
+   broken.Push(bad.data(), bad.size());
+   CHECK(broken.Finish() == NULL);
+   CHECK(!broken.GetError().empty());
+}
+
+int AppendChunk(void* context, const char* data, int len)
+{
+   ((std::string*) context)->append(data, len);
+   return len;
+}
+
+int FailChunk(void*, const char*, int)
+{
+   return -1;
+}
+
+TEST(SaveTargets)
+{
+   XmlManagerBase* mgr = XmlManagerBase::Get();
+   TestDoc t;
+   mgr->Write("name", t.root, std::string("caf\xc3\xa9 <tea>"));
+   mgr->WriteAttribute("name", t.root, "unit", 3);
+
+   // the reference is the file save
+   CHECK(XmlMgrSaveFormatFileEnc("targets.xml", t.doc, "UTF-8", 1) > 0);
+   std::ifstream file("targets.xml");
+   std::string expected((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+   file.close();
+   remove("targets.xml");
+
+   std::string buffer;
+   CHECK_EQUAL((int) expected.size(), XmlMgrSaveToBuffer(t.doc, &buffer));
+   CHECK(buffer == expected);
+
+   // the buffer is reused
+   const char* data = buffer.data();
+   CHECK_EQUAL((int) expected.size(), XmlMgrSaveToBuffer(t.doc, &buffer));
+   CHECK(buffer.data() == data);
+   CHECK(buffer == expected);
+
+   std::string chunks;
+   CHECK_EQUAL((int) expected.size(), XmlMgrSaveToIO(t.doc, AppendChunk, &chunks));
+   CHECK(chunks == expected);
+   CHECK_EQUAL(-1, XmlMgrSaveToIO(t.doc, FailChunk, NULL));
+
+   FILE* out = fopen("targets_fd.xml", "wb");
+   CHECK_EQUAL((int) expected.size(), XmlMgrSaveToFd(t.doc, fileno(out)));
+   fclose(out);
+   std::ifstream back("targets_fd.xml");
+   std::string written((std::istreambuf_iterator<char>(back)), std::istreambuf_iterator<char>());
+   back.close();
+   CHECK(written == expected);
+   remove("targets_fd.xml");
+
+   // other encodings go through the converter
+   std::string latin;
+   CHECK(XmlMgrSaveToBuffer(t.doc, &latin, "ISO-8859-1") > 0);
+   CHECK(latin.find("caf\xe9") != std::string::npos);
+}
+
+TEST(ParallelSave)
+{
+   xmGeneratorOptions options = XmlMgrGeneratorDefaults(11);
+   options.depth = 3;
+   options.fanout = 40;
+   options.attributeDensity = 1.0;
+
+   TestDoc t;
+   XmlMgrGenerate(t.root, options);
+   XmlManagerBase::Get()->Write("notes", t.root, std::string("caf\xc3\xa9 <tea>"));
+   xmlAddChild(t.root, xmlNewDocComment(t.doc, (const xmlChar*) " trailing "));
+   xmlAddPrevSibling(t.root, xmlNewDocComment(t.doc, (const xmlChar*) " prolog "));
+
+   for (int format = 0; format < 2; ++format)
+   {
+      CHECK(XmlMgrSaveFormatFileEnc("sequential.xml", t.doc, "UTF-8", format) > 0);
+      int bytes = XmlMgrSaveParallelFileEnc("parallel.xml", t.doc, "UTF-8", format, 4);
+      std::string expected = FileText("sequential.xml");
+      CHECK_EQUAL((int) expected.size(), bytes);
+      CHECK(FileText("parallel.xml") == expected);
+   }
+
+   // small documents and other encodings take the sequential path
+   TestDoc small;
+   XmlManagerBase::Get()->Write("value", small.root, 1);
+   CHECK(XmlMgrSaveParallelFileEnc("parallel.xml", small.doc, "UTF-8", 1, 4) > 0);
+   CHECK(XmlMgrSaveFormatFileEnc("sequential.xml", small.doc, "UTF-8", 1) > 0);
+   CHECK(FileText("parallel.xml") == FileText("sequential.xml"));
+   CHECK(XmlMgrSaveParallelFileEnc("parallel.xml", t.doc, "ISO-8859-1", 1, 4) > 0);
+   CHECK(XmlMgrSaveFormatFileEnc("sequential.xml", t.doc, "ISO-8859-1", 1) > 0);
+   CHECK(FileText("parallel.xml") == FileText("sequential.xml"));
+
+   remove("sequential.xml");
+   remove("parallel.xml");
+}
+
+TEST(ParallelParse)
+{
+   xmGeneratorOptions options = XmlMgrGeneratorDefaults(13);
+   options.depth = 3;
+   options.fanout = 40;
+   options.attributeDensity = 1.0;
+
+   TestDoc t;
+   XmlMgrGenerate(t.root, options);
+   xmlNs* ns = xmlNewNs(t.root, (const xmlChar*) "urn:xmlmgr:test", (const xmlChar*) "t");
+   xmlNode* item = xmlNewTextChild(t.root, ns, (const xmlChar*) "item", (const xmlChar*) "caf\xc3\xa9 & <tea>");
+   xmlSetProp(item, (const xmlChar*) "xml:id", (const xmlChar*) "last");
+   xmlAddChild(t.root, xmlNewDocComment(t.doc, (const xmlChar*) " trailing "));
+   xmlAddNextSibling(t.root, xmlNewDocComment(t.doc, (const xmlChar*) " epilog "));
+   CHECK(XmlMgrSaveFormatFileEnc("parse.xml", t.doc, "UTF-8", 1) > 0);
+
+   xmlDoc* sequential = XmlMgrParseFile("parse.xml");
+   xmlDoc* parallel = XmlMgrParseFileParallel("parse.xml", 4);
+   CHECK(sequential != NULL && parallel != NULL);
+   std::string expected, actual;
+   XmlMgrSaveToBuffer(sequential, &expected);
+   XmlMgrSaveToBuffer(parallel, &actual);
+   CHECK(actual == expected);
+
+   // the grafted nodes belong to the document, with the lines of the file
+   xmlNode* last = xmlLastElementChild(xmlDocGetRootElement(parallel));
+   CHECK(last->doc == parallel);
+   CHECK(last->ns != NULL && last->ns == xmlDocGetRootElement(parallel)->nsDef);
+   CHECK_EQUAL(xmlLastElementChild(xmlDocGetRootElement(sequential))->line, last->line);
+   CHECK_EQUAL(xmlDocGetRootElement(sequential)->next->line, xmlDocGetRootElement(parallel)->next->line);
+   xmlAttr* id = xmlGetID(parallel, (const xmlChar*) "last");
+   CHECK(id != NULL && id->parent == last);
+   XmlMgrFreeDoc(parallel);
+
+   std::string text = FileText("parse.xml");
+   parallel = XmlMgrParseMemoryParallel(text.data(), text.size(), "parse.xml", 4);
+   actual.clear();
+   XmlMgrSaveToBuffer(parallel, &actual);
+   CHECK(actual == expected);
+   XmlMgrFreeDoc(parallel);
+   XmlMgrFreeDoc(sequential);
+
+   // a malformed slice gives no document
+   text.replace(text.rfind("<t:item"), 7, "<t:itm");
+   CHECK(XmlMgrParseMemoryParallel(text.data(), text.size(), NULL, 4) == NULL);
+
+   // other encodings take the sequential path
+   CHECK(XmlMgrSaveFormatFileEnc("parse.xml", t.doc, "ISO-8859-1", 1) > 0);
+   sequential = XmlMgrParseFile("parse.xml");
+   parallel = XmlMgrParseFileParallel("parse.xml", 4);
+   CHECK(parallel != NULL && xmlStrEqual(parallel->encoding, sequential->encoding));
+   XmlMgrFreeDoc(parallel);
+   XmlMgrFreeDoc(sequential);
+
+   remove("parse.xml");
+}
+
 } // end of anonymous namespace
-    
\ No newline at end of file
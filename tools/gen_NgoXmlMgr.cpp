@@ -0,0 +1,124 @@
+/**
+*			@file gen_NgoXmlMgr.cpp
+*
+*			@author Nicolas Macherey (nm@graymat.fr)
+*			@date 31-Janv-2009
+*			@version 0.0.1
+*
+*			This file is owned by Nicolas Macherey and Cedric Roman and cannot be used by any ohter
+*			third party without the written consent of one of the two authors
+*
+*			Writes a synthetic document built by XmlMgrGenerate, the same arguments always give the
+*			same file :
+*			@code
+*			gen_NgoXmlMgr --seed 42 --depth 4 --fanout 30 --out big.xml
+*			@endcode
+*/
+
+#include <xmlmgr/XmlManagerBase.h>
+#include <xmlmgr/XmlManagerGenerator.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace
+{
+
+void Usage(const char* program)
+{
+    fprintf( stderr ,
+             "usage: %s [options] --out file.xml\n"
+             "  --seed n            seed of the document (0)\n"
+             "  --depth n           levels below the root (3)\n"
+             "  --fanout n          mean childrens per node (8)\n"
+             "  --spread x          fanout spread in [0, 1] (0.5)\n"
+             "  --arrays n          arrays per node above the values (1)\n"
+             "  --array-length n    items per array (16)\n"
+             "  --attributes x      mean attributes per node (0.5)\n"
+             "  --names n           size of the name vocabulary (64)\n"
+             "  --max-nodes n       stop creating nodes beyond n (no limit)\n"
+             "  --no-format         do not indent the output\n" , program );
+}
+
+} // end of anonymous namespace
+
+int main(int argc, char** argv)
+{
+    xmGeneratorOptions options = XmlMgrGeneratorDefaults( 0 );
+    std::string out;
+    int format = 1;
+
+    for ( int i = 1; i < argc; ++i )
+    {
+        const char* arg = argv[i];
+        if ( strcmp( arg , "--no-format" ) == 0 )
+        {
+            format = 0;
+            continue;
+        }
+        if ( i + 1 >= argc )
+        {
+            Usage( argv[0] );
+            return 1;
+        }
+
+        const char* value = argv[++i];
+        if ( strcmp( arg , "--out" ) == 0 )
+            out = value;
+        else if ( strcmp( arg , "--seed" ) == 0 )
+            options.seed = strtoull( value , NULL , 10 );
+        else if ( strcmp( arg , "--depth" ) == 0 )
+            options.depth = (unsigned int) strtoul( value , NULL , 10 );
+        else if ( strcmp( arg , "--fanout" ) == 0 )
+            options.fanout = (unsigned int) strtoul( value , NULL , 10 );
+        else if ( strcmp( arg , "--spread" ) == 0 )
+            options.fanoutSpread = strtod( value , NULL );
+        else if ( strcmp( arg , "--arrays" ) == 0 )
+            options.arrays = (unsigned int) strtoul( value , NULL , 10 );
+        else if ( strcmp( arg , "--array-length" ) == 0 )
+            options.arrayLength = (unsigned int) strtoul( value , NULL , 10 );
+        else if ( strcmp( arg , "--attributes" ) == 0 )
+            options.attributeDensity = strtod( value , NULL );
+        else if ( strcmp( arg , "--names" ) == 0 )
+            options.names = (unsigned int) strtoul( value , NULL , 10 );
+        else if ( strcmp( arg , "--max-nodes" ) == 0 )
+            options.maxNodes = (size_t) strtoull( value , NULL , 10 );
+        else
+        {
+            Usage( argv[0] );
+            return 1;
+        }
+    }
+
+    if ( out.empty() || options.depth == 0 )
+    {
+        Usage( argv[0] );
+        return 1;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    xmlDoc* doc = XmlMgrNewDoc("1.0");
+    xmlNode* root = XmlMgrNewDocNode(doc, NULL, "root", NULL);
+    XmlMgrDocSetRootElement(doc, root);
+
+    xmGeneratorResult result;
+    XmlMgrGenerate( root , options , &result );
+    double built = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+    int bytes = XmlMgrSaveFormatFileEnc( out.c_str() , doc , "UTF-8" , format );
+    XmlMgrFreeDoc( doc );
+    if ( bytes < 0 )
+    {
+        fprintf( stderr , "cannot write %s\n" , out.c_str() );
+        return 1;
+    }
+
+    fprintf( stderr , "%s: %lu elements, %lu values, %lu array items, %lu attributes, %d bytes, built in %.3f s\n" ,
+             out.c_str() , (unsigned long) result.elements , (unsigned long) result.values ,
+             (unsigned long) result.arrayItems , (unsigned long) result.attributes , bytes , built );
+    return 0;
+}